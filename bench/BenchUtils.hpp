@@ -0,0 +1,25 @@
+#ifndef PTM_BENCHUTILS_HPP_
+#define PTM_BENCHUTILS_HPP_
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace ptm::bench {
+
+// Время выполнения fn в секундах
+template <typename F>
+double MeasureSeconds(F&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto finish = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(finish - start).count();
+}
+
+inline void Report(const std::string& name, double items, double seconds, const char* unit) {
+  std::printf("%-48s %10.3f s %14.3e %s/s\n", name.c_str(), seconds, items / seconds, unit);
+}
+
+} // namespace ptm::bench
+
+#endif // PTM_BENCHUTILS_HPP_
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench/BenchUtils.hpp"
+#include "lib/distributions/BatchKernels.hpp"
+#include "lib/distributions/CauchyDistribution.hpp"
+#include "lib/distributions/EmpiricalDistribution.hpp"
+#include "lib/distributions/ExponentialDistribution.hpp"
+#include "lib/distributions/LaplaceDistribution.hpp"
+#include "lib/distributions/NormalDistribution.hpp"
+#include "lib/distributions/UniformDistribution.hpp"
+#include "lib/random/Pcg64.hpp"
+#include "lib/random/Philox4x32.hpp"
+#include "lib/random/Xoshiro256PlusPlus.hpp"
+
+namespace {
+
+constexpr std::size_t kSamples = 20'000'000;
+
+template <typename Engine = std::mt19937>
+void BenchSampleN(const std::string& name, const ptm::Distribution& dist) {
+  Engine rng(42);
+  std::vector<double> out(kSamples);
+
+  const double seconds = ptm::bench::MeasureSeconds([&] { dist.SampleN(out, rng); });
+  ptm::bench::Report(name, static_cast<double>(kSamples), seconds, "samples");
+}
+
+void BenchZiggurat() {
+  using namespace ptm;
+
+  std::printf("== Normal / Exponential: SampleN, %zu samples\n", kSamples);
+  BenchSampleN("Normal Box-Muller", NormalDistribution(0.0, 1.0, NormalDistribution::Method::BoxMuller));
+  BenchSampleN("Normal Ziggurat", NormalDistribution(0.0, 1.0, NormalDistribution::Method::Ziggurat));
+  BenchSampleN("Exponential Inversion",
+               ExponentialDistribution(1.0, ExponentialDistribution::Method::Inversion));
+  BenchSampleN("Exponential Ziggurat", ExponentialDistribution(1.0, ExponentialDistribution::Method::Ziggurat));
+}
+
+void BenchEngines() {
+  using namespace ptm;
+
+  const NormalDistribution zig(0.0, 1.0, NormalDistribution::Method::Ziggurat);
+  const ExponentialDistribution exp_inv(1.0);
+
+  std::printf("== Engines: Normal Ziggurat / Exponential Inversion SampleN, %zu samples\n", kSamples);
+  BenchSampleN<std::mt19937>("Normal Ziggurat, std::mt19937", zig);
+  BenchSampleN<std::mt19937_64>("Normal Ziggurat, std::mt19937_64", zig);
+  BenchSampleN<Xoshiro256PlusPlus>("Normal Ziggurat, Xoshiro256PlusPlus", zig);
+  BenchSampleN<Pcg64>("Normal Ziggurat, Pcg64", zig);
+  BenchSampleN<Philox4x32>("Normal Ziggurat, Philox4x32", zig);
+  BenchSampleN<std::mt19937>("Exponential Inversion, std::mt19937", exp_inv);
+  BenchSampleN<Xoshiro256PlusPlus>("Exponential Inversion, Xoshiro256PlusPlus", exp_inv);
+}
+
+void BenchEmpiricalCdf() {
+  using namespace ptm;
+
+  constexpr std::size_t kGridSize = 10'000;
+  std::vector<double> sample(kSamples);
+  std::mt19937 rng(42);
+  NormalDistribution(0.0, 1.0).SampleN(sample, rng);
+
+  std::vector<double> grid(kGridSize);
+  for (std::size_t i = 0; i < kGridSize; ++i) {
+    grid[i] = -5.0 + 10.0 * static_cast<double>(i) / kGridSize;
+  }
+
+  std::printf("== EmpiricalDistribution: %zu samples, grid of %zu points\n", kSamples, kGridSize);
+  std::vector<double> copy = sample;
+  double seconds = ptm::bench::MeasureSeconds([&] { std::sort(copy.begin(), copy.end()); });
+  ptm::bench::Report("std::sort", static_cast<double>(kSamples), seconds, "samples");
+
+  copy = sample;
+  seconds = ptm::bench::MeasureSeconds([&] { SortSample(copy); });
+  ptm::bench::Report("SortSample (radix)", static_cast<double>(kSamples), seconds, "samples");
+
+  std::vector<double> cdf;
+  seconds = ptm::bench::MeasureSeconds([&] { cdf = EmpiricalDistribution(sample).CdfOnGrid(grid); });
+  ptm::bench::Report("build + CdfOnGrid", static_cast<double>(kSamples), seconds, "samples");
+}
+
+// Поточечные виртуальные вызовы через базовый класс против пакетных PdfN/LogPdfN/CdfN
+void BenchBatchEvaluation(const std::string& name, const ptm::Distribution& dist, const std::vector<double>& grid) {
+  std::vector<double> out(grid.size());
+  const auto points = static_cast<double>(grid.size());
+
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      out[i] = dist.Pdf(grid[i]);
+    }
+  });
+  ptm::bench::Report(name + " Pdf (scalar)", points, seconds, "points");
+  seconds = ptm::bench::MeasureSeconds([&] { dist.PdfN(grid, out); });
+  ptm::bench::Report(name + " PdfN", points, seconds, "points");
+
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      out[i] = dist.LogPdf(grid[i]);
+    }
+  });
+  ptm::bench::Report(name + " LogPdf (scalar)", points, seconds, "points");
+  seconds = ptm::bench::MeasureSeconds([&] { dist.LogPdfN(grid, out); });
+  ptm::bench::Report(name + " LogPdfN", points, seconds, "points");
+
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      out[i] = dist.Cdf(grid[i]);
+    }
+  });
+  ptm::bench::Report(name + " Cdf (scalar)", points, seconds, "points");
+  seconds = ptm::bench::MeasureSeconds([&] { dist.CdfN(grid, out); });
+  ptm::bench::Report(name + " CdfN", points, seconds, "points");
+}
+
+void BenchBatchEvaluation() {
+  using namespace ptm;
+
+  constexpr std::size_t kGridSize = 10'000'000;
+  std::vector<double> grid(kGridSize);
+  for (std::size_t i = 0; i < kGridSize; ++i) {
+    grid[i] = -10.0 + 20.0 * static_cast<double>(i) / kGridSize;
+  }
+
+  std::printf("== Batch Pdf/LogPdf/Cdf: grid of %zu points, kernels: %s\n", kGridSize, BatchKernelIsa());
+  BenchBatchEvaluation("Normal", NormalDistribution(0.0, 1.0), grid);
+  BenchBatchEvaluation("Exponential", ExponentialDistribution(1.0), grid);
+  BenchBatchEvaluation("Laplace", LaplaceDistribution(0.0, 1.0), grid);
+  BenchBatchEvaluation("Uniform", UniformDistribution(-1.0, 1.0), grid);
+  BenchBatchEvaluation("Cauchy", CauchyDistribution(0.0, 1.0), grid);
+}
+
+} // namespace
+
+int main() {
+  BenchZiggurat();
+  BenchEngines();
+  BenchEmpiricalCdf();
+  BenchBatchEvaluation();
+  return 0;
+}
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bench/BenchUtils.hpp"
+#include "lib/markov-chain/ChainAnalysis.hpp"
+#include "lib/markov-chain/MarkovSnapshot.hpp"
+#include "lib/markov-chain/MarkovTextModel.hpp"
+#include "lib/markov-chain/NGramModel.hpp"
+#include "lib/parallel/ParallelFor.hpp"
+
+// Счётчик выделений памяти всего процесса - для проверки, что генерация в буфер ничего не выделяет
+static std::atomic<std::size_t> g_allocations{0};
+
+// Замены не встраиваются: увидев malloc из встроенного operator new рядом с operator delete (или
+// free рядом с operator new), GCC принимает это за несовпадение пары (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define PTM_NOINLINE __attribute__((noinline))
+#else
+#define PTM_NOINLINE
+#endif
+
+// Скалярные и массивные формы заменены вместе: все выделяют через malloc и освобождают через free
+PTM_NOINLINE void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+PTM_NOINLINE void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+PTM_NOINLINE void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+PTM_NOINLINE void operator delete(void* p, std::size_t /*size*/) noexcept {
+  std::free(p);
+}
+
+PTM_NOINLINE void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+PTM_NOINLINE void operator delete[](void* p, std::size_t /*size*/) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+constexpr std::size_t kTokens = 200'000;
+
+std::string ReadCorpus() {
+  std::ifstream in(PTM_CORPUS_PATH);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  return buffer.str();
+}
+
+// Прежняя схема: на каждый токен - std::discrete_distribution по плотной строке длины |V|
+std::size_t GenerateWithDiscreteDistribution(const std::vector<std::vector<std::pair<std::size_t, double>>>& rows,
+                                             std::size_t start, std::size_t length, std::mt19937& rng) {
+  std::vector<double> dense(rows.size());
+  std::size_t cur = start;
+  std::size_t produced = 1;
+  while (produced < length && !rows[cur].empty()) {
+    std::fill(dense.begin(), dense.end(), 0.0);
+    for (const auto& [j, p] : rows[cur]) {
+      dense[j] = p;
+    }
+    std::discrete_distribution<std::size_t> dist(dense.begin(), dense.end());
+    cur = dist(rng);
+    ++produced;
+  }
+  return produced;
+}
+
+void BenchSampling(const ptm::MarkovTextModel& model, const char* level) {
+  const ptm::MarkovChain& chain = model.Chain();
+  const auto states = chain.States();
+
+  std::unordered_map<std::string, std::size_t> index;
+  for (std::size_t i = 0; i < states.size(); ++i) {
+    index.emplace(states[i], i);
+  }
+  std::vector<std::vector<std::pair<std::size_t, double>>> rows(states.size());
+  for (std::size_t i = 0; i < states.size(); ++i) {
+    for (const auto& [next, p] : chain.NextDistribution(states[i])) {
+      rows[i].emplace_back(index.at(next), p);
+    }
+  }
+
+  std::printf("== %s level, |V| = %zu\n", level, states.size());
+
+  // Прежний способ медленный - меряем на меньшем числе токенов
+  const std::size_t legacy_tokens = std::max<std::size_t>(2'000'000 / states.size(), 100);
+  std::mt19937 legacy_rng(1);
+  std::size_t produced = 0;
+  double seconds = ptm::bench::MeasureSeconds(
+      [&] { produced = GenerateWithDiscreteDistribution(rows, 0, legacy_tokens, legacy_rng); });
+  ptm::bench::Report("discrete_distribution per token", static_cast<double>(produced), seconds, "tokens");
+
+  std::mt19937 rng(1);
+  chain.Generate(states.front(), 2, rng); // построение таблиц не входит в замер
+  std::vector<std::string> out;
+  seconds = ptm::bench::MeasureSeconds([&] { out = chain.Generate(states.front(), kTokens, rng); });
+  ptm::bench::Report("alias table Generate", static_cast<double>(out.size()), seconds, "tokens");
+}
+
+// Прежнее хранение: плотная матрица |V| x |V|, новый токен дописывает столбец в каждую строку
+std::size_t TrainDense(const std::vector<std::string>& tokens) {
+  std::unordered_map<std::string, std::size_t> index;
+  std::vector<std::vector<std::size_t>> counts;
+  auto ensure = [&](const std::string& s) {
+    const auto [it, inserted] = index.emplace(s, counts.size());
+    if (inserted) {
+      for (auto& row : counts) {
+        row.push_back(0);
+      }
+      counts.emplace_back(counts.size() + 1, 0);
+    }
+    return it->second;
+  };
+  for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+    const std::size_t from = ensure(tokens[i]);
+    const std::size_t to = ensure(tokens[i + 1]);
+    ++counts[from][to];
+  }
+  return counts.size() * counts.size() * sizeof(std::size_t);
+}
+
+// Токены для прежнего плотного обучения: символы как есть, слова - просто по пробелам.
+// Словарь чуть больше, чем у MarkovTextModel, но для оценки времени и памяти этого достаточно
+std::vector<std::string> SplitTokens(const std::string& text, ptm::MarkovTextModel::TokenLevel level) {
+  std::vector<std::string> tokens;
+  if (level == ptm::MarkovTextModel::TokenLevel::Character) {
+    for (char c : text) {
+      tokens.emplace_back(1, c);
+    }
+    return tokens;
+  }
+  std::istringstream in(text);
+  std::string word;
+  while (in >> word) {
+    tokens.push_back(word);
+  }
+  return tokens;
+}
+
+void BenchTraining(const std::string& text, ptm::MarkovTextModel::TokenLevel level, const char* name,
+                   bool with_dense) {
+  std::printf("== %s level training, %zu bytes of text\n", name, text.size());
+
+  ptm::MarkovTextModel model(level);
+  const double seconds = ptm::bench::MeasureSeconds([&] { model.TrainFromText(text); });
+  const auto& chain = model.Chain();
+  const double states = static_cast<double>(chain.States().size());
+  std::printf("%-48s %10.3f s   |V| = %.0f, nnz = %zu, CSR %.1f MiB, dense would be %.1f MiB\n",
+              "sparse CSR TrainFromText", seconds, states, chain.NumTransitions(),
+              static_cast<double>(chain.Transitions().MemoryBytes()) / (1 << 20),
+              states * states * sizeof(std::size_t) / (1 << 20));
+
+  ptm::MarkovTextModel streamed(level);
+  const double stream_seconds = ptm::bench::MeasureSeconds([&] { streamed.TrainFromFile(PTM_CORPUS_PATH); });
+  std::printf("%-48s %10.3f s   %zu KiB chunks\n", "streamed TrainFromFile", stream_seconds,
+              ptm::MarkovTextModel::kDefaultChunkBytes >> 10);
+
+  if (with_dense) {
+    std::fflush(stdout);
+    const auto tokens = SplitTokens(text, level);
+    std::size_t bytes = 0;
+    const double dense_seconds = ptm::bench::MeasureSeconds([&] { bytes = TrainDense(tokens); });
+    std::printf("%-48s %10.3f s   dense %.1f MiB (whitespace tokens)\n", "legacy dense |V| x |V| training",
+                dense_seconds, static_cast<double>(bytes) / (1 << 20));
+  }
+}
+
+// Пакетная генерация в плоский буфер: токенов в секунду всего и на поток
+void BenchBatchGeneration(const ptm::MarkovTextModel& model, const char* level) {
+  const ptm::MarkovChain& chain = model.Chain();
+  constexpr std::size_t kSequences = 4096;
+  constexpr std::size_t kLength = 256;
+
+  std::vector<ptm::MarkovChain::StateId> starts(kSequences);
+  for (std::size_t s = 0; s < kSequences; ++s) {
+    starts[s] = static_cast<ptm::MarkovChain::StateId>(s % chain.NumStates());
+  }
+  std::vector<ptm::MarkovChain::StateId> out(kSequences * kLength);
+  std::vector<std::size_t> lengths(kSequences);
+  chain.GenerateBatch(std::span(starts).first(1), kLength, {1, 0}, std::span(out).first(kLength),
+                      std::span(lengths).first(1)); // построение таблиц не входит в замер
+
+  std::printf("== %s level GenerateBatch, %zu sequences x %zu tokens\n", level, kSequences, kLength);
+  const std::size_t hardware = ptm::ResolveThreadCount(0);
+  std::vector<std::size_t> thread_counts = {1};
+  if (hardware > 1) {
+    thread_counts.push_back(hardware);
+  }
+  for (std::size_t threads : thread_counts) {
+    std::size_t produced = 0;
+    const double seconds = ptm::bench::MeasureSeconds([&] {
+      chain.GenerateBatch(starts, kLength, {1, 0}, out, lengths, threads);
+      for (std::size_t n : lengths) {
+        produced += n;
+      }
+    });
+    ptm::bench::Report("GenerateBatch, " + std::to_string(threads) + " threads", static_cast<double>(produced), seconds,
+                       "tokens");
+    std::printf("%-48s %25.3e tokens/s/core\n", "", static_cast<double>(produced) / seconds /
+                                                          static_cast<double>(std::min(threads, hardware)));
+  }
+}
+
+// GenerateText против GenerateTextInto в переиспользуемую строку: запросов в секунду и выделений на запрос
+void BenchGenerateText(const ptm::MarkovTextModel& model, const char* level) {
+  constexpr std::size_t kCalls = 20'000;
+  constexpr std::size_t kTokensPerCall = 50;
+  std::printf("== %s level text generation, %zu calls x %zu tokens\n", level, kCalls, kTokensPerCall);
+
+  std::mt19937 rng(1);
+  std::size_t sink = 0;
+  std::size_t before = g_allocations.load();
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t i = 0; i < kCalls; ++i) {
+      sink += model.GenerateText(kTokensPerCall, rng, "The").size();
+    }
+  });
+  std::printf("%-48s %10.3f s %14.3e calls/s   %.1f allocations/call\n", "GenerateText", seconds,
+              static_cast<double>(kCalls) / seconds,
+              static_cast<double>(g_allocations.load() - before) / static_cast<double>(kCalls));
+
+  std::string out;
+  for (int warm = 0; warm < 100; ++warm) { // ёмкость out устанавливается
+    out.clear();
+    model.GenerateTextInto(kTokensPerCall, rng, "The", out);
+  }
+  before = g_allocations.load();
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t i = 0; i < kCalls; ++i) {
+      out.clear();
+      model.GenerateTextInto(kTokensPerCall, rng, "The", out);
+      sink += out.size();
+    }
+  });
+  std::printf("%-48s %10.3f s %14.3e calls/s   %.1f allocations/call\n", "GenerateTextInto (reused buffer)", seconds,
+              static_cast<double>(kCalls) / seconds,
+              static_cast<double>(g_allocations.load() - before) / static_cast<double>(kCalls));
+  std::printf("%-48s %zu bytes generated\n", "", sink);
+}
+
+// Время до первой генерации: переобучение по тексту против открытия снимка
+void BenchSnapshot() {
+  const std::string path = "markov_chain_bench.snapshot";
+  ptm::MarkovTextModel model(ptm::MarkovTextModel::TokenLevel::Word);
+  const double train_seconds = ptm::bench::MeasureSeconds([&] { model.TrainFromFile(PTM_CORPUS_PATH); });
+  ptm::SaveSnapshot(model.Chain(), path);
+
+  std::printf("== Word level snapshot\n");
+  std::printf("%-48s %10.3f s\n", "retrain from text", train_seconds);
+  for (bool verify : {true, false}) {
+    std::size_t produced = 0;
+    std::size_t bytes = 0;
+    const double seconds = ptm::bench::MeasureSeconds([&] {
+      const auto snapshot = ptm::MarkovSnapshot::Open(path, verify);
+      std::mt19937 rng(1);
+      std::vector<ptm::MarkovSnapshot::StateId> out;
+      produced = snapshot.GenerateIds(*snapshot.FindState("the"), 100, rng, out);
+      bytes = snapshot.SizeBytes();
+    });
+    std::printf("%-48s %10.6f s   %zu tokens, file %.1f MiB\n",
+                verify ? "Open + checksum + first 100 tokens" : "Open without checksum + first 100 tokens", seconds,
+                produced, static_cast<double>(bytes) / (1 << 20));
+  }
+  std::remove(path.c_str());
+}
+
+// Аналитика по разреженной матрице: стационарное распределение, P^n, классы
+void BenchAnalytics(const ptm::MarkovTextModel& model, const char* level) {
+  const auto& csr = model.Chain().Transitions();
+  std::printf("== %s level analytics, %zu states, nnz = %zu\n", level, csr.NumRows(), csr.columns.size());
+
+  std::optional<ptm::TransitionOperator> op;
+  double seconds = ptm::bench::MeasureSeconds([&] { op.emplace(csr); });
+  std::printf("%-48s %10.3f s\n", "TransitionOperator (transpose)", seconds);
+
+  for (std::size_t threads : {1, 4}) {
+    ptm::StationaryResult result;
+    seconds = ptm::bench::MeasureSeconds([&] { result = ptm::StationaryDistribution(*op, 1e-10, 10000, threads); });
+    std::printf("%-48s %10.3f s   %zu iterations, residual %.1e\n",
+                ("StationaryDistribution, " + std::to_string(threads) + " threads").c_str(), seconds,
+                result.iterations, result.residual);
+  }
+
+  std::vector<double> start(op->NumStates(), 0.0);
+  start[0] = 1.0;
+  seconds = ptm::bench::MeasureSeconds([&] { start = ptm::Propagate(*op, start, 100); });
+  ptm::bench::Report("Propagate, 100 steps", 100.0 * static_cast<double>(csr.columns.size()), seconds, "nnz");
+
+  ptm::ChainStructure structure;
+  seconds = ptm::bench::MeasureSeconds([&] { structure = ptm::AnalyzeStructure(csr); });
+  std::printf("%-48s %10.3f s   %zu classes, %zu absorbing\n", "AnalyzeStructure (Tarjan)", seconds,
+              structure.NumClasses(), structure.absorbing.size());
+}
+
+// Масштабирование параллельного TrainFromText по числу потоков; счётчики совпадают с последовательными
+void BenchParallelTraining(const std::string& text, ptm::MarkovTextModel::TokenLevel level, const char* name) {
+  std::printf("== %s level parallel training, %u hardware threads\n", name, std::thread::hardware_concurrency());
+  double base = 0;
+  for (std::size_t threads : {1, 2, 4, 8, 16}) {
+    ptm::MarkovTextModel model(level);
+    const double seconds = ptm::bench::MeasureSeconds([&] { model.TrainFromText(text, threads); });
+    if (threads == 1) {
+      base = seconds;
+    }
+    std::printf("%-48s %10.3f s   speedup %.2fx\n", ("TrainFromText, " + std::to_string(threads) + " threads").c_str(),
+                seconds, base / seconds);
+  }
+}
+
+// Обучение и генерация NGramModel порядка 1..max_order на уже интернированных токенах
+void BenchNGram(const std::string& text, ptm::MarkovTextModel::TokenLevel level, const char* name,
+                std::size_t max_order) {
+  ptm::MarkovChain vocabulary;
+  std::vector<ptm::MarkovChain::StateId> ids;
+  for (const auto& token : SplitTokens(text, level)) {
+    ids.push_back(vocabulary.Intern(token));
+  }
+  std::printf("== %s level n-gram, %zu tokens\n", name, ids.size());
+
+  for (std::size_t order = 1; order <= max_order; ++order) {
+    ptm::NGramModel model(order);
+    const double train_seconds = ptm::bench::MeasureSeconds([&] { model.Train(ids); });
+    ptm::bench::Report("order " + std::to_string(order) + " Train", static_cast<double>(ids.size()), train_seconds,
+                       "tokens");
+
+    std::mt19937 rng(1);
+    std::vector<ptm::NGramModel::Id> out;
+    out.reserve(kTokens);
+    model.Generate(std::span(ids).first(1), 2, rng, out); // построение таблиц не входит в замер
+    out.clear();
+    const double generate_seconds =
+        ptm::bench::MeasureSeconds([&] { model.Generate(std::span(ids).first(1), kTokens, rng, out); });
+    ptm::bench::Report("order " + std::to_string(order) + " Generate", static_cast<double>(out.size()),
+                       generate_seconds, "tokens");
+    std::printf("%-48s %zu contexts, %.1f MiB\n", "", model.NumContexts(),
+                static_cast<double>(model.MemoryBytes()) / (1 << 20));
+  }
+}
+
+} // namespace
+
+// --dense: прогнать и прежнее плотное обучение на словах. Словарь по пробелам - ~40 тыс. слов,
+// матрица - порядка 10 ГиБ, на небольшой машине процесс убьёт OOM
+int main(int argc, char** argv) {
+  const std::string text = ReadCorpus();
+  if (text.empty()) {
+    std::printf("corpus %s not found\n", PTM_CORPUS_PATH);
+    return 1;
+  }
+  const bool dense_words = argc > 1 && std::string(argv[1]) == "--dense";
+
+  BenchTraining(text, ptm::MarkovTextModel::TokenLevel::Word, "Word", dense_words);
+  BenchTraining(text, ptm::MarkovTextModel::TokenLevel::Character, "Character", true);
+  BenchSnapshot();
+  BenchParallelTraining(text, ptm::MarkovTextModel::TokenLevel::Word, "Word");
+  BenchParallelTraining(text, ptm::MarkovTextModel::TokenLevel::Character, "Character");
+
+  ptm::MarkovTextModel words(ptm::MarkovTextModel::TokenLevel::Word);
+  words.TrainFromText(text);
+  BenchSampling(words, "Word");
+
+  ptm::MarkovTextModel chars(ptm::MarkovTextModel::TokenLevel::Character);
+  chars.TrainFromText(text);
+  BenchSampling(chars, "Character");
+
+  BenchGenerateText(words, "Word");
+  BenchBatchGeneration(words, "Word");
+  BenchBatchGeneration(chars, "Character");
+  BenchAnalytics(words, "Word");
+
+  BenchNGram(text, ptm::MarkovTextModel::TokenLevel::Word, "Word", 6);
+  BenchNGram(text, ptm::MarkovTextModel::TokenLevel::Character, "Character", 12);
+  return 0;
+}
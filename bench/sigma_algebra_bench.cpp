@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench/BenchUtils.hpp"
+#include "lib/sigma-algebra/CompiledMeasure.hpp"
+#include "lib/sigma-algebra/Event.hpp"
+#include "lib/sigma-algebra/IndexedMeasure.hpp"
+#include "lib/sigma-algebra/OutcomeSpace.hpp"
+#include "lib/sigma-algebra/ProbabilityMeasure.hpp"
+#include "lib/sigma-algebra/SigmaAlgebra.hpp"
+
+namespace {
+
+std::vector<bool> RandomMask(std::size_t n, std::mt19937_64& rng) {
+  std::vector<bool> mask(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    mask[i] = (rng() & 1) != 0;
+  }
+  return mask;
+}
+
+// Прежняя схема: побитовый проход по std::vector<bool>
+std::vector<bool> UniteMasks(const std::vector<bool>& a, const std::vector<bool>& b) {
+  std::vector<bool> res(a.size(), false);
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    res[i] = a[i] || b[i];
+  }
+  return res;
+}
+
+void BenchEventAlgebra(std::size_t n, std::size_t repeats) {
+  std::mt19937_64 rng(42);
+  const std::vector<bool> ma = RandomMask(n, rng);
+  const std::vector<bool> mb = RandomMask(n, rng);
+  const ptm::Event a(ma);
+  const ptm::Event b(mb);
+  const double items = static_cast<double>(n) * static_cast<double>(repeats);
+  const std::string suffix = " n=" + std::to_string(n);
+
+  std::size_t sink = 0;
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      sink += UniteMasks(ma, mb).size();
+    }
+  });
+  ptm::bench::Report("vector<bool> union" + suffix, items, seconds, "outcomes");
+
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      sink += ptm::Event::Unite(a, b).Count();
+    }
+  });
+  ptm::bench::Report("Event::Unite + Count" + suffix, items, seconds, "outcomes");
+
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      sink += ptm::Event::Intersect(a, ptm::Event::Complement(b)) == a ? 1 : 0;
+    }
+  });
+  ptm::bench::Report("Event::Intersect(Complement) + ==" + suffix, items, seconds, "outcomes");
+
+  ptm::OutcomeSpace omega;
+  for (std::size_t i = 0; i < n; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  ptm::ProbabilityMeasure P(omega);
+  for (std::size_t i = 0; i < n; ++i) {
+    P.SetAtomicProbability(i, 1.0 / static_cast<double>(n));
+  }
+
+  // Редкое событие: вклад дают только исходы события, а не все n
+  ptm::Event sparse(n);
+  for (std::size_t i = 0; i < n; i += 1024) {
+    sparse.Insert(i);
+  }
+  double mass = 0.0;
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      mass += P.Probability(a) + P.Probability(sparse);
+    }
+  });
+  ptm::bench::Report("Probability (dense + sparse)" + suffix, items, seconds, "outcomes");
+
+  std::printf("  (checksum %zu %.3f)\n", sink, mass);
+}
+
+// σ(G) для num_generators случайных генераторов над n исходами: хранится только разбиение
+void BenchGenerate(std::size_t n, std::size_t num_generators) {
+  std::mt19937_64 rng(7);
+  ptm::OutcomeSpace omega;
+  for (std::size_t i = 0; i < n; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  std::vector<ptm::Event> generators;
+  generators.reserve(num_generators);
+  for (std::size_t g = 0; g < num_generators; ++g) {
+    generators.emplace_back(RandomMask(n, rng));
+  }
+
+  const std::string suffix = " n=" + std::to_string(n) + " |G|=" + std::to_string(num_generators);
+  const double items = static_cast<double>(n) * static_cast<double>(num_generators);
+
+  // Прежняя схема: строка '0'/'1' на исход и unordered_map по строкам
+  std::size_t legacy_atoms = 0;
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    std::unordered_map<std::string, std::size_t> atoms;
+    std::string signature;
+    for (std::size_t i = 0; i < n; ++i) {
+      signature.clear();
+      for (const auto& g : generators) {
+        signature.push_back(g.Contains(i) ? '1' : '0');
+      }
+      atoms.emplace(signature, atoms.size());
+    }
+    legacy_atoms = atoms.size();
+  });
+  ptm::bench::Report("string signatures" + suffix, items, seconds, "outcome*gen");
+
+  std::size_t atoms = 0;
+  seconds = ptm::bench::MeasureSeconds([&] { atoms = ptm::ComputeAtoms(n, generators).num_atoms; });
+  ptm::bench::Report("ComputeAtoms" + suffix, items, seconds, "outcome*gen");
+
+  seconds = ptm::bench::MeasureSeconds([&] {
+    atoms = ptm::SigmaAlgebra::Generate(omega, generators).NumAtoms();
+  });
+  ptm::bench::Report("Generate" + suffix, items, seconds, "outcome*gen");
+  std::printf("  (%zu atoms, %zu by signatures)\n", atoms, legacy_atoms);
+}
+
+// Проверка аксиом для семейства из 2^k событий над k исходами: целого и без {k-2, k-1} и его дополнения
+void BenchVerify(std::size_t k) {
+  ptm::OutcomeSpace omega;
+  std::vector<ptm::Event> singletons;
+  for (std::size_t i = 0; i < k; ++i) {
+    omega.AddOutcome(std::to_string(i));
+    singletons.emplace_back(k);
+    singletons.back().Insert(i);
+  }
+  std::vector<ptm::Event> events = ptm::SigmaAlgebra::Generate(omega, singletons).GetEvents();
+  const double items = static_cast<double>(events.size());
+  const std::string suffix = " 2^" + std::to_string(k);
+
+  bool valid = false;
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    valid = ptm::SigmaAlgebra(omega, events).IsSigmaAlgebra();
+  });
+  ptm::bench::Report("IsSigmaAlgebra valid" + suffix, items, seconds, "events");
+
+  const ptm::Event pair = ptm::Event::Unite(singletons[k - 2], singletons[k - 1]);
+  const ptm::Event pair_complement = ptm::Event::Complement(pair);
+  std::erase_if(events, [&](const ptm::Event& e) { return e == pair || e == pair_complement; });
+  const ptm::SigmaAlgebra broken(omega, events);
+  for (std::size_t threads : {std::size_t{1}, std::size_t{0}}) {
+    std::optional<ptm::SigmaAlgebraViolation> violation;
+    seconds = ptm::bench::MeasureSeconds([&] { violation = broken.FindViolation(threads); });
+    ptm::bench::Report("FindViolation missing union" + suffix + (threads == 1 ? " 1 thread" : " all threads"),
+                       items, seconds, "events");
+    std::printf("  (valid %d, violation at pair %zu %zu)\n", valid ? 1 : 0, violation->first, violation->second);
+  }
+}
+
+// num_events событий над n атомами: ProbabilityMeasure по одному против пакета CompiledMeasure
+void BenchCompiledMeasure(std::size_t n, std::size_t num_events) {
+  std::mt19937_64 rng(3);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  ptm::OutcomeSpace omega;
+  for (std::size_t i = 0; i < n; ++i) {
+    omega.AddOutcome(std::string());
+  }
+  std::vector<double> weights(n);
+  long double total = 0;
+  for (double& w : weights) {
+    w = uniform(rng);
+    total += w;
+  }
+  ptm::ProbabilityMeasure P(omega);
+  for (std::size_t i = 0; i < n; ++i) {
+    P.SetAtomicProbability(i, static_cast<double>(weights[i] / total));
+  }
+
+  std::vector<ptm::Event> events;
+  events.reserve(num_events);
+  for (std::size_t k = 0; k < num_events; ++k) {
+    events.emplace_back(RandomMask(n, rng));
+  }
+  const double items = static_cast<double>(n) * static_cast<double>(num_events);
+  const std::string suffix = " n=" + std::to_string(n) + " x" + std::to_string(num_events);
+
+  std::vector<double> naive(num_events);
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t k = 0; k < num_events; ++k) {
+      naive[k] = P.Probability(events[k]);
+    }
+  });
+  ptm::bench::Report("ProbabilityMeasure::Probability" + suffix, items, seconds, "outcomes");
+
+  const ptm::CompiledMeasure compiled(P);
+  std::vector<double> batch(num_events);
+  for (std::size_t threads : {std::size_t{1}, std::size_t{0}}) {
+    seconds = ptm::bench::MeasureSeconds([&] { compiled.Probabilities(events, batch, threads); });
+    ptm::bench::Report("CompiledMeasure::Probabilities" + suffix + (threads == 1 ? " 1 thread" : " all threads"),
+                       items, seconds, "outcomes");
+  }
+
+  // Погрешность относительно суммы в long double
+  double naive_error = 0.0;
+  double compiled_error = 0.0;
+  const auto probs = P.AtomicProbabilities();
+  for (std::size_t k = 0; k < num_events; ++k) {
+    long double exact = 0;
+    events[k].ForEachSetBit([&](std::size_t id) { exact += probs[id]; });
+    naive_error = std::max(naive_error, static_cast<double>(std::abs(naive[k] - exact)));
+    compiled_error = std::max(compiled_error, static_cast<double>(std::abs(batch[k] - exact)));
+  }
+  std::printf("  (max |error|: naive %.3e, compiled %.3e)\n", naive_error, compiled_error);
+}
+
+// Поток обновлений p_i с проверкой IsValid после каждого, запросы отрезков и выбор исходов
+void BenchIndexedMeasure(std::size_t n) {
+  std::mt19937_64 rng(9);
+  std::uniform_real_distribution<double> uniform(0.0, 2.0 / static_cast<double>(n));
+  ptm::OutcomeSpace omega;
+  for (std::size_t i = 0; i < n; ++i) {
+    omega.AddOutcome(std::string());
+  }
+  ptm::ProbabilityMeasure P(omega);
+  ptm::IndexedMeasure indexed(omega);
+  const std::string suffix = " n=" + std::to_string(n);
+
+  std::size_t valid = 0;
+  constexpr std::size_t kLegacyUpdates = 1000;
+  double seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t k = 0; k < kLegacyUpdates; ++k) {
+      P.SetAtomicProbability(rng() % n, uniform(rng));
+      valid += P.IsValid(1e-3) ? 1 : 0;
+    }
+  });
+  ptm::bench::Report("ProbabilityMeasure update + IsValid" + suffix, kLegacyUpdates, seconds, "updates");
+
+  constexpr std::size_t kUpdates = 1'000'000;
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t k = 0; k < kUpdates; ++k) {
+      indexed.SetAtomicProbability(rng() % n, uniform(rng));
+      valid += indexed.IsValid(1e-3) ? 1 : 0;
+    }
+  });
+  ptm::bench::Report("IndexedMeasure update + IsValid" + suffix, kUpdates, seconds, "updates");
+
+  double mass = 0.0;
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t k = 0; k < kUpdates; ++k) {
+      const std::size_t a = rng() % n;
+      const std::size_t b = rng() % n;
+      mass += indexed.RangeProbability(std::min(a, b), std::max(a, b));
+    }
+  });
+  ptm::bench::Report("IndexedMeasure::RangeProbability" + suffix, kUpdates, seconds, "queries");
+
+  std::size_t sink = 0;
+  seconds = ptm::bench::MeasureSeconds([&] {
+    for (std::size_t k = 0; k < kUpdates; ++k) {
+      sink += *indexed.Sample(rng);
+    }
+  });
+  ptm::bench::Report("IndexedMeasure::Sample" + suffix, kUpdates, seconds, "samples");
+  std::printf("  (checksum %zu %zu %.3f)\n", valid, sink, mass);
+}
+
+} // namespace
+
+int main() {
+  BenchEventAlgebra(256, 200'000);
+  BenchEventAlgebra(1'000'000, 50);
+  BenchGenerate(1'000'000, 16);
+  BenchGenerate(1'000'000, 200);
+  BenchVerify(16);
+  BenchCompiledMeasure(65'536, 4096);
+  BenchCompiledMeasure(10'000'000, 16);
+  BenchIndexedMeasure(1'000'000);
+  return 0;
+}
@@ -0,0 +1,217 @@
+#include "BatchKernels.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+#define PTM_BATCH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#define PTM_HAS_BATCH_CLONES 1
+#else
+#define PTM_BATCH_CLONES
+#define PTM_HAS_BATCH_CLONES 0
+#endif
+
+// Вспомогательные функции обязаны встроиться в каждый клон - иначе вызов внутри цикла мешает векторизации
+#if defined(__GNUC__)
+#define PTM_FORCE_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define PTM_FORCE_INLINE __forceinline
+#else
+#define PTM_FORCE_INLINE inline
+#endif
+
+namespace ptm {
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Сложение с 1.5 * 2^52 округляет до целого без вызова rint, а младшие биты дают само целое
+constexpr double kRoundMagic = 0x1.8p52;
+
+constexpr double kLog2e = 1.4426950408889634074;
+constexpr double kLn2Hi = 6.93147180369123816490e-01; // младшие 32 бита мантиссы нулевые, k * kLn2Hi точно
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+
+// За этими границами exp(x) уже 0 или бесконечность; сужение держит 2^k в диапазоне двух множителей
+constexpr double kExpArgLimit = 1400;
+
+PTM_FORCE_INLINE double RoundToInteger(double x) {
+    return (x + kRoundMagic) - kRoundMagic;
+}
+
+// 2^n для целого n из [-1022, 1023], заданного double
+PTM_FORCE_INLINE double Pow2(double n) {
+    const std::int64_t bits = std::bit_cast<std::int64_t>(n + kRoundMagic) - std::bit_cast<std::int64_t>(kRoundMagic);
+    return std::bit_cast<double>(static_cast<std::uint64_t>(bits + 1023) << 52);
+}
+
+PTM_FORCE_INLINE double ClampExpArg(double x) {
+    // Сравнения ложны для NaN - он проходит дальше и даёт NaN в ответе
+    x = x < -kExpArgLimit ? -kExpArgLimit : x;
+    return x > kExpArgLimit ? kExpArgLimit : x;
+}
+
+// exp(r) - 1 при |r| <= ln2 / 2: ряд Тейлора до r^13, остаток < 2^-56
+PTM_FORCE_INLINE double Expm1Reduced(double r) {
+    double q = 1.0 / 6227020800;
+    q = q * r + 1.0 / 479001600;
+    q = q * r + 1.0 / 39916800;
+    q = q * r + 1.0 / 3628800;
+    q = q * r + 1.0 / 362880;
+    q = q * r + 1.0 / 40320;
+    q = q * r + 1.0 / 5040;
+    q = q * r + 1.0 / 720;
+    q = q * r + 1.0 / 120;
+    q = q * r + 1.0 / 24;
+    q = q * r + 1.0 / 6;
+    q = q * r + 0.5;
+    return r + r * r * q;
+}
+
+struct Reduced {
+    double r;      // x - k ln2
+    double scale1; // 2^k = scale1 * scale2, оба нормальные даже для субнормального 2^k
+    double scale2;
+};
+
+// x = k ln2 + r (Коди-Уэйт), |r| <= ln2 / 2
+PTM_FORCE_INLINE Reduced Reduce(double x) {
+    const double k = RoundToInteger(x * kLog2e);
+    const double r = (x - k * kLn2Hi) - k * kLn2Lo;
+    const double k1 = RoundToInteger(k * 0.5);
+    return {r, Pow2(k1), Pow2(k - k1)};
+}
+
+// exp без вызова libm: до 2 ULP для нормальных результатов
+PTM_FORCE_INLINE double VectorExp(double x) {
+    const Reduced red = Reduce(ClampExpArg(x));
+    return ((1 + Expm1Reduced(red.r)) * red.scale1) * red.scale2;
+}
+
+// expm1 = 2^k (e^r - 1) + (2^k - 1): при k = 0 ответ - сам полином, точный около нуля
+PTM_FORCE_INLINE double VectorExpm1(double x) {
+    const Reduced red = Reduce(ClampExpArg(x));
+    const double scale = red.scale1 * red.scale2;
+    return (Expm1Reduced(red.r) * red.scale1) * red.scale2 + (scale - 1);
+}
+
+} // namespace
+
+PTM_BATCH_CLONES
+void NormalPdfN(std::span<const double> xs, std::span<double> out, double mean, double stddev) {
+    const double norm = kInvSqrt2Pi / stddev;
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double z = (xs[i] - mean) / stddev;
+        out[i] = VectorExp(-0.5 * z * z) * norm;
+    }
+}
+
+PTM_BATCH_CLONES
+void NormalLogPdfN(std::span<const double> xs, std::span<double> out, double mean, double stddev) {
+    const double log_norm = std::log(stddev) + kLogSqrt2Pi;
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double z = (xs[i] - mean) / stddev;
+        out[i] = -0.5 * z * z - log_norm;
+    }
+}
+
+PTM_BATCH_CLONES
+void ExponentialPdfN(std::span<const double> xs, std::span<double> out, double lambda) {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double value = lambda * VectorExp(-lambda * xs[i]);
+        out[i] = xs[i] < 0 ? 0 : value;
+    }
+}
+
+PTM_BATCH_CLONES
+void ExponentialLogPdfN(std::span<const double> xs, std::span<double> out, double lambda) {
+    const double log_lambda = std::log(lambda);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double value = log_lambda - lambda * xs[i];
+        out[i] = xs[i] < 0 ? -kInf : value;
+    }
+}
+
+PTM_BATCH_CLONES
+void ExponentialCdfN(std::span<const double> xs, std::span<double> out, double lambda) {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double value = -VectorExpm1(-lambda * xs[i]);
+        out[i] = xs[i] < 0 ? 0 : value;
+    }
+}
+
+PTM_BATCH_CLONES
+void LaplacePdfN(std::span<const double> xs, std::span<double> out, double mu, double b) {
+    const double norm = 1 / (2 * b);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = norm * VectorExp(-std::abs(xs[i] - mu) / b);
+    }
+}
+
+PTM_BATCH_CLONES
+void LaplaceLogPdfN(std::span<const double> xs, std::span<double> out, double mu, double b) {
+    const double log_norm = std::log(2 * b);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = -log_norm - std::abs(xs[i] - mu) / b;
+    }
+}
+
+PTM_BATCH_CLONES
+void LaplaceCdfN(std::span<const double> xs, std::span<double> out, double mu, double b) {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        // (x - mu) / b при x < mu и -(x - mu) / b иначе - это одно и то же -|x - mu| / b
+        const double half_tail = 0.5 * VectorExp(-std::abs(xs[i] - mu) / b);
+        out[i] = xs[i] < mu ? half_tail : 1 - half_tail;
+    }
+}
+
+PTM_BATCH_CLONES
+void UniformPdfN(std::span<const double> xs, std::span<double> out, double a, double b) {
+    const double density = 1 / (b - a);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = xs[i] >= a && xs[i] <= b ? density : 0;
+    }
+}
+
+PTM_BATCH_CLONES
+void UniformLogPdfN(std::span<const double> xs, std::span<double> out, double a, double b) {
+    const double log_density = -std::log(b - a);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = xs[i] >= a && xs[i] <= b ? log_density : -kInf;
+    }
+}
+
+PTM_BATCH_CLONES
+void UniformCdfN(std::span<const double> xs, std::span<double> out, double a, double b) {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double inside = (xs[i] - a) / (b - a);
+        const double clamped = xs[i] >= b ? 1 : inside;
+        out[i] = xs[i] < a ? 0 : clamped;
+    }
+}
+
+PTM_BATCH_CLONES
+void CauchyPdfN(std::span<const double> xs, std::span<double> out, double x0, double gamma) {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const double coeff = (xs[i] - x0) * (xs[i] - x0) + gamma * gamma;
+        out[i] = gamma / (std::numbers::pi * coeff);
+    }
+}
+
+const char* BatchKernelIsa() {
+#if PTM_HAS_BATCH_CLONES
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return "avx512f";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return "avx2";
+    }
+#endif
+    return "default";
+}
+
+} // namespace ptm
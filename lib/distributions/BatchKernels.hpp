@@ -0,0 +1,43 @@
+#ifndef PTM_BATCHKERNELS_HPP_
+#define PTM_BATCHKERNELS_HPP_
+
+#include <numbers>
+#include <span>
+
+namespace ptm {
+
+// Пакетные ядра PdfN/CdfN/LogPdfN непрерывных распределений. Циклы без ветвлений и вызовов libm
+// (exp и expm1 - свои, полиномиальные) векторизуются компилятором. При сборке GCC/Clang под x86-64 ELF
+// каждое ядро клонируется под AVX-512, AVX2 и базовый x86-64, версия выбирается при загрузке по cpuid.
+//
+// Точность: результат отличается от скалярных Pdf/Cdf/LogPdf не больше чем на kBatchUlpBound ULP.
+// Арифметика та же, что в скалярном коде, расходится только exp/expm1 (до 2 ULP против libm)
+constexpr int kBatchUlpBound = 4;
+
+// Константы, общие для скалярных и пакетных формул - чтобы арифметика совпадала побитово
+inline constexpr double kInvSqrt2Pi = std::numbers::inv_sqrtpi / std::numbers::sqrt2;
+inline constexpr double kLogSqrt2Pi = 0.91893853320467274178;
+
+void NormalPdfN(std::span<const double> xs, std::span<double> out, double mean, double stddev);
+void NormalLogPdfN(std::span<const double> xs, std::span<double> out, double mean, double stddev);
+
+void ExponentialPdfN(std::span<const double> xs, std::span<double> out, double lambda);
+void ExponentialLogPdfN(std::span<const double> xs, std::span<double> out, double lambda);
+void ExponentialCdfN(std::span<const double> xs, std::span<double> out, double lambda);
+
+void LaplacePdfN(std::span<const double> xs, std::span<double> out, double mu, double b);
+void LaplaceLogPdfN(std::span<const double> xs, std::span<double> out, double mu, double b);
+void LaplaceCdfN(std::span<const double> xs, std::span<double> out, double mu, double b);
+
+void UniformPdfN(std::span<const double> xs, std::span<double> out, double a, double b);
+void UniformLogPdfN(std::span<const double> xs, std::span<double> out, double a, double b);
+void UniformCdfN(std::span<const double> xs, std::span<double> out, double a, double b);
+
+void CauchyPdfN(std::span<const double> xs, std::span<double> out, double x0, double gamma);
+
+// Набор инструкций, под который выбраны ядра на этой машине: "avx512f", "avx2" или "default"
+[[nodiscard]] const char* BatchKernelIsa();
+
+} // namespace ptm
+
+#endif // PTM_BATCHKERNELS_HPP_
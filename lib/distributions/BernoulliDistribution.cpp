@@ -33,11 +33,18 @@ double BernoulliDistribution::Cdf(double x) const {
     return 1;
 }
 
-double BernoulliDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+double BernoulliDistribution::Sample(RngRef rng) const {
+    double u = rng.NextUniform();
     return u < p_ ? 1 : 0;
 }
 
+void BernoulliDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    for (double& x : out) {
+        x = x < p_ ? 1 : 0;
+    }
+}
+
 double BernoulliDistribution::TheoreticalMean() const {
     return p_;
 }
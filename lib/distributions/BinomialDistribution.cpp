@@ -1,6 +1,7 @@
+#include <cmath>
 #include <stdexcept>
-#include "BernoulliDistribution.hpp";
 #include "BinomialDistribution.hpp"
+#include "UniformRandom.hpp"
 
 namespace ptm {
 
@@ -41,15 +42,25 @@ double BinomialDistribution::Cdf(double x) const {
     return total;
 }
 
-double BinomialDistribution::Sample(std::mt19937& rng) const {
+double BinomialDistribution::Sample(RngRef rng) const {
     double count = 0;
-    BernoulliDistribution bernoulli(p_);
-    for (int i = 0; i < n_; ++i) {
-        count += bernoulli.Sample(rng);
+    for (unsigned int i = 0; i < n_; ++i) {
+        count += rng.NextUniform() < p_ ? 1 : 0;
     }
     return count;
 }
 
+void BinomialDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    UniformBuffer uniforms(rng);
+    for (double& x : out) {
+        double count = 0;
+        for (unsigned int i = 0; i < n_; ++i) {
+            count += uniforms.Next() < p_ ? 1 : 0;
+        }
+        x = count;
+    }
+}
+
 double BinomialDistribution::TheoreticalMean() const {
     return n_ * p_;
 }
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <numbers>
 #include <stdexcept>
+#include "BatchKernels.hpp"
 #include "CauchyDistribution.hpp"
 
 namespace ptm {
@@ -12,7 +13,12 @@ CauchyDistribution::CauchyDistribution(double x0, double gamma) : x0_(x0), gamma
 
 double CauchyDistribution::Pdf(double x) const {
     double coeff = (x - x0_) * (x - x0_) + gamma_ * gamma_;
-    return 1 / (std::numbers::pi * coeff);
+    return gamma_ / (std::numbers::pi * coeff);
+}
+
+double CauchyDistribution::LogPdf(double x) const {
+    double coeff = (x - x0_) * (x - x0_) + gamma_ * gamma_;
+    return std::log(gamma_ / std::numbers::pi) - std::log(coeff);
 }
 
 double CauchyDistribution::Cdf(double x) const {
@@ -20,11 +26,35 @@ double CauchyDistribution::Cdf(double x) const {
     return 1 / std::numbers::pi * coeff + 0.5;
 }
 
-double CauchyDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+void CauchyDistribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    CauchyPdfN(xs, out, x0_, gamma_);
+}
+
+// log и atan своих векторных версий не имеют - циклы по скалярным формулам без виртуального вызова
+void CauchyDistribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = CauchyDistribution::LogPdf(xs[i]);
+    }
+}
+
+void CauchyDistribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = CauchyDistribution::Cdf(xs[i]);
+    }
+}
+
+double CauchyDistribution::Sample(RngRef rng) const {
+    double u = rng.NextUniform();
     return x0_ + gamma_ * std::tan(std::numbers::pi * (u - 0.5));
 }
 
+void CauchyDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    for (double& x : out) {
+        x = x0_ + gamma_ * std::tan(std::numbers::pi * (x - 0.5));
+    }
+}
+
 double CauchyDistribution::TheoreticalMean() const {
     return NAN;
 }
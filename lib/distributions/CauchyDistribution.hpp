@@ -11,8 +11,14 @@ public:
   CauchyDistribution(double x0, double gamma);
 
   [[nodiscard]] double Pdf(double x) const override;
+  [[nodiscard]] double LogPdf(double x) const override;
   [[nodiscard]] double Cdf(double x) const override;
-  double Sample(std::mt19937& rng) const override;
+  void PdfN(std::span<const double> xs, std::span<double> out) const override;
+  void LogPdfN(std::span<const double> xs, std::span<double> out) const override;
+  void CdfN(std::span<const double> xs, std::span<double> out) const override;
+  double Sample(RngRef rng) const override;
+  void SampleN(std::span<double> out, RngRef rng) const override;
+  using Distribution::SampleN;
 
   [[nodiscard]] double TheoreticalMean() const override;
   [[nodiscard]] double TheoreticalVariance() const override;
@@ -0,0 +1,51 @@
+#include "Distribution.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace ptm {
+
+double Distribution::LogPdf(double x) const {
+    return std::log(Pdf(x));
+}
+
+void Distribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = Pdf(xs[i]);
+    }
+}
+
+void Distribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = LogPdf(xs[i]);
+    }
+}
+
+void Distribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = Cdf(xs[i]);
+    }
+}
+
+void Distribution::SampleN(std::span<double> out, RngRef rng) const {
+    for (double& x : out) {
+        x = Sample(rng);
+    }
+}
+
+void Distribution::SampleN(std::span<float> out, RngRef rng) const {
+    constexpr std::size_t kBlockSize = 256;
+    std::array<double, kBlockSize> block{};
+
+    for (std::size_t offset = 0; offset < out.size(); offset += kBlockSize) {
+        const std::size_t len = std::min(kBlockSize, out.size() - offset);
+        SampleN(std::span<double>(block.data(), len), rng);
+
+        for (std::size_t i = 0; i < len; ++i) {
+            out[offset + i] = static_cast<float>(block[i]);
+        }
+    }
+}
+
+} // namespace ptm
@@ -2,6 +2,9 @@
 #define PTM_DISTRIBUTION_HPP_
 
 #include <random>
+#include <span>
+
+#include "random/RngRef.hpp"
 
 namespace ptm {
 
@@ -13,11 +16,28 @@ public:
   // Для дискретных распределений pdf(x) трактуем как P(X = x)
   [[nodiscard]] virtual double Pdf(double x) const = 0;
 
+  // ln pdf(x). По умолчанию log(Pdf(x)), непрерывные распределения считают напрямую без переполнения
+  [[nodiscard]] virtual double LogPdf(double x) const;
+
   // F(x) = P(X <= x)
   [[nodiscard]] virtual double Cdf(double x) const = 0;
 
-  // Генерация выборочного значения
-  virtual double Sample(std::mt19937& rng) const = 0;
+  // Пакетные Pdf, LogPdf и Cdf: out[i] = f(xs[i]), размеры должны совпадать.
+  // По умолчанию - циклы по скалярным методам; непрерывные распределения переопределяют их
+  // векторизованными ядрами (BatchKernels.hpp), которые совпадают со скалярными до kBatchUlpBound ULP
+  virtual void PdfN(std::span<const double> xs, std::span<double> out) const;
+  virtual void LogPdfN(std::span<const double> xs, std::span<double> out) const;
+  virtual void CdfN(std::span<const double> xs, std::span<double> out) const;
+
+  // Генерация выборочного значения. Подходит любой генератор: std::mt19937, Xoshiro256PlusPlus, Pcg64, Philox4x32, ...
+  virtual double Sample(RngRef rng) const = 0;
+
+  // Пакетная генерация: заполняет out независимыми значениями.
+  // По умолчанию - цикл по Sample, наследники переопределяют без виртуального вызова на каждый элемент
+  virtual void SampleN(std::span<double> out, RngRef rng) const;
+
+  // То же в float: генерирует блоками через SampleN(double) и сужает
+  void SampleN(std::span<float> out, RngRef rng) const;
 
   // Теоретическое матожидание и дисперсия (если определены).
   // Для распределений, где это не определено - можно вернуть NaN.
@@ -1,64 +1,88 @@
 #include "DistributionExperiment.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "parallel/ParallelFor.hpp"
+
 namespace ptm {
+
+namespace {
+
+// Размер куска, который генерируется в буфер на стеке и сразу сворачивается в моменты
+constexpr std::size_t kChunkSize = 4096;
+
+} // namespace
+
 DistributionExperiment::DistributionExperiment(std::shared_ptr<Distribution> dist, size_t sample_size) :
     dist_(std::move(dist)), sample_size_(sample_size) {
 }
 
-ExperimentStats DistributionExperiment::Run(std::mt19937& rng) {
-    std::vector<double> samples(sample_size_);
+ExperimentStats DistributionExperiment::Run(RngRef rng) {
+    std::array<double, kChunkSize> chunk{};
+    MomentAccumulator moments;
 
-    for (int i = 0; i < sample_size_; ++i) {
-        samples[i] = dist_->Sample(rng);
+    for (std::size_t offset = 0; offset < sample_size_; offset += kChunkSize) {
+        const std::span<double> xs(chunk.data(), std::min(kChunkSize, sample_size_ - offset));
+        dist_->SampleN(xs, rng);
+        moments.Push(xs);
     }
 
-    double empirical_mean = 0;
+    return MakeStats(moments);
+}
 
-    for (int i = 0; i < sample_size_; ++i) {
-        empirical_mean += samples[i];
-    }
+ExperimentStats DistributionExperiment::Run(const StreamKey& key, std::size_t num_threads) {
+    const std::size_t num_blocks = (sample_size_ + kStreamBlockSize - 1) / kStreamBlockSize;
+    std::vector<MomentAccumulator> partials(num_blocks);
+
+    ParallelFor(num_blocks, num_threads, [&](std::size_t block) {
+        const std::size_t begin = block * kStreamBlockSize;
+        const std::size_t len = std::min(kStreamBlockSize, sample_size_ - begin);
+        Philox4x32 rng = BlockRng(key, static_cast<std::uint32_t>(block));
 
-    empirical_mean /= sample_size_;
+        // Блок генерируется кусками в буфер на стеке - выборка целиком нигде не хранится
+        std::array<double, kChunkSize> chunk{};
+        MomentAccumulator moments;
 
-    double empirical_variance = 0;
+        for (std::size_t offset = 0; offset < len; offset += kChunkSize) {
+            const std::span<double> xs(chunk.data(), std::min(kChunkSize, len - offset));
+            dist_->SampleN(xs, rng);
+            moments.Push(xs);
+        }
+        partials[block] = moments;
+    });
 
-    for (int i = 0; i < sample_size_; ++i) {
-        double iteration_variance = samples[i] - empirical_mean;
-        empirical_variance += std::pow(iteration_variance, 2);
+    // Слияние строго в порядке блоков - результат не зависит от числа потоков
+    MomentAccumulator total;
+    for (const auto& part : partials) {
+        total.Merge(part);
     }
 
-    empirical_variance /= sample_size_;
-    ExperimentStats stats;
-    stats.empirical_mean = empirical_mean;
-    stats.empirical_variance = empirical_variance;
-    stats.mean_error = dist_->TheoreticalMean() - empirical_mean;
-    stats.variance_error = dist_->TheoreticalVariance() - empirical_variance;
+    return MakeStats(total);
+}
 
+ExperimentStats DistributionExperiment::MakeStats(const MomentAccumulator& moments) const {
+    ExperimentStats stats;
+    stats.empirical_mean = moments.Mean();
+    stats.empirical_variance = moments.Variance();
+    stats.mean_error = dist_->TheoreticalMean() - stats.empirical_mean;
+    stats.variance_error = dist_->TheoreticalVariance() - stats.empirical_variance;
+    stats.empirical_skewness = moments.Skewness();
+    stats.empirical_excess_kurtosis = moments.ExcessKurtosis();
     return stats;
 }
 
-std::vector<double> DistributionExperiment::EmpiricalCdf(const std::vector<double>& grid,
-                                                         std::mt19937& rng,
-                                                         std::size_t sample_size) {
+EmpiricalDistribution DistributionExperiment::Empirical(RngRef rng, std::size_t sample_size) {
     std::vector<double> samples(sample_size);
+    dist_->SampleN(samples, rng);
+    return EmpiricalDistribution(std::move(samples));
+}
 
-    for (int i = 0; i < sample_size; ++i) {
-        samples[i] = dist_->Sample(rng);
-    }
-
-    std::vector<double> cdf(grid.size(), 0);
-
-    for (int i = 0; i < grid.size(); ++i) {
-        double counter = 0;
-        for (int j = 0; j < sample_size; ++j) {
-            if (samples[j] <= grid[i]) {
-                ++counter;
-            }
-        }
-
-        cdf[i] = counter /static_cast<double>(sample_size);
-    }
-    return cdf;
+std::vector<double> DistributionExperiment::EmpiricalCdf(const std::vector<double>& grid,
+                                                         RngRef rng,
+                                                         std::size_t sample_size) {
+    return Empirical(rng, sample_size).CdfOnGrid(grid);
 }
 
 double DistributionExperiment::KolmogorovDistance(const std::vector<double>& grid,
@@ -3,9 +3,13 @@
 
 #include <memory>
 #include <random>
+#include <vector>
 
 #include "Distribution.hpp"
+#include "EmpiricalDistribution.hpp"
 #include "ExperimentStats.hpp"
+#include "MomentAccumulator.hpp"
+#include "random/CounterStreams.hpp"
 
 namespace ptm {
 
@@ -14,18 +18,31 @@ class DistributionExperiment {
 public:
   DistributionExperiment(std::shared_ptr<Distribution> dist, size_t sample_size);
 
-  ExperimentStats Run(std::mt19937& rng);
+  // Выборка генерируется кусками и сразу сворачивается в MomentAccumulator - O(1) памяти по sample_size
+  ExperimentStats Run(RngRef rng);
 
-  // Эмпирическая CDF на сетке точек
-  std::vector<double> EmpiricalCdf(const std::vector<double>& grid, std::mt19937& rng, std::size_t sample_size);
+  // Параллельный воспроизводимый прогон: выборка режется на блоки по kStreamBlockSize,
+  // блок b генерируется собственным потоком BlockRng(key, b) на пуле потоков и сворачивается
+  // в MomentAccumulator; выборка в память не складывается. Накопители сливаются в порядке блоков,
+  // поэтому результат побитово совпадает при любом num_threads (0 - по числу ядер)
+  ExperimentStats Run(const StreamKey& key, std::size_t num_threads);
 
-  // Оценка статистики Колмогорова между эмпирической и теоретической CDF
+  // Эмпирическое распределение выборки объёма sample_size: сортируется один раз и переиспользуется
+  EmpiricalDistribution Empirical(RngRef rng, std::size_t sample_size);
+
+  // Эмпирическая CDF на сетке точек, O((N + G) log N) вместо перебора выборки для каждой точки
+  std::vector<double> EmpiricalCdf(const std::vector<double>& grid, RngRef rng, std::size_t sample_size);
+
+  // Оценка статистики Колмогорова между эмпирической и теоретической CDF только в точках сетки;
+  // точное D_n по всей выборке и p-значения - TestGoodnessOfFit (GoodnessOfFit.hpp)
   [[nodiscard]] double KolmogorovDistance(const std::vector<double>& grid,
                                           const std::vector<double>& empirical_cdf) const;
 
 private:
   std::shared_ptr<Distribution> dist_;
   std::size_t sample_size_;
+
+  [[nodiscard]] ExperimentStats MakeStats(const MomentAccumulator& moments) const;
 };
 
 } // namespace ptm
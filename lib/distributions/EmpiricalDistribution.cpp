@@ -0,0 +1,184 @@
+#include "EmpiricalDistribution.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#include "MomentAccumulator.hpp"
+
+namespace ptm {
+
+namespace {
+
+// Ниже этого размера std::sort быстрее из-за накладных расходов на гистограммы
+constexpr std::size_t kRadixThreshold = 1U << 16;
+
+constexpr int kDigitBits = 11;
+constexpr int kNumDigits = (64 + kDigitBits - 1) / kDigitBits;
+constexpr std::size_t kBuckets = std::size_t{1} << kDigitBits;
+
+// Монотонное отображение double -> uint64: у отрицательных инвертируются все биты, у остальных знаковый
+std::uint64_t ToKey(double x) {
+    const auto bits = std::bit_cast<std::uint64_t>(x);
+    return (bits >> 63) != 0 ? ~bits : bits ^ (std::uint64_t{1} << 63);
+}
+
+double FromKey(std::uint64_t key) {
+    const std::uint64_t bits = (key >> 63) != 0 ? key ^ (std::uint64_t{1} << 63) : ~key;
+    return std::bit_cast<double>(bits);
+}
+
+void RadixSort(std::vector<double>& xs) {
+    std::vector<std::uint64_t> keys(xs.size());
+    std::vector<std::uint64_t> buffer(xs.size());
+    std::array<std::array<std::size_t, kBuckets>, kNumDigits> counts{};
+
+    // Все гистограммы строятся за один проход
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        keys[i] = ToKey(xs[i]);
+        for (int d = 0; d < kNumDigits; ++d) {
+            ++counts[d][(keys[i] >> (d * kDigitBits)) & (kBuckets - 1)];
+        }
+    }
+
+    for (int d = 0; d < kNumDigits; ++d) {
+        auto& count = counts[d];
+        // Разряд, одинаковый у всех ключей, не меняет порядок - проход пропускается
+        if (count[(keys[0] >> (d * kDigitBits)) & (kBuckets - 1)] == xs.size()) {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (auto& c : count) {
+            const std::size_t next = offset + c;
+            c = offset;
+            offset = next;
+        }
+        for (std::uint64_t key : keys) {
+            buffer[count[(key >> (d * kDigitBits)) & (kBuckets - 1)]++] = key;
+        }
+        keys.swap(buffer);
+    }
+
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = FromKey(keys[i]);
+    }
+}
+
+} // namespace
+
+void SortSample(std::vector<double>& xs) {
+    if (xs.size() < kRadixThreshold) {
+        std::sort(xs.begin(), xs.end());
+        return;
+    }
+    RadixSort(xs);
+}
+
+EmpiricalDistribution::EmpiricalDistribution(std::vector<double> sample) : sorted_(std::move(sample)) {
+    if (sorted_.empty()) {
+        throw std::invalid_argument("sample must not be empty");
+    }
+    if (std::ranges::any_of(sorted_, [](double x) { return std::isnan(x); })) {
+        throw std::invalid_argument("sample must not contain NaN");
+    }
+
+    SortSample(sorted_);
+
+    MomentAccumulator moments;
+    moments.Push(sorted_);
+    mean_ = moments.Mean();
+    variance_ = moments.Variance();
+}
+
+double EmpiricalDistribution::Pdf(double x) const {
+    const auto [first, last] = std::equal_range(sorted_.begin(), sorted_.end(), x);
+    return static_cast<double>(last - first) / static_cast<double>(sorted_.size());
+}
+
+double EmpiricalDistribution::Cdf(double x) const {
+    const auto last = std::upper_bound(sorted_.begin(), sorted_.end(), x);
+    return static_cast<double>(last - sorted_.begin()) / static_cast<double>(sorted_.size());
+}
+
+double EmpiricalDistribution::Sample(RngRef rng) const {
+    const auto n = static_cast<double>(sorted_.size());
+    const auto index = static_cast<std::size_t>(rng.NextUniform() * n);
+    return sorted_[std::min(index, sorted_.size() - 1)];
+}
+
+void EmpiricalDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    const auto n = static_cast<double>(sorted_.size());
+    for (double& x : out) {
+        const auto index = static_cast<std::size_t>(x * n);
+        x = sorted_[std::min(index, sorted_.size() - 1)];
+    }
+}
+
+double EmpiricalDistribution::TheoreticalMean() const {
+    return mean_;
+}
+
+double EmpiricalDistribution::TheoreticalVariance() const {
+    return variance_;
+}
+
+double EmpiricalDistribution::Quantile(double p) const {
+    if (!(p >= 0 && p <= 1)) {
+        throw std::invalid_argument("p must be in [0, 1]");
+    }
+
+    // Наименьший k с k / n >= p
+    const auto k = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted_.size())));
+    return sorted_[std::max<std::size_t>(k, 1) - 1];
+}
+
+std::vector<double> EmpiricalDistribution::CdfOnGrid(std::span<const double> grid) const {
+    std::vector<double> cdf(grid.size());
+    const auto n = static_cast<double>(sorted_.size());
+
+    if (!std::is_sorted(grid.begin(), grid.end())) {
+        for (std::size_t i = 0; i < grid.size(); ++i) {
+            cdf[i] = Cdf(grid[i]);
+        }
+        return cdf;
+    }
+
+    // Слияние: указатель по выборке только двигается вперёд
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+        while (j < sorted_.size() && sorted_[j] <= grid[i]) {
+            ++j;
+        }
+        cdf[i] = static_cast<double>(j) / n;
+    }
+    return cdf;
+}
+
+CdfTable EmpiricalDistribution::ExactCdf() const {
+    CdfTable table;
+    const auto n = static_cast<double>(sorted_.size());
+
+    for (std::size_t j = 0; j < sorted_.size(); ++j) {
+        // Значение записывается на последнем из равных, где F_n уже учитывает их все
+        if (j + 1 == sorted_.size() || sorted_[j + 1] != sorted_[j]) {
+            table.x.push_back(sorted_[j]);
+            table.cdf.push_back(static_cast<double>(j + 1) / n);
+        }
+    }
+    return table;
+}
+
+std::span<const double> EmpiricalDistribution::SortedSample() const noexcept {
+    return sorted_;
+}
+
+std::size_t EmpiricalDistribution::Size() const noexcept {
+    return sorted_.size();
+}
+
+} // namespace ptm
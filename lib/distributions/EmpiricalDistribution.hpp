@@ -0,0 +1,59 @@
+#ifndef PTM_EMPIRICALDISTRIBUTION_HPP_
+#define PTM_EMPIRICALDISTRIBUTION_HPP_
+
+#include <span>
+#include <vector>
+
+#include "Distribution.hpp"
+
+namespace ptm {
+
+// Точная эмпирическая CDF: значения в скачках и F в них
+struct CdfTable {
+  std::vector<double> x;   // различные значения выборки по возрастанию
+  std::vector<double> cdf; // F_n(x[i]) = #{X_j <= x[i]} / n
+};
+
+// Эмпирическое распределение выборки: сортирует её один раз (поразрядно для больших n),
+// после чего F_n(x) и Pdf - O(log N), квантиль - O(1), CDF на сетке - O(N + G) слиянием.
+// Как дискретное распределение: Pdf(x) = доля значений, равных x, Sample - бутстреп
+class EmpiricalDistribution : public Distribution {
+public:
+  // Выборка не должна быть пустой и содержать NaN
+  explicit EmpiricalDistribution(std::vector<double> sample);
+
+  [[nodiscard]] double Pdf(double x) const override;
+  [[nodiscard]] double Cdf(double x) const override;
+  double Sample(RngRef rng) const override;
+  void SampleN(std::span<double> out, RngRef rng) const override;
+  using Distribution::SampleN;
+
+  // Выборочные среднее и дисперсия (деление на n)
+  [[nodiscard]] double TheoreticalMean() const override;
+  [[nodiscard]] double TheoreticalVariance() const override;
+
+  // Q(p) = inf{x : F_n(x) >= p}, p из [0, 1]; Q(0) - минимум выборки
+  [[nodiscard]] double Quantile(double p) const;
+
+  // F_n в точках grid. Отсортированная сетка проходится слиянием за O(N + G),
+  // произвольная - бинарным поиском за O(G log N)
+  [[nodiscard]] std::vector<double> CdfOnGrid(std::span<const double> grid) const;
+
+  // Точный режим: F_n во всех точках выборки (по одной на различное значение)
+  [[nodiscard]] CdfTable ExactCdf() const;
+
+  [[nodiscard]] std::span<const double> SortedSample() const noexcept;
+  [[nodiscard]] std::size_t Size() const noexcept;
+
+private:
+  std::vector<double> sorted_;
+  double mean_;
+  double variance_;
+};
+
+// Сортировка double по возрастанию: LSD-поразрядная по 11 бит (6 проходов) для больших массивов, иначе std::sort
+void SortSample(std::vector<double>& xs);
+
+} // namespace ptm
+
+#endif // PTM_EMPIRICALDISTRIBUTION_HPP_
@@ -6,6 +6,8 @@ struct ExperimentStats {
   double empirical_variance = 0.0;
   double mean_error = 0.0;
   double variance_error = 0.0;
+  double empirical_skewness = 0.0;        // g1 = sqrt(n) M3 / M2^(3/2)
+  double empirical_excess_kurtosis = 0.0; // g2 = n M4 / M2^2 - 3
 };
 
 #endif // PTM_EXPERIMENTSTATS_HPP_
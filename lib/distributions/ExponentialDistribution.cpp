@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
+#include "BatchKernels.hpp"
 #include "ExponentialDistribution.hpp"
+#include "Ziggurat.hpp"
 
 namespace ptm {
-ExponentialDistribution::ExponentialDistribution(double lambda) : lambda_(lambda) {
+ExponentialDistribution::ExponentialDistribution(double lambda, Method method) : lambda_(lambda), method_(method) {
     if (lambda <= 0) {
         throw std::invalid_argument("lambda must be > 0");
     }
@@ -16,19 +22,67 @@ double ExponentialDistribution::Pdf(double x) const {
     return lambda_ * std::exp(-lambda_ * x);
 }
 
+double ExponentialDistribution::LogPdf(double x) const {
+    if (x < 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    return std::log(lambda_) - lambda_ * x;
+}
+
 double ExponentialDistribution::Cdf(double x) const {
     if (x < 0) {
         return 0;
     }
 
-    return 1 - std::exp(-lambda_ * x);
+    // -expm1 вместо 1 - exp: при малых x нет потери точности
+    return -std::expm1(-lambda_ * x);
+}
+
+void ExponentialDistribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    ExponentialPdfN(xs, out, lambda_);
+}
+
+void ExponentialDistribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    ExponentialLogPdfN(xs, out, lambda_);
+}
+
+void ExponentialDistribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    ExponentialCdfN(xs, out, lambda_);
 }
 
-double ExponentialDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+double ExponentialDistribution::Sample(RngRef rng) const {
+    if (method_ == Method::Ziggurat) {
+        return ExponentialZiggurat(rng(), rng, ExponentialZigguratTables()) / lambda_;
+    }
+
+    double u = rng.NextUniform();
     return -std::log(u) / lambda_;
 }
 
+void ExponentialDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    if (method_ == Method::Ziggurat) {
+        const ZigguratTables& tables = ExponentialZigguratTables();
+        const double scale = 1 / lambda_;
+        std::array<std::uint64_t, 256> bits{};
+
+        for (std::size_t offset = 0; offset < out.size(); offset += bits.size()) {
+            const std::size_t len = std::min(bits.size(), out.size() - offset);
+            rng.FillBits(std::span<std::uint64_t>(bits.data(), len));
+            for (std::size_t i = 0; i < len; ++i) {
+                out[offset + i] = ExponentialZiggurat(bits[i], rng, tables) * scale;
+            }
+        }
+        return;
+    }
+
+    rng.FillUniform(out);
+    const double scale = -1 / lambda_;
+    for (double& x : out) {
+        x = std::log(x) * scale;
+    }
+}
+
 double ExponentialDistribution::TheoreticalMean() const {
     return 1 / lambda_;
 }
@@ -36,4 +90,8 @@ double ExponentialDistribution::TheoreticalMean() const {
 double ExponentialDistribution::TheoreticalVariance() const {
     return 1 / (lambda_ * lambda_);
 }
+
+ExponentialDistribution::Method ExponentialDistribution::GetMethod() const {
+    return method_;
+}
 } // namespace ptm
@@ -7,17 +7,29 @@ namespace ptm {
 
 class ExponentialDistribution : public Distribution {
 public:
-  explicit ExponentialDistribution(double lambda);
+  // Способ генерации: обращение CDF (log на значение) или табличный зиккурат
+  enum class Method { Inversion, Ziggurat }; // NOLINT
+
+  explicit ExponentialDistribution(double lambda, Method method = Method::Inversion);
 
   [[nodiscard]] double Pdf(double x) const override;
+  [[nodiscard]] double LogPdf(double x) const override;
   [[nodiscard]] double Cdf(double x) const override;
-  double Sample(std::mt19937& rng) const override;
+  void PdfN(std::span<const double> xs, std::span<double> out) const override;
+  void LogPdfN(std::span<const double> xs, std::span<double> out) const override;
+  void CdfN(std::span<const double> xs, std::span<double> out) const override;
+  double Sample(RngRef rng) const override;
+  void SampleN(std::span<double> out, RngRef rng) const override;
+  using Distribution::SampleN;
 
   [[nodiscard]] double TheoreticalMean() const override;
   [[nodiscard]] double TheoreticalVariance() const override;
 
+  [[nodiscard]] Method GetMethod() const;
+
 private:
   double lambda_;
+  Method method_;
 };
 
 } // namespace ptm
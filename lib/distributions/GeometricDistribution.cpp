@@ -1,3 +1,4 @@
+#include <cmath>
 #include <stdexcept>
 #include "GeometricDistribution.hpp"
 
@@ -26,9 +27,17 @@ double GeometricDistribution::Cdf(double x) const {
     return 1 - std::pow(1 - p_, k);
 }
 
-double GeometricDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
-    return std::floor(std::log(1 - u) / std::log(1 - p_));
+double GeometricDistribution::Sample(RngRef rng) const {
+    double u = rng.NextUniform();
+    return std::floor(std::log(1 - u) / std::log(1 - p_)) + 1;
+}
+
+void GeometricDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    const double inv_log_q = 1 / std::log(1 - p_);
+    for (double& x : out) {
+        x = std::floor(std::log(1 - x) * inv_log_q) + 1;
+    }
 }
 
 double GeometricDistribution::TheoreticalMean() const {
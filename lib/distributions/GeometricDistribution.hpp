@@ -14,7 +14,9 @@ public:
 
   [[nodiscard]] double Pdf(double x) const override;
   [[nodiscard]] double Cdf(double x) const override;
-  double Sample(std::mt19937& rng) const override;
+  double Sample(RngRef rng) const override;
+  void SampleN(std::span<double> out, RngRef rng) const override;
+  using Distribution::SampleN;
 
   [[nodiscard]] double TheoreticalMean() const override;
   [[nodiscard]] double TheoreticalVariance() const override;
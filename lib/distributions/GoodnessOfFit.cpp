@@ -0,0 +1,204 @@
+#include "GoodnessOfFit.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+namespace ptm {
+
+namespace {
+
+constexpr double kScale = 1e140;
+constexpr int kScaleExponent = 140;
+
+using Matrix = std::vector<double>;
+
+// C = A * B для квадратных матриц m x m, хранимых по строкам
+void Multiply(const Matrix& a, const Matrix& b, Matrix& c, std::size_t m) {
+    std::fill(c.begin(), c.end(), 0.0);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t k = 0; k < m; ++k) {
+            const double aik = a[i * m + k];
+            for (std::size_t j = 0; j < m; ++j) {
+                c[i * m + j] += aik * b[k * m + j];
+            }
+        }
+    }
+}
+
+// V * 10^exponent = H^n. Чтобы не было переполнения, V периодически делится на 10^140
+void Power(const Matrix& h, std::size_t m, std::size_t n, Matrix& v, int& exponent) {
+    if (n == 1) {
+        v = h;
+        exponent = 0;
+        return;
+    }
+
+    Power(h, m, n / 2, v, exponent);
+    Matrix square(m * m);
+    Multiply(v, v, square, m);
+    exponent *= 2;
+
+    if (n % 2 == 0) {
+        v.swap(square);
+    } else {
+        Multiply(h, square, v, m);
+    }
+
+    if (v[(m / 2) * m + m / 2] > kScale) {
+        for (double& x : v) {
+            x /= kScale;
+        }
+        exponent += kScaleExponent;
+    }
+}
+
+} // namespace
+
+double KolmogorovCdf(double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    if (x >= 1) {
+        return 1 - KolmogorovSurvival(x);
+    }
+
+    // При малых x знакочередующийся ряд сходится медленно - берём тета-представление
+    // K(x) = sqrt(2 pi) / x * sum exp(-(2k - 1)^2 pi^2 / (8 x^2))
+    const double factor = std::numbers::pi * std::numbers::pi / (8 * x * x);
+    double sum = 0;
+    for (int k = 1; k <= 20; ++k) {
+        const double odd = 2.0 * k - 1;
+        const double term = std::exp(-odd * odd * factor);
+        sum += term;
+        if (term < std::numeric_limits<double>::epsilon() * sum) {
+            break;
+        }
+    }
+    return std::sqrt(2 * std::numbers::pi) / x * sum;
+}
+
+double KolmogorovSurvival(double x) {
+    if (x <= 0) {
+        return 1;
+    }
+    if (x < 1) {
+        return 1 - KolmogorovCdf(x);
+    }
+
+    // 1 - K(x) = 2 sum (-1)^(k-1) exp(-2 k^2 x^2)
+    double sum = 0;
+    double sign = 1;
+    for (int k = 1; k <= 100; ++k) {
+        const double term = std::exp(-2.0 * k * k * x * x);
+        sum += sign * term;
+        sign = -sign;
+        if (term < std::numeric_limits<double>::epsilon() * sum) {
+            break;
+        }
+    }
+    return std::clamp(2 * sum, 0.0, 1.0);
+}
+
+double KolmogorovExactCdf(std::size_t n, double d) {
+    const auto nd = static_cast<double>(n) * d;
+    if (n == 0 || d >= 1) {
+        return 1;
+    }
+    if (nd <= 0.5) {
+        // D_n >= 1 / (2n) всегда
+        return 0;
+    }
+
+    // В правом хвосте точность метода ограничена, а ответ почти 1 - авторы берут приближение
+    const double s = d * nd;
+    if (s > 7.24 || (s > 3.76 && n > 99)) {
+        const auto fn = static_cast<double>(n);
+        return 1 - 2 * std::exp(-(2.000071 + 0.331 / std::sqrt(fn) + 1.409 / fn) * s);
+    }
+
+    const auto k = static_cast<std::size_t>(nd) + 1;
+    const std::size_t m = 2 * k - 1;
+    if (m > kMaxExactKolmogorovMatrix) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const double h = static_cast<double>(k) - nd;
+
+    Matrix matrix(m * m);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < m; ++j) {
+            matrix[i * m + j] = i + 1 >= j ? 1 : 0;
+        }
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+        matrix[i * m] -= std::pow(h, static_cast<double>(i + 1));
+        matrix[(m - 1) * m + i] -= std::pow(h, static_cast<double>(m - i));
+    }
+    if (2 * h - 1 > 0) {
+        matrix[(m - 1) * m] += std::pow(2 * h - 1, static_cast<double>(m));
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j <= std::min(i, m - 1); ++j) {
+            // Деление на (i - j + 1)!
+            for (std::size_t g = 2; g <= i - j + 1; ++g) {
+                matrix[i * m + j] /= static_cast<double>(g);
+            }
+        }
+    }
+
+    Matrix power;
+    int exponent = 0;
+    Power(matrix, m, n, power, exponent);
+
+    // P(D_n < d) = n! / n^n * (H^n)_{kk}
+    double result = power[(k - 1) * m + k - 1];
+    const auto fn = static_cast<double>(n);
+    for (std::size_t i = 1; i <= n; ++i) {
+        result = result * static_cast<double>(i) / fn;
+        if (result < 1 / kScale) {
+            result *= kScale;
+            exponent -= kScaleExponent;
+        }
+    }
+    return std::clamp(result * std::pow(10.0, exponent), 0.0, 1.0);
+}
+
+GoodnessOfFitResult TestGoodnessOfFit(const EmpiricalDistribution& sample, const Distribution& dist) {
+    const std::span<const double> sorted = sample.SortedSample();
+    const std::size_t n = sorted.size();
+    const auto fn = static_cast<double>(n);
+
+    std::vector<double> cdf(n);
+    dist.CdfN(sorted, cdf);
+
+    // D_n достигается в скачках F_n: справа от x_(i) это i / n - F, слева F - (i - 1) / n.
+    // Для равных значений максимум всё равно берётся на крайних из них, так что повторы учтены
+    double d_plus = 0;
+    double d_minus = 0;
+    double anderson_sum = 0;
+    double cramer_sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto rank = static_cast<double>(i + 1);
+        d_plus = std::max(d_plus, rank / fn - cdf[i]);
+        d_minus = std::max(d_minus, cdf[i] - (rank - 1) / fn);
+
+        // A^2 = -n - 1/n sum (2i - 1) [ln F_i + ln(1 - F_(n+1-i))]
+        anderson_sum += (2 * rank - 1) * (std::log(cdf[i]) + std::log1p(-cdf[n - 1 - i]));
+
+        const double diff = (2 * rank - 1) / (2 * fn) - cdf[i];
+        cramer_sum += diff * diff;
+    }
+
+    GoodnessOfFitResult result;
+    result.sample_size = n;
+    result.ks_statistic = std::max(d_plus, d_minus);
+    result.ks_pvalue_asymptotic = KolmogorovSurvival(std::sqrt(fn) * result.ks_statistic);
+    result.ks_pvalue_exact = 1 - KolmogorovExactCdf(n, result.ks_statistic);
+    result.anderson_darling = -fn - anderson_sum / fn;
+    result.cramer_von_mises = 1 / (12 * fn) + cramer_sum;
+    return result;
+}
+
+} // namespace ptm
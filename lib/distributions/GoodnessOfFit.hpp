@@ -0,0 +1,49 @@
+#ifndef PTM_GOODNESSOFFIT_HPP_
+#define PTM_GOODNESSOFFIT_HPP_
+
+#include <cstddef>
+
+#include "Distribution.hpp"
+#include "EmpiricalDistribution.hpp"
+
+namespace ptm {
+
+// Размер матрицы алгоритма Марсальи-Цанга-Вана (m = 2k - 1, k = floor(n d) + 1), выше которого
+// точное P(D_n < d) не считается: умножение матриц стоит O(m^3)
+constexpr std::size_t kMaxExactKolmogorovMatrix = 255;
+
+// Критерии согласия выборки с непрерывным распределением. Все три статистики считаются
+// по одному отсортированному буферу и одному пакетному вызову CdfN
+struct GoodnessOfFitResult {
+  std::size_t sample_size = 0;
+
+  // D_n = sup |F_n(x) - F(x)| по всей прямой, с учётом скачков F_n
+  double ks_statistic = 0;
+
+  // P(K > sqrt(n) D_n) по предельному распределению Колмогорова
+  double ks_pvalue_asymptotic = 0;
+
+  // P(D_n >= d) для данного n (Марсалья-Цанг-Ван); NaN, если матрица больше kMaxExactKolmogorovMatrix
+  double ks_pvalue_exact = 0;
+
+  // A^2 Андерсона-Дарлинга (бесконечность, если F = 0 или 1 в точке выборки)
+  double anderson_darling = 0;
+
+  // W^2 = n * omega^2 Крамера-фон Мизеса
+  double cramer_von_mises = 0;
+};
+
+[[nodiscard]] GoodnessOfFitResult TestGoodnessOfFit(const EmpiricalDistribution& sample, const Distribution& dist);
+
+// Предельная функция распределения Колмогорова K(x) = P(sup |B(t)| <= x)
+[[nodiscard]] double KolmogorovCdf(double x);
+
+// 1 - K(x) без потери точности в хвосте
+[[nodiscard]] double KolmogorovSurvival(double x);
+
+// P(D_n < d) для выборки объёма n (Марсалья, Цанг, Ван, 2003); NaN, если матрица слишком велика
+[[nodiscard]] double KolmogorovExactCdf(std::size_t n, double d);
+
+} // namespace ptm
+
+#endif // PTM_GOODNESSOFFIT_HPP_
@@ -1,4 +1,6 @@
+#include <cmath>
 #include <stdexcept>
+#include "BatchKernels.hpp"
 #include "LaplaceDistribution.hpp"
 
 namespace ptm {
@@ -12,6 +14,10 @@ double LaplaceDistribution::Pdf(double x) const {
     return (1 / (2 * b_)) * std::exp(-std::abs(x - mu_) / b_);
 }
 
+double LaplaceDistribution::LogPdf(double x) const {
+    return -std::log(2 * b_) - std::abs(x - mu_) / b_;
+}
+
 double LaplaceDistribution::Cdf(double x) const {
     if (x < mu_) {
         return 0.5 * std::exp((x - mu_) / b_);
@@ -19,12 +25,33 @@ double LaplaceDistribution::Cdf(double x) const {
     return 1 - 0.5 * std::exp(-(x - mu_) / b_);
 }
 
-double LaplaceDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
-    double random_sign = (u < 0.5) ? -1 : 1;
+void LaplaceDistribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    LaplacePdfN(xs, out, mu_, b_);
+}
+
+void LaplaceDistribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    LaplaceLogPdfN(xs, out, mu_, b_);
+}
+
+void LaplaceDistribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    LaplaceCdfN(xs, out, mu_, b_);
+}
+
+double LaplaceDistribution::Sample(RngRef rng) const {
+    double u = rng.NextUniform() - 0.5;
+    double random_sign = (u < 0) ? -1 : 1;
     return mu_ - b_ * random_sign * std::log(1 - 2 * std::abs(u));
 }
 
+void LaplaceDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    for (double& x : out) {
+        const double u = x - 0.5;
+        const double random_sign = (u < 0) ? -1 : 1;
+        x = mu_ - b_ * random_sign * std::log(1 - 2 * std::abs(u));
+    }
+}
+
 double LaplaceDistribution::TheoreticalMean() const {
     return mu_;
 }
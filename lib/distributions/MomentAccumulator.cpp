@@ -0,0 +1,112 @@
+#include "MomentAccumulator.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace ptm {
+
+void MomentAccumulator::Push(double x) {
+    const double n1 = n_;
+    n_ += 1;
+    const double delta = x - mean_;
+    const double delta_n = delta / n_;
+    const double delta_n2 = delta_n * delta_n;
+    const double term1 = delta * delta_n * n1;
+
+    mean_ += delta_n;
+    m4_ += term1 * delta_n2 * (n_ * n_ - 3 * n_ + 3) + 6 * delta_n2 * m2_ - 4 * delta_n * m3_;
+    m3_ += term1 * delta_n * (n_ - 2) - 3 * delta_n * m2_;
+    m2_ += term1;
+}
+
+void MomentAccumulator::Push(std::span<const double> xs) {
+    if (xs.empty()) {
+        return;
+    }
+
+    MomentAccumulator chunk;
+    chunk.n_ = static_cast<double>(xs.size());
+
+    double sum = 0;
+    for (double x : xs) {
+        sum += x;
+    }
+    chunk.mean_ = sum / chunk.n_;
+
+    double s2 = 0;
+    double s3 = 0;
+    double s4 = 0;
+    for (double x : xs) {
+        const double d = x - chunk.mean_;
+        const double d2 = d * d;
+        s2 += d2;
+        s3 += d2 * d;
+        s4 += d2 * d2;
+    }
+    chunk.m2_ = s2;
+    chunk.m3_ = s3;
+    chunk.m4_ = s4;
+
+    Merge(chunk);
+}
+
+void MomentAccumulator::Merge(const MomentAccumulator& other) {
+    if (other.n_ == 0) {
+        return;
+    }
+    if (n_ == 0) {
+        *this = other;
+        return;
+    }
+
+    const double na = n_;
+    const double nb = other.n_;
+    const double n = na + nb;
+    const double delta = other.mean_ - mean_;
+    const double delta_n = delta / n;
+    const double delta_n2 = delta_n * delta_n;
+
+    const double m2 = m2_ + other.m2_ + delta * delta_n * na * nb;
+    const double m3 = m3_ + other.m3_ + delta * delta_n2 * na * nb * (na - nb) +
+                      3 * delta_n * (na * other.m2_ - nb * m2_);
+    const double m4 = m4_ + other.m4_ + delta * delta_n2 * delta_n * na * nb * (na * na - na * nb + nb * nb) +
+                      6 * delta_n2 * (na * na * other.m2_ + nb * nb * m2_) + 4 * delta_n * (na * other.m3_ - nb * m3_);
+
+    mean_ += delta_n * nb;
+    m2_ = m2;
+    m3_ = m3;
+    m4_ = m4;
+    n_ = n;
+}
+
+std::size_t MomentAccumulator::Count() const noexcept {
+    return static_cast<std::size_t>(n_);
+}
+
+double MomentAccumulator::Mean() const noexcept {
+    return n_ > 0 ? mean_ : std::numeric_limits<double>::quiet_NaN();
+}
+
+double MomentAccumulator::Variance() const noexcept {
+    return n_ > 0 ? m2_ / n_ : std::numeric_limits<double>::quiet_NaN();
+}
+
+double MomentAccumulator::UnbiasedVariance() const noexcept {
+    return n_ > 1 ? m2_ / (n_ - 1) : std::numeric_limits<double>::quiet_NaN();
+}
+
+double MomentAccumulator::Skewness() const noexcept {
+    if (n_ == 0 || m2_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return std::sqrt(n_) * m3_ / (m2_ * std::sqrt(m2_));
+}
+
+double MomentAccumulator::ExcessKurtosis() const noexcept {
+    if (n_ == 0 || m2_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return n_ * m4_ / (m2_ * m2_) - 3;
+}
+
+} // namespace ptm
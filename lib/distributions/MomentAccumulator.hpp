@@ -0,0 +1,45 @@
+#ifndef PTM_MOMENTACCUMULATOR_HPP_
+#define PTM_MOMENTACCUMULATOR_HPP_
+
+#include <cstddef>
+#include <span>
+
+namespace ptm {
+
+// Однопроходный накопитель центральных моментов до 4-го порядка за O(1) памяти.
+// Push(x) - обновление Уэлфорда/Терриберри, Push(span) - моменты куска в два векторизуемых прохода
+// и слияние, Merge - формулы Чана/Пебэя, поэтому накопители потоков и блоков можно сливать
+class MomentAccumulator {
+public:
+  MomentAccumulator() = default;
+
+  void Push(double x);
+  void Push(std::span<const double> xs);
+  void Merge(const MomentAccumulator& other);
+
+  [[nodiscard]] std::size_t Count() const noexcept;
+  [[nodiscard]] double Mean() const noexcept;
+
+  // Выборочная дисперсия с делением на n (как в ExperimentStats)
+  [[nodiscard]] double Variance() const noexcept;
+
+  // Несмещённая оценка дисперсии (деление на n - 1)
+  [[nodiscard]] double UnbiasedVariance() const noexcept;
+
+  // g1 = sqrt(n) M3 / M2^(3/2)
+  [[nodiscard]] double Skewness() const noexcept;
+
+  // g2 = n M4 / M2^2 - 3
+  [[nodiscard]] double ExcessKurtosis() const noexcept;
+
+private:
+  double n_ = 0;
+  double mean_ = 0;
+  double m2_ = 0;
+  double m3_ = 0;
+  double m4_ = 0;
+};
+
+} // namespace ptm
+
+#endif // PTM_MOMENTACCUMULATOR_HPP_
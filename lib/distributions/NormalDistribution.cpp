@@ -1,31 +1,93 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <stdexcept>
+#include "BatchKernels.hpp"
 #include "NormalDistribution.hpp"
+#include "Ziggurat.hpp"
 #include <numbers>
 
 namespace ptm {
-NormalDistribution::NormalDistribution(double mean, double stddev) : mean_(mean), stddev_(stddev) {
+NormalDistribution::NormalDistribution(double mean, double stddev, Method method) :
+    mean_(mean), stddev_(stddev), method_(method) {
     if (stddev <= 0) {
         throw std::invalid_argument("stddev must be positive");
     }
 }
 
 double NormalDistribution::Pdf(double x) const {
-    double coeff = std::exp(-0.5 * std::pow((x - mean_) / stddev_, 2));
-    return 1 / (std::sqrt(2 * std::numbers::pi) * stddev_) * coeff;
+    const double z = (x - mean_) / stddev_;
+    return std::exp(-0.5 * z * z) * (kInvSqrt2Pi / stddev_);
 }
 
+double NormalDistribution::LogPdf(double x) const {
+    const double z = (x - mean_) / stddev_;
+    return -0.5 * z * z - (std::log(stddev_) + kLogSqrt2Pi);
+}
+
+// erfc вместо 1 + erf: в левом хвосте нет вычитания близких чисел
 double NormalDistribution::Cdf(double x) const {
-    return 0.5 * (1 + std::erf((x - mean_) / (stddev_ * std::sqrt(2))));
+    return 0.5 * std::erfc(-(x - mean_) / (stddev_ * std::numbers::sqrt2));
+}
+
+void NormalDistribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    NormalPdfN(xs, out, mean_, stddev_);
+}
+
+void NormalDistribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    NormalLogPdfN(xs, out, mean_, stddev_);
 }
 
-double NormalDistribution::Sample(std::mt19937& rng) const {
-    double u1 = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
-    double u2 = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+// Своего векторного erfc нет - цикл по скалярной формуле, но без виртуального вызова
+void NormalDistribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        out[i] = NormalDistribution::Cdf(xs[i]);
+    }
+}
+
+double NormalDistribution::Sample(RngRef rng) const {
+    if (method_ == Method::Ziggurat) {
+        return mean_ + stddev_ * NormalZiggurat(rng(), rng, NormalZigguratTables());
+    }
+
+    double u1 = rng.NextUniform();
+    double u2 = rng.NextUniform();
 
     double z0 = std::sqrt(-2 * std::log(u1)) * std::cos(2 * std::numbers::pi * u2);
     return mean_ + stddev_ * z0;
 }
 
+// Бокс-Мюллер парами: из (u1, u2) берём обе координаты z0 = r cos(theta), z1 = r sin(theta)
+void NormalDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    if (method_ == Method::Ziggurat) {
+        const ZigguratTables& tables = NormalZigguratTables();
+        std::array<std::uint64_t, 256> bits{};
+
+        for (std::size_t offset = 0; offset < out.size(); offset += bits.size()) {
+            const std::size_t len = std::min(bits.size(), out.size() - offset);
+            rng.FillBits(std::span<std::uint64_t>(bits.data(), len));
+            for (std::size_t i = 0; i < len; ++i) {
+                out[offset + i] = mean_ + stddev_ * NormalZiggurat(bits[i], rng, tables);
+            }
+        }
+        return;
+    }
+
+    const std::size_t paired = out.size() - out.size() % 2;
+    rng.FillUniform(out.first(paired));
+
+    for (std::size_t i = 0; i < paired; i += 2) {
+        const double r = std::sqrt(-2 * std::log(out[i]));
+        const double theta = 2 * std::numbers::pi * out[i + 1];
+        out[i] = mean_ + stddev_ * r * std::cos(theta);
+        out[i + 1] = mean_ + stddev_ * r * std::sin(theta);
+    }
+
+    if (paired != out.size()) {
+        out.back() = Sample(rng);
+    }
+}
+
 double NormalDistribution::TheoreticalMean() const {
     return mean_;
 }
@@ -33,4 +95,8 @@ double NormalDistribution::TheoreticalMean() const {
 double NormalDistribution::TheoreticalVariance() const {
     return stddev_ * stddev_;
 }
+
+NormalDistribution::Method NormalDistribution::GetMethod() const {
+    return method_;
+}
 } // namespace ptm
@@ -10,21 +10,32 @@ namespace ptm {
 // Нормальное N(mu, sigma^2)
 class NormalDistribution : public Distribution {
 public:
-  NormalDistribution(double mean, double stddev);
+  // Способ генерации: Бокс-Мюллер (log, sqrt, cos на значение) или табличный зиккурат
+  enum class Method { BoxMuller, Ziggurat }; // NOLINT
+
+  NormalDistribution(double mean, double stddev, Method method = Method::BoxMuller);
 
   [[nodiscard]] double Pdf(double x) const override;
+  [[nodiscard]] double LogPdf(double x) const override;
   [[nodiscard]] double Cdf(double x) const override;
-  double Sample(std::mt19937& rng) const override;
+  void PdfN(std::span<const double> xs, std::span<double> out) const override;
+  void LogPdfN(std::span<const double> xs, std::span<double> out) const override;
+  void CdfN(std::span<const double> xs, std::span<double> out) const override;
+  double Sample(RngRef rng) const override;
+  void SampleN(std::span<double> out, RngRef rng) const override;
+  using Distribution::SampleN;
 
   [[nodiscard]] double TheoreticalMean() const override;
   [[nodiscard]] double TheoreticalVariance() const override;
 
   [[nodiscard]] double GetMean() const;
   [[nodiscard]] double GetStddev() const;
+  [[nodiscard]] Method GetMethod() const;
 
 private:
   double mean_;
   double stddev_;
+  Method method_;
 };
 
 } // namespace ptm
@@ -1,5 +1,7 @@
+#include <cmath>
 #include <stdexcept>
 #include "PoissonDistribution.hpp"
+#include "UniformRandom.hpp"
 
 namespace ptm {
 PoissonDistribution::PoissonDistribution(double lambda) : lambda_(lambda) {
@@ -36,18 +38,32 @@ double PoissonDistribution::Cdf(double x) const {
     return sum;
 }
 
-double PoissonDistribution::Sample(std::mt19937& rng) const {
+double PoissonDistribution::Sample(RngRef rng) const {
     double l = std::exp(-lambda_);
     int k = 0;
     double p = 1;
 
     while (p > l) {
         ++k;
-        p *= (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+        p *= rng.NextUniform();
     }
     return static_cast<double>(k - 1);
 }
 
+void PoissonDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    const double l = std::exp(-lambda_);
+    UniformBuffer uniforms(rng);
+    for (double& x : out) {
+        int k = 0;
+        double p = 1;
+        while (p > l) {
+            ++k;
+            p *= uniforms.Next();
+        }
+        x = static_cast<double>(k - 1);
+    }
+}
+
 double PoissonDistribution::TheoreticalMean() const {
     return lambda_;
 }
@@ -1,16 +1,26 @@
 #include <cmath>
+#include <limits>
 #include <stdexcept>
+#include "BatchKernels.hpp"
 #include "UniformDistribution.hpp"
 
 namespace ptm {
 UniformDistribution::UniformDistribution(double a, double b) : a_(a), b_(b) {}
 
 double UniformDistribution::Pdf(double x) const {
-     if ( a_ <= x <= b_) {
+    if (x >= a_ && x <= b_) {
         return 1 / (b_ - a_);
-     }
+    }
 
-     return 0;
+    return 0;
+}
+
+double UniformDistribution::LogPdf(double x) const {
+    if (x >= a_ && x <= b_) {
+        return -std::log(b_ - a_);
+    }
+
+    return -std::numeric_limits<double>::infinity();
 }
 
 double UniformDistribution::Cdf(double x) const {
@@ -25,11 +35,31 @@ double UniformDistribution::Cdf(double x) const {
     return (x - a_) / (b_ - a_);
 }
 
-double UniformDistribution::Sample(std::mt19937& rng) const {
-    double u = (static_cast<double>(rng()) + 0.5) / (static_cast<double>(rng.max()) + 1);
+void UniformDistribution::PdfN(std::span<const double> xs, std::span<double> out) const {
+    UniformPdfN(xs, out, a_, b_);
+}
+
+void UniformDistribution::LogPdfN(std::span<const double> xs, std::span<double> out) const {
+    UniformLogPdfN(xs, out, a_, b_);
+}
+
+void UniformDistribution::CdfN(std::span<const double> xs, std::span<double> out) const {
+    UniformCdfN(xs, out, a_, b_);
+}
+
+double UniformDistribution::Sample(RngRef rng) const {
+    double u = rng.NextUniform();
     return a_ + (b_ - a_) * u;
 }
 
+void UniformDistribution::SampleN(std::span<double> out, RngRef rng) const {
+    rng.FillUniform(out);
+    const double width = b_ - a_;
+    for (double& x : out) {
+        x = a_ + width * x;
+    }
+}
+
 double UniformDistribution::TheoreticalMean() const {
     return (a_ + b_) / 2;
 }
@@ -0,0 +1,37 @@
+#ifndef PTM_UNIFORMRANDOM_HPP_
+#define PTM_UNIFORMRANDOM_HPP_
+
+#include <array>
+#include <cstddef>
+
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Буфер U(0, 1) для методов с заранее неизвестным числом равномерных величин на значение
+// (Пуассон, биномиальное): генератор дергается блоками по kSize, а не по одному значению.
+// Неиспользованный хвост блока пропадает вместе с буфером
+class UniformBuffer {
+public:
+  explicit UniformBuffer(RngRef rng) : rng_(rng) {
+  }
+
+  double Next() {
+    if (pos_ == kSize) {
+      rng_.FillUniform(buffer_);
+      pos_ = 0;
+    }
+    return buffer_[pos_++];
+  }
+
+private:
+  static constexpr std::size_t kSize = 256;
+
+  RngRef rng_;
+  std::array<double, kSize> buffer_{};
+  std::size_t pos_ = kSize;
+};
+
+} // namespace ptm
+
+#endif // PTM_UNIFORMRANDOM_HPP_
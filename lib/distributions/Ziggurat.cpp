@@ -0,0 +1,128 @@
+#include "Ziggurat.hpp"
+
+#include <cmath>
+
+namespace ptm {
+
+namespace {
+
+// Правая граница основания r и площадь одного слоя v для 256 слоёв
+constexpr double kNormalR = 3.6541528853610088;
+constexpr double kNormalV = 4.92867323399e-3;
+constexpr double kExponentialR = 7.697117470131487;
+constexpr double kExponentialV = 3.949659822581572e-3;
+
+ZigguratTables BuildNormalTables() {
+    constexpr double m = 4503599627370496.0; // 2^52
+    auto f = [](double x) { return std::exp(-0.5 * x * x); };
+
+    ZigguratTables t{};
+    double dn = kNormalR;
+    double tn = dn;
+    const double q = kNormalV / f(dn);
+
+    t.k[0] = static_cast<std::uint64_t>((dn / q) * m);
+    t.k[1] = 0;
+    t.w[0] = q / m;
+    t.w[255] = dn / m;
+    t.f[0] = 1;
+    t.f[255] = f(dn);
+
+    for (std::size_t i = 254; i >= 1; --i) {
+        dn = std::sqrt(-2 * std::log(kNormalV / dn + f(dn)));
+        t.k[i + 1] = static_cast<std::uint64_t>((dn / tn) * m);
+        tn = dn;
+        t.f[i] = f(dn);
+        t.w[i] = dn / m;
+    }
+    return t;
+}
+
+ZigguratTables BuildExponentialTables() {
+    constexpr double m = 9007199254740992.0; // 2^53
+
+    ZigguratTables t{};
+    double de = kExponentialR;
+    double te = de;
+    const double q = kExponentialV / std::exp(-de);
+
+    t.k[0] = static_cast<std::uint64_t>((de / q) * m);
+    t.k[1] = 0;
+    t.w[0] = q / m;
+    t.w[255] = de / m;
+    t.f[0] = 1;
+    t.f[255] = std::exp(-de);
+
+    for (std::size_t i = 254; i >= 1; --i) {
+        de = -std::log(kExponentialV / de + std::exp(-de));
+        t.k[i + 1] = static_cast<std::uint64_t>((de / te) * m);
+        te = de;
+        t.f[i] = std::exp(-de);
+        t.w[i] = de / m;
+    }
+    return t;
+}
+
+} // namespace
+
+const ZigguratTables& NormalZigguratTables() {
+    static const ZigguratTables tables = BuildNormalTables();
+    return tables;
+}
+
+const ZigguratTables& ExponentialZigguratTables() {
+    static const ZigguratTables tables = BuildExponentialTables();
+    return tables;
+}
+
+double NormalZigguratSlow(RngRef rng, const ZigguratTables& t, std::size_t idx, double x, bool negative) {
+    for (;;) {
+        if (idx == 0) {
+            // Хвост за r: метод Марсальи
+            for (;;) {
+                const double xx = -std::log(rng.NextUniform()) / kNormalR;
+                const double yy = -std::log(rng.NextUniform());
+                if (yy + yy > xx * xx) {
+                    return negative ? -(kNormalR + xx) : kNormalR + xx;
+                }
+            }
+        }
+
+        if ((t.f[idx - 1] - t.f[idx]) * rng.NextUniform() + t.f[idx] < std::exp(-0.5 * x * x)) {
+            return negative ? -x : x;
+        }
+
+        std::uint64_t r = rng();
+        idx = r & 0xff;
+        r >>= 8;
+        negative = (r & 1) != 0;
+        const std::uint64_t rabs = (r >> 1) & 0x000fffffffffffffULL;
+        x = static_cast<double>(rabs) * t.w[idx];
+        if (rabs < t.k[idx]) {
+            return negative ? -x : x;
+        }
+    }
+}
+
+double ExponentialZigguratSlow(RngRef rng, const ZigguratTables& t, std::size_t idx, double x) {
+    for (;;) {
+        if (idx == 0) {
+            // Отсутствие памяти: хвост за r - это r + Exp(1)
+            return kExponentialR - std::log(rng.NextUniform());
+        }
+
+        if ((t.f[idx - 1] - t.f[idx]) * rng.NextUniform() + t.f[idx] < std::exp(-x)) {
+            return x;
+        }
+
+        std::uint64_t r = rng() >> 3;
+        idx = r & 0xff;
+        r >>= 8;
+        x = static_cast<double>(r) * t.w[idx];
+        if (r < t.k[idx]) {
+            return x;
+        }
+    }
+}
+
+} // namespace ptm
@@ -0,0 +1,60 @@
+#ifndef PTM_ZIGGURAT_HPP_
+#define PTM_ZIGGURAT_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Таблицы зиккурата на 256 слоёв (Marsaglia, Tsang, 2000).
+// Слой i >= 1 - прямоугольник [0, x_i] x [f_i, f_{i-1}], слой 0 - основание вместе с хвостом.
+// k[i] - порог x_{i-1} / x_i в единицах мантиссы, w[i] = x_i / 2^bits, f[i] = f(x_i)
+struct ZigguratTables {
+  std::array<std::uint64_t, 256> k;
+  std::array<double, 256> w;
+  std::array<double, 256> f;
+};
+
+// Таблицы строятся один раз на процесс и разделяются всеми экземплярами распределений
+const ZigguratTables& NormalZigguratTables();
+const ZigguratTables& ExponentialZigguratTables();
+
+// Медленные ветки (клин и хвост), вызываются с вероятностью ~1%
+double NormalZigguratSlow(RngRef rng, const ZigguratTables& t, std::size_t idx, double x, bool negative);
+double ExponentialZigguratSlow(RngRef rng, const ZigguratTables& t, std::size_t idx, double x);
+
+// Стандартное нормальное N(0, 1) из 64 случайных бит bits: 8 бит на слой, 1 бит на знак, 52 бита на координату.
+// rng нужен только в медленной ветке, поэтому bits можно заранее набрать блоком через RngRef::FillBits
+inline double NormalZiggurat(std::uint64_t bits, RngRef rng, const ZigguratTables& t) {
+  std::uint64_t r = bits;
+  const std::size_t idx = r & 0xff;
+  r >>= 8;
+  const bool negative = (r & 1) != 0;
+  const std::uint64_t rabs = (r >> 1) & 0x000fffffffffffffULL;
+
+  const double x = static_cast<double>(rabs) * t.w[idx];
+  if (rabs < t.k[idx]) {
+    return negative ? -x : x;
+  }
+  return NormalZigguratSlow(rng, t, idx, x, negative);
+}
+
+// Стандартное экспоненциальное Exp(1) из 64 случайных бит bits: 8 бит на слой, 53 бита на координату
+inline double ExponentialZiggurat(std::uint64_t bits, RngRef rng, const ZigguratTables& t) {
+  std::uint64_t r = bits >> 3;
+  const std::size_t idx = r & 0xff;
+  r >>= 8;
+
+  const double x = static_cast<double>(r) * t.w[idx];
+  if (r < t.k[idx]) {
+    return x;
+  }
+  return ExponentialZigguratSlow(rng, t, idx, x);
+}
+
+} // namespace ptm
+
+#endif // PTM_ZIGGURAT_HPP_
@@ -1,28 +1,100 @@
 #include "LawOfLargeNumbersSimulator.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <limits>
 #include <stdexcept>
 #include <utility>
+#include <vector>
+
+#include "parallel/ParallelFor.hpp"
 
 namespace ptm {
 
     LawOfLargeNumbersSimulator::LawOfLargeNumbersSimulator(std::shared_ptr<Distribution> dist) : dist_(std::move(dist)) { }
 
-    LLNPathResult LawOfLargeNumbersSimulator::Simulate(std::mt19937& rng, size_t max_n, size_t step) const {
+    LLNPathResult LawOfLargeNumbersSimulator::Simulate(RngRef rng, size_t max_n, size_t step) const {
         double mu = dist_->TheoreticalMean();
         LLNPathResult result;
-        double sum = 0.0;
+        MomentAccumulator moments;
+
+        // Сэмплы генерируются блоками через SampleN; в накопитель уходят куски между соседними точками n = k * step
+        constexpr size_t kBlockSize = 4096;
+        std::array<double, kBlockSize> block{};
+
+        for (size_t n = 0; n < max_n;) {
+            const size_t len = std::min(kBlockSize, max_n - n);
+            dist_->SampleN(std::span<double>(block.data(), len), rng);
+
+            for (size_t i = 0; i < len;) {
+                const size_t take = std::min(step - n % step, len - i);
+                moments.Push(std::span<const double>(block.data() + i, take));
+                i += take;
+                n += take;
+
+                if (n % step == 0) {
+                    double mean = moments.Mean();
+                    double err = std::abs(mean - mu);
 
-        for (size_t n = 1; n <= max_n; ++n) {
-            sum += static_cast<double>(dist_->Sample(rng));
+                    result.entries.push_back(LLNPathEntry{.n = n, .sample_mean = mean, .abs_error = err,});
+                }
+            }
+        }
+
+        return result;
+    }
+
+    LLNPathResult LawOfLargeNumbersSimulator::Simulate(const StreamKey& key, size_t max_n, size_t step,
+                                                       size_t num_threads) const {
+        const size_t num_blocks = (max_n + kStreamBlockSize - 1) / kStreamBlockSize;
+
+        // Для каждого блока: накопитель всего блока и локальные накопители в точках n, кратных step
+        struct BlockMoments {
+            MomentAccumulator total;
+            std::vector<MomentAccumulator> checkpoints;
+        };
+        std::vector<BlockMoments> blocks(num_blocks);
+
+        ParallelFor(num_blocks, num_threads, [&](size_t b) {
+            const size_t begin = b * kStreamBlockSize;
+            const size_t len = std::min(kStreamBlockSize, max_n - begin);
+
+            std::vector<double> samples(len);
+            Philox4x32 rng = BlockRng(key, static_cast<std::uint32_t>(b));
+            dist_->SampleN(samples, rng);
+
+            MomentAccumulator local;
+            for (size_t i = 0; i < len;) {
+                const size_t n = begin + i;
+                const size_t take = std::min(step - n % step, len - i);
+                local.Push(std::span<const double>(samples.data() + i, take));
+                i += take;
+
+                if ((n + take) % step == 0) {
+                    blocks[b].checkpoints.push_back(local);
+                }
+            }
+            blocks[b].total = local;
+        });
+
+        const double mu = dist_->TheoreticalMean();
+        LLNPathResult result;
+        result.entries.reserve(max_n / step);
 
-            if (n % step == 0) {
-                double mean = static_cast<double>(sum / static_cast<double>(n));
-                double err = std::abs(mean - mu);
+        MomentAccumulator prefix;
+        for (size_t b = 0; b < num_blocks; ++b) {
+            const size_t begin = b * kStreamBlockSize;
+            size_t n = (begin / step + 1) * step;
 
-                result.entries.push_back(LLNPathEntry{.n = n, .sample_mean = mean, .abs_error = err,});
+            for (const auto& local : blocks[b].checkpoints) {
+                MomentAccumulator at = prefix;
+                at.Merge(local);
+                const double mean = at.Mean();
+                result.entries.push_back(LLNPathEntry{.n = n, .sample_mean = mean, .abs_error = std::abs(mean - mu),});
+                n += step;
             }
+            prefix.Merge(blocks[b].total);
         }
 
         return result;
@@ -6,6 +6,8 @@
 
 #include "LLNPathResult.hpp"
 #include "distributions/Distribution.hpp"
+#include "distributions/MomentAccumulator.hpp"
+#include "random/CounterStreams.hpp"
 
 namespace ptm {
 class Distribution;
@@ -20,10 +22,15 @@ public:
   // - step: шаг, через который будем сохранять статистику (например, 100, 1000,...)
   //
   // Алгоритм:
-  // 1) генерируем X_1, ..., X_max_n
-  // 2) считаем префиксные суммы и выборочные средние
+  // 1) генерируем X_1, ..., X_max_n блоками через Distribution::SampleN
+  // 2) сворачиваем их в MomentAccumulator и берём выборочные средние
   // 3) для n кратных step сохраняем (n, mean_n, |mean_n - mu|)
-  LLNPathResult Simulate(std::mt19937& rng, size_t max_n, size_t step) const;
+  LLNPathResult Simulate(RngRef rng, size_t max_n, size_t step) const;
+
+  // Параллельный воспроизводимый вариант: X_1..X_max_n режутся на блоки по kStreamBlockSize,
+  // блок b генерируется потоком BlockRng(key, b) и сворачивается в свой MomentAccumulator, затем
+  // накопители блоков сливаются по порядку. Результат побитово одинаков при любом num_threads (0 - по числу ядер)
+  LLNPathResult Simulate(const StreamKey& key, size_t max_n, size_t step, size_t num_threads) const;
 
   // Доступ к распределению
   [[nodiscard]] std::shared_ptr<Distribution> GetDistribution() const noexcept;
@@ -0,0 +1,48 @@
+#include "AliasTable.hpp"
+
+#include <vector>
+
+namespace ptm {
+
+void BuildAliasTable(std::span<const std::size_t> weights, std::span<AliasSlot> slots) {
+    const std::size_t k = weights.size();
+    std::size_t total = 0;
+    for (std::size_t w : weights) {
+        total += w;
+    }
+
+    // Масштабированный вес w * k сравнивается с ёмкостью ячейки total
+    std::vector<std::uint64_t> scaled(k);
+    std::vector<std::uint32_t> small;
+    std::vector<std::uint32_t> large;
+    for (std::size_t i = 0; i < k; ++i) {
+        scaled[i] = static_cast<std::uint64_t>(weights[i]) * k;
+        (scaled[i] < total ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const std::uint32_t s = small.back();
+        small.pop_back();
+        const std::uint32_t l = large.back();
+
+        slots[s].threshold = static_cast<double>(scaled[s]) / static_cast<double>(total);
+        slots[s].alias = l;
+
+        // Большая ячейка отдаёт недостающее малой и может сама стать малой
+        scaled[l] -= total - scaled[s];
+        if (scaled[l] < total) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Оставшиеся ячейки заполнены ровно - в целых числах остаток всегда точный
+    for (std::uint32_t l : large) {
+        slots[l] = {1, l};
+    }
+    for (std::uint32_t s : small) {
+        slots[s] = {1, s};
+    }
+}
+
+} // namespace ptm
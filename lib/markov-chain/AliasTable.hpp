@@ -0,0 +1,42 @@
+#ifndef PTM_ALIASTABLE_HPP_
+#define PTM_ALIASTABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Ячейка таблицы Уолкера: с вероятностью threshold выпадает сама ячейка, иначе - ячейка alias
+struct AliasSlot {
+  double threshold = 1;
+  std::uint32_t alias = 0;
+};
+
+// Построение таблицы по целым весам методом Воуза за O(k). Доли считаются в целых числах
+// (вес * k против суммы весов), поэтому накопленной ошибки округления нет. Веса не все нулевые,
+// slots.size() == weights.size() < 2^32
+void BuildAliasTable(std::span<const std::size_t> weights, std::span<AliasSlot> slots);
+
+// Индекс ячейки с вероятностью weights[i] / sum за O(1) из одного 64-битного слова:
+// старшая часть bits * k - номер ячейки, младшая - равномерная дробь для сравнения с порогом
+inline std::uint32_t SampleAlias(std::span<const AliasSlot> slots, RngRef rng) {
+  const std::uint64_t bits = rng();
+  const std::uint64_t k = slots.size();
+
+  // bits * k как 96-битное произведение без расширений компилятора: k < 2^32
+  const std::uint64_t lo_product = (bits & 0xffffffffULL) * k;
+  const std::uint64_t hi_product = (bits >> 32) * k;
+  const std::uint64_t mid = hi_product + (lo_product >> 32);
+  const auto slot = static_cast<std::uint32_t>(mid >> 32);
+  const std::uint64_t fraction = (mid << 32) | (lo_product & 0xffffffffULL);
+
+  const double u = static_cast<double>(fraction >> 11) * 0x1.0p-53;
+  return u < slots[slot].threshold ? slot : slots[slot].alias;
+}
+
+} // namespace ptm
+
+#endif // PTM_ALIASTABLE_HPP_
@@ -0,0 +1,284 @@
+#include "ChainAnalysis.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "parallel/ParallelFor.hpp"
+
+namespace ptm {
+
+namespace {
+
+// Строк на задачу параллельного шага; меньшие цепи считаются в одном потоке
+constexpr std::size_t kRowsPerBlock = 4096;
+
+// fn(begin, end, block) для блоков строк [0, n); блоки не пересекаются
+template <typename F>
+void ForEachBlock(std::size_t n, std::size_t num_threads, F&& fn) {
+    const std::size_t num_blocks = (n + kRowsPerBlock - 1) / kRowsPerBlock;
+    ParallelFor(num_blocks, num_threads, [&](std::size_t block) {
+        fn(block * kRowsPerBlock, std::min(n, (block + 1) * kRowsPerBlock), block);
+    });
+}
+
+void CheckSize(std::size_t size, const TransitionOperator& op) {
+    if (size != op.NumStates()) {
+        throw std::invalid_argument("distribution size must equal the number of states");
+    }
+}
+
+} // namespace
+
+TransitionOperator::TransitionOperator(const CsrTransitions& counts) {
+    const std::size_t n = counts.NumRows();
+
+    // Число входящих переходов каждого j; тупик получает петлю
+    std::vector<std::size_t> incoming(n, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto columns = counts.RowColumns(i);
+        if (columns.empty()) {
+            ++incoming[i];
+        }
+        for (std::uint32_t j : columns) {
+            ++incoming[j];
+        }
+    }
+
+    in_offsets_.resize(n + 1);
+    for (std::size_t j = 0; j < n; ++j) {
+        in_offsets_[j + 1] = in_offsets_[j] + incoming[j];
+    }
+    sources_.resize(in_offsets_[n]);
+    probabilities_.resize(in_offsets_[n]);
+
+    // Обход строк по возрастанию i: источники каждого столбца идут по порядку, порядок суммирования фиксирован
+    std::vector<std::size_t> cursor(in_offsets_.begin(), in_offsets_.end() - 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto columns = counts.RowColumns(i);
+        const auto row_counts = counts.RowCounts(i);
+        if (columns.empty()) {
+            sources_[cursor[i]] = static_cast<std::uint32_t>(i);
+            probabilities_[cursor[i]++] = 1.0;
+            continue;
+        }
+        const auto sum = static_cast<double>(counts.row_sums[i]);
+        for (std::size_t k = 0; k < columns.size(); ++k) {
+            const std::uint32_t j = columns[k];
+            sources_[cursor[j]] = static_cast<std::uint32_t>(i);
+            probabilities_[cursor[j]++] = static_cast<double>(row_counts[k]) / sum;
+        }
+    }
+}
+
+std::size_t TransitionOperator::NumStates() const noexcept {
+    return in_offsets_.size() - 1;
+}
+
+void TransitionOperator::Apply(std::span<const double> in, std::span<double> out, std::size_t num_threads) const {
+    CheckSize(in.size(), *this);
+    CheckSize(out.size(), *this);
+
+    ForEachBlock(NumStates(), num_threads, [&](std::size_t begin, std::size_t end, std::size_t /*block*/) {
+        for (std::size_t j = begin; j < end; ++j) {
+            double sum = 0.0;
+            for (std::size_t k = in_offsets_[j]; k < in_offsets_[j + 1]; ++k) {
+                sum += in[sources_[k]] * probabilities_[k];
+            }
+            out[j] = sum;
+        }
+    });
+}
+
+std::vector<double> Propagate(const TransitionOperator& op, std::span<const double> initial, std::size_t steps,
+                              std::size_t num_threads) {
+    CheckSize(initial.size(), op);
+
+    std::vector<double> current(initial.begin(), initial.end());
+    std::vector<double> next(current.size());
+    for (std::size_t t = 0; t < steps; ++t) {
+        op.Apply(current, next, num_threads);
+        current.swap(next);
+    }
+    return current;
+}
+
+StationaryResult StationaryDistribution(const TransitionOperator& op, double tolerance, std::size_t max_iterations,
+                                        std::size_t num_threads) {
+    const std::size_t n = op.NumStates();
+    StationaryResult result;
+    if (n == 0) {
+        result.converged = true;
+        return result;
+    }
+
+    std::vector<double> pi(n, 1.0 / static_cast<double>(n));
+    std::vector<double> stepped(n);
+    const std::size_t num_blocks = (n + kRowsPerBlock - 1) / kRowsPerBlock;
+    std::vector<double> partial_residual(num_blocks);
+    std::vector<double> partial_mass(num_blocks);
+
+    for (result.iterations = 1; result.iterations <= max_iterations; ++result.iterations) {
+        op.Apply(pi, stepped, num_threads);
+
+        // Шаг ленивой цепи и невязка по блокам; частичные суммы складываются по порядку блоков
+        ForEachBlock(n, num_threads, [&](std::size_t begin, std::size_t end, std::size_t block) {
+            double residual = 0.0;
+            double mass = 0.0;
+            for (std::size_t j = begin; j < end; ++j) {
+                residual += std::abs(stepped[j] - pi[j]);
+                pi[j] = 0.5 * (pi[j] + stepped[j]);
+                mass += pi[j];
+            }
+            partial_residual[block] = residual;
+            partial_mass[block] = mass;
+        });
+
+        double residual = 0.0;
+        double mass = 0.0;
+        for (std::size_t b = 0; b < num_blocks; ++b) {
+            residual += partial_residual[b];
+            mass += partial_mass[b];
+        }
+
+        // Перенормировка не даёт накопиться дрейфу массы от округлений
+        for (double& p : pi) {
+            p /= mass;
+        }
+
+        result.residual = residual;
+        if (residual <= tolerance) {
+            result.converged = true;
+            break;
+        }
+    }
+    result.iterations = std::min(result.iterations, max_iterations);
+    result.distribution = std::move(pi);
+    return result;
+}
+
+std::optional<std::size_t> MixingTime(const TransitionOperator& op, std::span<const double> stationary,
+                                      std::span<const std::uint32_t> starts, double epsilon, std::size_t max_steps,
+                                      std::size_t num_threads) {
+    CheckSize(stationary.size(), op);
+    const std::size_t n = op.NumStates();
+    constexpr std::size_t kNotMixed = std::numeric_limits<std::size_t>::max();
+
+    // Каждый старт - своя последовательная цепочка шагов, параллельны сами старты
+    std::vector<std::size_t> times(starts.size(), kNotMixed);
+    ParallelFor(starts.size(), num_threads, [&](std::size_t s) {
+        if (starts[s] >= n) {
+            throw std::invalid_argument("start state is out of range");
+        }
+        std::vector<double> current(n, 0.0);
+        std::vector<double> next(n);
+        current[starts[s]] = 1.0;
+        for (std::size_t t = 0; t <= max_steps; ++t) {
+            double distance = 0.0;
+            for (std::size_t j = 0; j < n; ++j) {
+                distance += std::abs(current[j] - stationary[j]);
+            }
+            if (0.5 * distance <= epsilon) {
+                times[s] = t;
+                return;
+            }
+            op.Apply(current, next, 1);
+            current.swap(next);
+        }
+    });
+
+    std::size_t worst = 0;
+    for (std::size_t t : times) {
+        if (t == kNotMixed) {
+            return std::nullopt;
+        }
+        worst = std::max(worst, t);
+    }
+    return worst;
+}
+
+std::size_t ChainStructure::NumClasses() const noexcept {
+    return closed.size();
+}
+
+bool ChainStructure::IsIrreducible() const noexcept {
+    return closed.size() == 1;
+}
+
+ChainStructure AnalyzeStructure(const CsrTransitions& counts) {
+    const std::size_t n = counts.NumRows();
+    constexpr std::uint32_t kUnvisited = std::numeric_limits<std::uint32_t>::max();
+
+    ChainStructure result;
+    result.component.assign(n, kUnvisited);
+
+    std::vector<std::uint32_t> index(n, kUnvisited);
+    std::vector<std::uint32_t> low(n, 0);
+    std::vector<bool> on_stack(n, false);
+    std::vector<std::uint32_t> stack;
+    // Кадр обхода в глубину: вершина и позиция следующего ребра в её строке CSR
+    std::vector<std::pair<std::uint32_t, std::size_t>> frames;
+    std::uint32_t next_index = 0;
+    std::uint32_t next_component = 0;
+
+    for (std::size_t root = 0; root < n; ++root) {
+        if (index[root] != kUnvisited) {
+            continue;
+        }
+        frames.emplace_back(static_cast<std::uint32_t>(root), counts.row_offsets[root]);
+        index[root] = low[root] = next_index++;
+        stack.push_back(static_cast<std::uint32_t>(root));
+        on_stack[root] = true;
+
+        while (!frames.empty()) {
+            auto& [v, edge] = frames.back();
+            if (edge < counts.row_offsets[v + 1]) {
+                const std::uint32_t w = counts.columns[edge++];
+                if (index[w] == kUnvisited) {
+                    index[w] = low[w] = next_index++;
+                    stack.push_back(w);
+                    on_stack[w] = true;
+                    frames.emplace_back(w, counts.row_offsets[w]);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            // Все рёбра v пройдены: v - корень класса, если из поддерева нет ребра выше
+            const std::uint32_t finished = v;
+            frames.pop_back();
+            if (!frames.empty()) {
+                const std::uint32_t parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[finished]);
+            }
+            if (low[finished] == index[finished]) {
+                std::uint32_t w = 0;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    result.component[w] = next_component;
+                } while (w != finished);
+                ++next_component;
+            }
+        }
+    }
+
+    result.closed.assign(next_component, true);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto columns = counts.RowColumns(i);
+        for (std::uint32_t j : columns) {
+            if (result.component[j] != result.component[i]) {
+                result.closed[result.component[i]] = false;
+            }
+        }
+        if (columns.empty() || (columns.size() == 1 && columns[0] == i)) {
+            result.absorbing.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    return result;
+}
+
+} // namespace ptm
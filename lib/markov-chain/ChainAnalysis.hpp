@@ -0,0 +1,74 @@
+#ifndef PTM_CHAINANALYSIS_HPP_
+#define PTM_CHAINANALYSIS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "TransitionTable.hpp"
+
+namespace ptm {
+
+// Матрица переходов P, p_ij = c_ij / sum_j c_ij, в транспонированном CSR: для каждого j - входящие
+// переходы (i, p_ij). Так шаг pi' = pi P считается "сбором": каждый pi'_j - сумма по своей строке,
+// строки делятся между потоками без общих записей, и результат не зависит от числа потоков.
+// Состояние без исходящих переходов считается поглощающим (p_ii = 1), чтобы P оставалась стохастической
+class TransitionOperator {
+public:
+  explicit TransitionOperator(const CsrTransitions& counts);
+
+  [[nodiscard]] std::size_t NumStates() const noexcept;
+
+  // out = in * P; in и out одного размера NumStates() и не пересекаются
+  void Apply(std::span<const double> in, std::span<double> out, std::size_t num_threads = 1) const;
+
+private:
+  std::vector<std::size_t> in_offsets_ = {0};
+  std::vector<std::uint32_t> sources_;
+  std::vector<double> probabilities_;
+};
+
+// Распределение после steps шагов из initial: initial * P^steps. Строка P^n для состояния i -
+// Propagate от единичного вектора e_i. O(steps * nnz)
+std::vector<double> Propagate(const TransitionOperator& op, std::span<const double> initial, std::size_t steps,
+                              std::size_t num_threads = 1);
+
+struct StationaryResult {
+  std::vector<double> distribution;
+  std::size_t iterations = 0;
+  double residual = 0; // ||pi P - pi||_1 на последней итерации
+  bool converged = false;
+};
+
+// Стационарное распределение степенным методом для "ленивой" цепи (P + I) / 2: у неё те же
+// стационарные распределения, но нет периодичности, поэтому итерации сходятся и на периодических цепях.
+// Старт - равномерное распределение; у разложимой цепи результат - смесь стационарных распределений
+// замкнутых классов с весами, которые даёт этот старт
+StationaryResult StationaryDistribution(const TransitionOperator& op, double tolerance = 1e-12,
+                                        std::size_t max_iterations = 100000, std::size_t num_threads = 1);
+
+// Время перемешивания: наименьшее t, при котором из каждого состояния starts расстояние по вариации
+// между e_s P^t и stationary не больше epsilon. std::nullopt, если за max_steps не достигнуто.
+// Старты считаются параллельно
+std::optional<std::size_t> MixingTime(const TransitionOperator& op, std::span<const double> stationary,
+                                      std::span<const std::uint32_t> starts, double epsilon = 0.25,
+                                      std::size_t max_steps = 10000, std::size_t num_threads = 1);
+
+// Сообщающиеся классы (компоненты сильной связности графа переходов)
+struct ChainStructure {
+  std::vector<std::uint32_t> component;   // класс каждого состояния
+  std::vector<bool> closed;               // класс замкнут: из него нет переходов наружу (возвратный)
+  std::vector<std::uint32_t> absorbing;   // состояния, из которых переходят только в себя (или никуда)
+
+  [[nodiscard]] std::size_t NumClasses() const noexcept;
+  [[nodiscard]] bool IsIrreducible() const noexcept;
+};
+
+// Итеративный алгоритм Тарьяна за O(|V| + nnz), без рекурсии
+ChainStructure AnalyzeStructure(const CsrTransitions& counts);
+
+} // namespace ptm
+
+#endif // PTM_CHAINANALYSIS_HPP_
@@ -0,0 +1,124 @@
+#ifndef PTM_FLATHASHMAP_HPP_
+#define PTM_FLATHASHMAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ptm {
+
+// Хеш-таблица с 64-битным ключом для счётчиков и рёбер: открытая адресация, линейное пробирование,
+// ключ и значение лежат рядом в одном массиве - вставка не выделяет память на элемент, поиск обычно
+// стоит одного промаха кеша. Ключ kEmptyKey зарезервирован (у ключей вида a << 32 | b с a, b < 2^32 - 1
+// он не встречается). Заполнение не выше 1/2
+template <typename V>
+class FlatHashMap {
+public:
+  static constexpr std::uint64_t kEmptyKey = ~std::uint64_t{0};
+
+  struct Entry {
+    std::uint64_t key = kEmptyKey;
+    V value{};
+  };
+
+  FlatHashMap() : entries_(kInitialEntries) {
+  }
+
+  // Значение по ключу; новый ключ получает value. second - была ли вставка
+  std::pair<V*, bool> TryEmplace(std::uint64_t key, const V& value) {
+    std::size_t pos = Probe(key);
+    if (entries_[pos].key == key) {
+      return {&entries_[pos].value, false};
+    }
+    if (2 * (size_ + 1) > entries_.size()) {
+      Grow();
+      pos = Probe(key);
+    }
+    entries_[pos] = {key, value};
+    ++size_;
+    return {&entries_[pos].value, true};
+  }
+
+  V& operator[](std::uint64_t key) {
+    return *TryEmplace(key, V{}).first;
+  }
+
+  [[nodiscard]] const V* Find(std::uint64_t key) const noexcept {
+    const Entry& entry = entries_[Probe(key)];
+    return entry.key == key ? &entry.value : nullptr;
+  }
+
+  // Обход занятых ячеек в порядке таблицы
+  template <typename F>
+  void ForEach(F&& fn) const {
+    for (const Entry& entry : entries_) {
+      if (entry.key != kEmptyKey) {
+        fn(entry.key, entry.value);
+      }
+    }
+  }
+
+  [[nodiscard]] std::size_t Size() const noexcept {
+    return size_;
+  }
+
+  [[nodiscard]] bool Empty() const noexcept {
+    return size_ == 0;
+  }
+
+  void Clear() {
+    entries_.assign(kInitialEntries, Entry{});
+    size_ = 0;
+  }
+
+  [[nodiscard]] std::size_t MemoryBytes() const noexcept {
+    return entries_.capacity() * sizeof(Entry);
+  }
+
+private:
+  static constexpr std::size_t kInitialEntries = 16;
+
+  std::vector<Entry> entries_;
+  std::size_t size_ = 0;
+
+  // Финализатор SplitMix64: ключи a << 32 | b сильно скоррелированы в младших битах
+  static std::uint64_t Hash(std::uint64_t key) noexcept {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+  }
+
+  // Ячейка с ключом или первая пустая на его пути
+  [[nodiscard]] std::size_t Probe(std::uint64_t key) const noexcept {
+    const std::size_t mask = entries_.size() - 1;
+    std::size_t pos = Hash(key) & mask;
+    while (entries_[pos].key != key && entries_[pos].key != kEmptyKey) {
+      pos = (pos + 1) & mask;
+    }
+    return pos;
+  }
+
+  void Grow() {
+    std::vector<Entry> old(entries_.size() * 2);
+    old.swap(entries_);
+    const std::size_t mask = entries_.size() - 1;
+    for (const Entry& entry : old) {
+      if (entry.key == kEmptyKey) {
+        continue;
+      }
+      std::size_t pos = Hash(entry.key) & mask;
+      while (entries_[pos].key != kEmptyKey) {
+        pos = (pos + 1) & mask;
+      }
+      entries_[pos] = entry;
+    }
+  }
+};
+
+} // namespace ptm
+
+#endif // PTM_FLATHASHMAP_HPP_
@@ -0,0 +1,57 @@
+#ifndef PTM_LAZYCACHE_HPP_
+#define PTM_LAZYCACHE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace ptm {
+
+// Производные данные, которые строятся при первом const-обращении и сбрасываются при изменении
+// владельца. Get безопасен из нескольких потоков; Reset вызывается только из неконстантных методов.
+// Копия начинается пустой и строит данные заново - так владелец остаётся копируемым
+template <typename T>
+class LazyCache {
+public:
+  LazyCache() = default;
+
+  LazyCache(const LazyCache& /*other*/) {
+  }
+
+  LazyCache& operator=(const LazyCache& other) {
+    if (this != &other) {
+      Reset();
+    }
+    return *this;
+  }
+
+  ~LazyCache() = default;
+
+  template <typename Build>
+  const T& Get(Build&& build) const {
+    if (const T* ready = ready_.load(std::memory_order_acquire)) {
+      return *ready;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (!value_) {
+      value_ = std::make_unique<T>(build());
+      ready_.store(value_.get(), std::memory_order_release);
+    }
+    return *value_;
+  }
+
+  void Reset() {
+    ready_.store(nullptr, std::memory_order_relaxed);
+    value_.reset();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  mutable std::unique_ptr<T> value_;
+  mutable std::atomic<const T*> ready_ = nullptr;
+};
+
+} // namespace ptm
+
+#endif // PTM_LAZYCACHE_HPP_
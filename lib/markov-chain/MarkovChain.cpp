@@ -1,133 +1,294 @@
 #include "MarkovChain.hpp"
 
+#include <algorithm>
 #include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel/ParallelFor.hpp"
 
 namespace ptm {
 
-size_t MarkovChain::ensureState(const State& s) {
-    auto it = state_to_index_.find(s);
-    if (it != state_to_index_.end()) {
-        return it->second;
-    }
+namespace {
 
-    const size_t new_index = index_to_state_.size();
-    state_to_index_[s] = new_index;
-    index_to_state_.push_back(s);
+// Последовательностей на задачу ParallelFor: короткие последовательности не окупают раздачу по одной
+constexpr std::size_t kSequencesPerTask = 64;
 
-    for (auto& row : counts_) {
-        row.push_back(0);
-    }
-    counts_.push_back(std::vector<size_t>(new_index + 1, 0));
-    row_sums_.push_back(0);
+} // namespace
+
+MarkovChain::StateId MarkovChain::Intern(std::string_view token) {
+    return states_.Intern(token);
+}
+
+std::optional<MarkovChain::StateId> MarkovChain::FindState(std::string_view token) const {
+    return states_.Find(token);
+}
+
+std::string_view MarkovChain::StateName(StateId id) const {
+    return states_.Resolve(id);
+}
 
-    return new_index;
+std::size_t MarkovChain::NumStates() const noexcept {
+    return states_.Size();
 }
 
 void MarkovChain::Train(const std::vector<State>& sequence) {
+    std::vector<StateId> ids;
+    ids.reserve(sequence.size());
+    for (const auto& s : sequence) {
+        ids.push_back(states_.Intern(s));
+    }
+    TrainIds(ids);
+}
+
+void MarkovChain::TrainIds(std::span<const StateId> sequence, std::size_t num_threads) {
     if (sequence.empty()) return;
 
-    ensureState(sequence.front());
-    if (sequence.size() < 2) return;
+    // Чужой ID вышел бы за строки CSR и словарь, а в параллельном подсчёте - за гистограммы строк
+    for (StateId id : sequence) {
+        if (id >= states_.Size()) {
+            throw std::invalid_argument("state id is out of range");
+        }
+    }
+
+    sampling_.Reset();
+    frozen_.Reset();
+    num_rows_ = states_.Size();
 
-    for (size_t i = 0; i + 1 < sequence.size(); ++i) {
-        const size_t from = ensureState(sequence[i]);
-        const size_t to = ensureState(sequence[i + 1]);
+    // Параллельный подсчёт окупается только на длинной последовательности, и её слияние в CSR
+    // (O(nnz)) окупается её же длиной. Короткие копятся в pending_ до первого чтения
+    if (num_threads != 1 && sequence.size() > 2 * kMinPairsPerShard) {
+        pending_.FlushInto(transitions_, num_rows_);
+        AddTransitionsParallel(sequence, num_rows_, num_threads, transitions_);
+        return;
+    }
 
-        counts_[from][to] += 1;
-        row_sums_[from] += 1;
+    for (size_t i = 1; i < sequence.size(); ++i) {
+        pending_.Add(sequence[i - 1], sequence[i]);
     }
 }
 
+void MarkovChain::Commit(TransitionAccumulator& pending) {
+    sampling_.Reset();
+    frozen_.Reset();
+    num_rows_ = states_.Size();
+    if (pending_.Empty()) {
+        std::swap(pending_, pending);
+    } else {
+        pending_.Merge(pending);
+    }
+    pending = TransitionAccumulator();
+}
+
+const CsrTransitions& MarkovChain::Csr() const {
+    frozen_.Get([this] {
+        pending_.FlushInto(transitions_, num_rows_);
+        return Frozen{};
+    });
+    return transitions_;
+}
+
 std::unordered_map<MarkovChain::State, double>
 MarkovChain::NextDistribution(const State& current) const {
     std::unordered_map<State, double> result;
 
-    auto it = state_to_index_.find(current);
-    if (it == state_to_index_.end()) {
+    const CsrTransitions& csr = Csr();
+    const auto i = states_.Find(current);
+    // Состояние могло быть добавлено через Intern и ещё не попасть в CSR
+    if (!i.has_value() || *i >= csr.NumRows()) {
         return result;
     }
 
-    const size_t i = it->second;
-    const size_t sum = row_sums_[i];
+    const size_t sum = csr.row_sums[*i];
     if (sum == 0) {
         return result;
     }
 
-    for (size_t j = 0; j < index_to_state_.size(); ++j) {
-        const size_t c = counts_[i][j];
-        if (c == 0) {
-            continue;
-        }
-        result[index_to_state_[j]] = static_cast<double>(c) / static_cast<double>(sum);
+    const auto columns = csr.RowColumns(*i);
+    const auto counts = csr.RowCounts(*i);
+    result.reserve(columns.size());
+    for (size_t k = 0; k < columns.size(); ++k) {
+        result[State(states_.Resolve(columns[k]))] = static_cast<double>(counts[k]) / static_cast<double>(sum);
     }
     return result;
 }
 
 double MarkovChain::TransitionProbability(const State& from, const State& to) const {
-    auto it_from = state_to_index_.find(from);
-    if (it_from == state_to_index_.end()) {
+    const CsrTransitions& csr = Csr();
+    const auto i = states_.Find(from);
+    if (!i.has_value() || *i >= csr.NumRows()) {
         return 0.0;
     }
 
-    auto it_to = state_to_index_.find(to);
-    if (it_to == state_to_index_.end()) {
+    const auto j = states_.Find(to);
+    if (!j.has_value()) {
         return 0.0;
     }
 
-    size_t i = it_from->second;
-    const size_t j = it_to->second;
-
-    const size_t sum = row_sums_[i];
+    const size_t sum = csr.row_sums[*i];
     if (sum == 0) {
         return 0.0;
     }
 
-    return static_cast<double>(counts_[i][j]) / static_cast<double>(sum);
+    return static_cast<double>(csr.Count(*i, *j)) / static_cast<double>(sum);
+}
+
+const MarkovChain::SamplingTables& MarkovChain::Sampling() const {
+    const CsrTransitions& csr = Csr();
+    return sampling_.Get([&csr] {
+        SamplingTables tables;
+        tables.slots.resize(csr.columns.size());
+        for (size_t i = 0; i < csr.NumRows(); ++i) {
+            const auto counts = csr.RowCounts(i);
+            if (!counts.empty()) {
+                BuildAliasTable(counts, std::span<AliasSlot>(tables.slots).subspan(csr.row_offsets[i],
+                                                                                   counts.size()));
+            }
+        }
+        return tables;
+    });
 }
 
-std::optional<MarkovChain::State> MarkovChain::SampleNext(const State& current, std::mt19937& rng) const {
-    auto it = state_to_index_.find(current);
-    if (it == state_to_index_.end()) {
+std::optional<MarkovChain::StateId> MarkovChain::SampleNextIndex(StateId i, RngRef rng,
+                                                                const SamplingTables& tables) const {
+    if (i >= transitions_.NumRows()) {
         return std::nullopt;
     }
 
-    const size_t i = it->second;
-    if (row_sums_[i] == 0) {
+    const std::size_t begin = transitions_.row_offsets[i];
+    const std::size_t end = transitions_.row_offsets[i + 1];
+    if (begin == end) {
         return std::nullopt;
     }
 
-    std::discrete_distribution<size_t> dist(counts_[i].begin(), counts_[i].end());
-    const size_t j = dist(rng);
-    return index_to_state_[j];
+    const std::span<const AliasSlot> row(tables.slots.data() + begin, end - begin);
+    return transitions_.columns[begin + SampleAlias(row, rng)];
 }
 
-std::vector<MarkovChain::State> MarkovChain::Generate(const State& start, size_t length, std::mt19937& rng) const {
-    std::vector<State> out;
-    if (length == 0) {
-        return out;
+std::optional<MarkovChain::State> MarkovChain::SampleNext(const State& current, RngRef rng) const {
+    const auto i = states_.Find(current);
+    if (!i.has_value()) {
+        return std::nullopt;
     }
 
-    if (state_to_index_.find(start) == state_to_index_.end()) {
-        return out;
+    const auto next = SampleNextIndex(*i, rng, Sampling());
+    if (!next.has_value()) {
+        return std::nullopt;
     }
+    return State(states_.Resolve(*next));
+}
 
-    out.reserve(length);
+std::optional<MarkovChain::StateId> MarkovChain::SampleNextId(StateId current, RngRef rng) const {
+    return SampleNextIndex(current, rng, Sampling());
+}
+
+std::size_t MarkovChain::GenerateIds(StateId start, std::size_t length, RngRef rng,
+                                     std::vector<StateId>& out) const {
+    if (length == 0 || start >= states_.Size()) {
+        return 0;
+    }
+
+    const SamplingTables& tables = Sampling();
     out.push_back(start);
 
-    State cur = start;
-    while (out.size() < length) {
-        auto next = SampleNext(cur, rng);
+    std::size_t produced = 1;
+    StateId cur = start;
+    while (produced < length) {
+        auto next = SampleNextIndex(cur, rng, tables);
         if (!next.has_value()) {
             break;
         }
-        out.push_back(*next);
         cur = *next;
+        out.push_back(cur);
+        ++produced;
+    }
+    return produced;
+}
+
+void MarkovChain::GenerateBatch(std::span<const StateId> starts, std::size_t length, const StreamKey& key,
+                                std::span<StateId> out, std::span<std::size_t> lengths, std::size_t num_threads) const {
+    if (out.size() != starts.size() * length || lengths.size() != starts.size()) {
+        throw std::invalid_argument("out must hold starts.size() * length ids and lengths one per start");
+    }
+    for (StateId start : starts) {
+        if (start >= states_.Size()) {
+            throw std::invalid_argument("start state is out of range");
+        }
+    }
+    if (starts.size() >= (std::size_t{1} << 32)) {
+        throw std::invalid_argument("too many sequences for one stream key");
+    }
+
+    const SamplingTables& tables = Sampling();
+    const std::size_t num_groups = (starts.size() + kSequencesPerTask - 1) / kSequencesPerTask;
+
+    ParallelFor(num_groups, num_threads, [&](std::size_t group) {
+        const std::size_t end = std::min(starts.size(), (group + 1) * kSequencesPerTask);
+        for (std::size_t s = group * kSequencesPerTask; s < end; ++s) {
+            Philox4x32 rng = BlockRng(key, static_cast<std::uint32_t>(s));
+            StateId* sequence = out.data() + s * length;
+
+            std::size_t produced = 0;
+            if (length > 0) {
+                StateId cur = starts[s];
+                sequence[produced++] = cur;
+                while (produced < length) {
+                    const auto next = SampleNextIndex(cur, rng, tables);
+                    if (!next.has_value()) {
+                        break;
+                    }
+                    cur = *next;
+                    sequence[produced++] = cur;
+                }
+            }
+            lengths[s] = produced;
+        }
+    });
+}
+
+std::vector<MarkovChain::State> MarkovChain::Generate(const State& start, size_t length, RngRef rng) const {
+    std::vector<State> out;
+    const auto start_id = states_.Find(start);
+    if (!start_id.has_value()) {
+        return out;
+    }
+
+    // Строка состояния хешируется один раз, на старте; дальше - только ID
+    std::vector<StateId> ids;
+    ids.reserve(length);
+    GenerateIds(*start_id, length, rng, ids);
+
+    out.reserve(ids.size());
+    for (StateId id : ids) {
+        out.emplace_back(states_.Resolve(id));
     }
     return out;
 }
 
 std::vector<MarkovChain::State> MarkovChain::States() const {
-    return index_to_state_;
+    std::vector<State> out;
+    out.reserve(states_.Size());
+    for (StateId id = 0; id < states_.Size(); ++id) {
+        out.emplace_back(states_.Resolve(id));
+    }
+    return out;
+}
+
+std::size_t MarkovChain::NumTransitions() const {
+    return Csr().columns.size();
+}
+
+const CsrTransitions& MarkovChain::Transitions() const {
+    return Csr();
+}
+
+const TokenInterner& MarkovChain::Vocabulary() const noexcept {
+    return states_;
+}
+
+std::span<const AliasSlot> MarkovChain::SamplingSlots() const {
+    return Sampling().slots;
 }
 
 } // namespace ptm
@@ -1,21 +1,34 @@
 #ifndef PTM_MARKOVCHAIN_HPP_
 #define PTM_MARKOVCHAIN_HPP_
 
+#include <cstdint>
 #include <optional>
 #include <random>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "AliasTable.hpp"
+#include "LazyCache.hpp"
+#include "TokenInterner.hpp"
+#include "TransitionTable.hpp"
+#include "random/CounterStreams.hpp"
+#include "random/RngRef.hpp"
+
 namespace ptm {
 
 class MarkovChain {
 public:
   using State = std::string;
+  using StateId = TokenInterner::Id;
 
   MarkovChain() = default;
 
-  // Обучение на одной последовательности (инкрементально)
+  // Обучение на одной последовательности (инкрементально). Переходы копятся в хеш-таблице и сливаются
+  // в CSR при первом чтении после обучения: O(n) на вызов, слияние O(nnz + k log k) для k новых пар -
+  // один раз на серию вызовов. Память O(|V| + nnz)
   void Train(const std::vector<State>& sequence);
 
   // Получить распределение P(next | current) как map state -> prob
@@ -24,26 +37,85 @@ public:
   // Вероятность конкретного перехода P(to | from). 0, если переход или состояние не встречались
   double TransitionProbability(const State& from, const State& to) const;
 
-  // Сгенерировать следующий токен из распределения P(next | current)
+  // Сгенерировать следующий токен из распределения P(next | current) за O(1) по таблице псевдонимов.
+  // Таблицы всех строк строятся при первом вызове после Train; сама выборка ничего не выделяет.
   // Если у current нет исходящих переходов, возвращает std::nullopt
-  std::optional<State> SampleNext(const State& current, std::mt19937& rng) const;
+  std::optional<State> SampleNext(const State& current, RngRef rng) const;
 
   // Сгенерировать последовательность длины length, начиная с start
-  std::vector<State> Generate(const State& start, size_t length, std::mt19937& rng) const;
+  std::vector<State> Generate(const State& start, size_t length, RngRef rng) const;
 
   // Все известные состояния
   std::vector<State> States() const;
 
+  // Число различных переходов (ненулевых c_ij)
+  [[nodiscard]] std::size_t NumTransitions() const;
+
+  // Счётчики переходов в CSR; индексы строк и столбцов - порядок States()
+  [[nodiscard]] const CsrTransitions& Transitions() const;
+
+  // Словарь состояний; ID - индексы строк Transitions()
+  [[nodiscard]] const TokenInterner& Vocabulary() const noexcept;
+
+  // Таблицы Уолкера всех строк, выровненные с Transitions().columns (строятся при первом обращении)
+  [[nodiscard]] std::span<const AliasSlot> SamplingSlots() const;
+
+  // Конвейер на целых ID: токен интернируется один раз, дальше обучение и генерация идут по StateId,
+  // строки нужны только на выходе (StateName)
+  StateId Intern(std::string_view token);
+  [[nodiscard]] std::optional<StateId> FindState(std::string_view token) const;
+  [[nodiscard]] std::string_view StateName(StateId id) const;
+  [[nodiscard]] std::size_t NumStates() const noexcept;
+
+  // То же, что Train, для последовательности ID из Intern. При num_threads != 1 длинная последовательность
+  // считается параллельно по участкам (0 - по числу ядер) и сливается в CSR сразу; счётчики совпадают
+  // с последовательным обучением при любом числе потоков. std::invalid_argument, если в sequence есть
+  // ID не из Intern; цепь при этом не меняется
+  void TrainIds(std::span<const StateId> sequence, std::size_t num_threads = 1);
+
+  // Добавить в цепь переходы между ID, накопленные снаружи (например, при потоковом разборе), и очистить
+  // pending; в CSR они попадут при первом чтении
+  void Commit(TransitionAccumulator& pending);
+
+  // Дописать в out последовательность длины не больше length, начиная с start; возвращает число ID
+  std::size_t GenerateIds(StateId start, std::size_t length, RngRef rng, std::vector<StateId>& out) const;
+
+  // SampleNext по ID, без строк и хеш-поиска; std::nullopt - тупик или неизвестный ID
+  [[nodiscard]] std::optional<StateId> SampleNextId(StateId current, RngRef rng) const;
+
+  // Пакетная генерация: последовательность s начинается с starts[s] и пишется в
+  // out[s * length, (s + 1) * length), её фактическая длина - в lengths[s] (меньше length при тупике).
+  // У каждой последовательности свой поток BlockRng(key, s), поэтому результат не зависит от
+  // num_threads (0 - по числу ядер). Память не выделяется: всё пишется в буферы вызывающего
+  void GenerateBatch(std::span<const StateId> starts, std::size_t length, const StreamKey& key,
+                     std::span<StateId> out, std::span<std::size_t> lengths, std::size_t num_threads = 1) const;
+
 private:
-  // отображение state -> index
-  std::unordered_map<State, size_t> state_to_index_;
-  std::vector<State> index_to_state_;
+  // Словарь состояний: строка <-> индекс строки CSR
+  TokenInterner states_;
+
+  // c_ij в CSR, row_sums[i] = sum_j c_ij. Переходы, добавленные после последнего чтения, лежат в pending_,
+  // CSR доводится до num_rows_ строк (словарь на момент последнего обучения) при заморозке
+  mutable CsrTransitions transitions_;
+  mutable TransitionAccumulator pending_;
+  std::size_t num_rows_ = 0;
+
+  // Метка заморозки: слияние pending_ в transitions_ идёт под замком LazyCache, поэтому параллельные
+  // const-чтения выполняют его ровно один раз
+  struct Frozen {};
+  LazyCache<Frozen> frozen_;
 
-  // counts_[i][j] = c_ij, row_sums_[i] = sum_j c_ij
-  std::vector<std::vector<size_t>> counts_;
-  std::vector<size_t> row_sums_;
+  // Таблицы Уолкера по строкам, выровненные с CSR: ячейка k строки i выдаёт столбец transitions_.columns[k]
+  struct SamplingTables {
+    std::vector<AliasSlot> slots;
+  };
+  LazyCache<SamplingTables> sampling_;
 
-  size_t ensureState(const State& s);
+  // Счётчики с учётом всех обучений; все чтения transitions_ идут после этого вызова
+  [[nodiscard]] const CsrTransitions& Csr() const;
+  [[nodiscard]] const SamplingTables& Sampling() const;
+  // tables - из Sampling(), так что CSR к этому моменту заморожен
+  [[nodiscard]] std::optional<StateId> SampleNextIndex(StateId i, RngRef rng, const SamplingTables& tables) const;
 };
 
 } // namespace ptm
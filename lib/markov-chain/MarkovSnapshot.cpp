@@ -0,0 +1,439 @@
+#include "MarkovSnapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PTM_SNAPSHOT_MMAP 1
+#endif
+
+namespace ptm {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'T', 'M', 'M', 'A', 'R', 'K', 'V'};
+constexpr std::uint32_t kEndianMarker = 0x01020304U;
+constexpr std::size_t kAlignment = 64;
+
+struct SnapshotHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t endian;
+  std::uint64_t num_states;
+  std::uint64_t pool_bytes;
+  std::uint64_t num_slots;
+  std::uint64_t num_transitions;
+  std::uint64_t payload_bytes;
+  std::uint64_t checksum;
+};
+
+static_assert(sizeof(SnapshotHeader) == kAlignment);
+static_assert(std::is_trivially_copyable_v<AliasSlot> && sizeof(AliasSlot) == 16 && offsetof(AliasSlot, alias) == 8);
+static_assert(std::is_trivially_copyable_v<TokenSlot> && sizeof(TokenSlot) == 8);
+
+std::size_t AlignUp(std::size_t n) {
+    return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Смещения секций от начала полезной нагрузки (сразу за заголовком) - функция одних только размеров,
+// поэтому в файле их хранить не нужно. Размеры приходят из заголовка, то есть не проверены: если
+// раскладка не помещается в kMaxLayoutBytes, fits = false, и смещениям верить нельзя
+struct SnapshotLayout {
+  static constexpr std::size_t kMaxLayoutBytes = std::numeric_limits<std::size_t>::max() / 2;
+
+  std::size_t offsets = 0;
+  std::size_t pool = 0;
+  std::size_t slots = 0;
+  std::size_t row_offsets = 0;
+  std::size_t columns = 0;
+  std::size_t counts = 0;
+  std::size_t row_sums = 0;
+  std::size_t alias = 0;
+  std::size_t end = 0;
+  bool fits = true;
+
+  // num_states < 2^32, так что num_states + 1 не переполняется
+  SnapshotLayout(std::uint64_t num_states, std::uint64_t pool_bytes, std::uint64_t num_slots, std::uint64_t nnz) {
+    std::size_t at = 0;
+    auto place = [this, &at](std::uint64_t count, std::size_t element_bytes) {
+      const std::size_t begin = at;
+      if (!fits || at > kMaxLayoutBytes || count > (kMaxLayoutBytes - at) / element_bytes) {
+        fits = false;
+        return begin;
+      }
+      at = AlignUp(at + static_cast<std::size_t>(count) * element_bytes);
+      return begin;
+    };
+    offsets = place(num_states + 1, sizeof(std::uint32_t));
+    pool = place(pool_bytes, 1);
+    slots = place(num_slots, sizeof(TokenSlot));
+    row_offsets = place(num_states + 1, sizeof(std::uint64_t));
+    columns = place(nnz, sizeof(std::uint32_t));
+    counts = place(nnz, sizeof(std::uint64_t));
+    row_sums = place(num_states, sizeof(std::uint64_t));
+    alias = place(nnz, sizeof(AliasSlot));
+    end = at;
+  }
+};
+
+// Контрольная сумма по 64-битным словам (длина кратна 64): цепочка умножений с поворотом и финальное
+// перемешивание SplitMix64 - ловит порчу и обрезку, проход по файлу в несколько ГБ/с
+std::uint64_t Checksum(const unsigned char* data, std::size_t bytes) {
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ bytes;
+    for (std::size_t i = 0; i < bytes; i += sizeof(std::uint64_t)) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + i, sizeof(word));
+        h ^= word * 0x87c37b91114253d5ULL;
+        h = (h << 31 | h >> 33) * 0x4cf5ad432745937fULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// Имя временного файла рядом с path: rename атомарен только в пределах одной файловой системы.
+// Номер процесса и счётчик разводят одновременные записи одного снимка
+std::string TemporaryPath(const std::string& path) {
+    static std::atomic<unsigned> counter{0};
+    std::string temporary = path + ".tmp";
+#ifdef PTM_SNAPSHOT_MMAP
+    temporary += "." + std::to_string(::getpid());
+#endif
+    return temporary + "." + std::to_string(counter.fetch_add(1));
+}
+
+template <typename T>
+std::span<const T> Section(const unsigned char* payload, std::size_t offset, std::size_t count) {
+    return {reinterpret_cast<const T*>(payload + offset), count};
+}
+
+} // namespace
+
+void SaveSnapshot(const MarkovChain& chain, const std::string& path) {
+    const TokenInterner& vocabulary = chain.Vocabulary();
+    const CsrTransitions& csr = chain.Transitions();
+    const std::span<const AliasSlot> alias = chain.SamplingSlots();
+
+    const std::size_t num_states = vocabulary.Size();
+    const std::size_t nnz = csr.columns.size();
+    const SnapshotLayout layout(num_states, vocabulary.Pool().size(), vocabulary.Slots().size(), nnz);
+
+    // Буфер обнулён: байты выравнивания и хвосты AliasSlot детерминированы, контрольная сумма стабильна
+    std::vector<unsigned char> payload(layout.end, 0);
+    unsigned char* out = payload.data();
+
+    std::memcpy(out + layout.offsets, vocabulary.Offsets().data(), vocabulary.Offsets().size_bytes());
+    std::memcpy(out + layout.pool, vocabulary.Pool().data(), vocabulary.Pool().size_bytes());
+    std::memcpy(out + layout.slots, vocabulary.Slots().data(), vocabulary.Slots().size_bytes());
+
+    // Строки CSR есть не у всех состояний: интернированные без обучения получают пустые строки
+    for (std::size_t i = 0; i <= num_states; ++i) {
+        const std::uint64_t offset = i < csr.row_offsets.size() ? csr.row_offsets[i] : nnz;
+        std::memcpy(out + layout.row_offsets + i * sizeof(std::uint64_t), &offset, sizeof(offset));
+    }
+    for (std::size_t i = 0; i < num_states; ++i) {
+        const std::uint64_t sum = i < csr.row_sums.size() ? csr.row_sums[i] : 0;
+        std::memcpy(out + layout.row_sums + i * sizeof(std::uint64_t), &sum, sizeof(sum));
+    }
+    std::memcpy(out + layout.columns, csr.columns.data(), nnz * sizeof(std::uint32_t));
+    for (std::size_t k = 0; k < nnz; ++k) {
+        const std::uint64_t count = csr.counts[k];
+        std::memcpy(out + layout.counts + k * sizeof(std::uint64_t), &count, sizeof(count));
+        std::memcpy(out + layout.alias + k * sizeof(AliasSlot), &alias[k].threshold, sizeof(double));
+        std::memcpy(out + layout.alias + k * sizeof(AliasSlot) + offsetof(AliasSlot, alias), &alias[k].alias,
+                    sizeof(std::uint32_t));
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kMarkovSnapshotVersion;
+    header.endian = kEndianMarker;
+    header.num_states = num_states;
+    header.pool_bytes = vocabulary.Pool().size();
+    header.num_slots = vocabulary.Slots().size();
+    header.num_transitions = nnz;
+    header.payload_bytes = payload.size();
+    header.checksum = Checksum(payload.data(), payload.size());
+
+    // Снимок пишется во временный файл и переименовывается поверх старого: усечение на месте уронило бы
+    // (SIGBUS) процессы, отобразившие прежний файл, а после rename они дочитывают свою версию
+    const std::string temporary = TemporaryPath(path);
+    std::error_code error;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        file.close();
+        if (!file) {
+            std::filesystem::remove(temporary, error);
+            throw std::runtime_error("cannot write snapshot " + path);
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("cannot replace snapshot " + path);
+    }
+}
+
+MarkovSnapshot MarkovSnapshot::Open(const std::string& path, bool verify_checksum) {
+    MarkovSnapshot snapshot;
+
+#ifdef PTM_SNAPSHOT_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open snapshot " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        throw std::runtime_error("snapshot " + path + " is truncated");
+    }
+    snapshot.size_ = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, snapshot.size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("cannot map snapshot " + path);
+    }
+    snapshot.mapping_ = mapping;
+    snapshot.mapped_ = true;
+#else
+    // Без mmap файл читается целиком в выровненный буфер - формат и доступ те же
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("cannot open snapshot " + path);
+    }
+    snapshot.size_ = static_cast<std::size_t>(file.tellg());
+    if (snapshot.size_ < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("snapshot " + path + " is truncated");
+    }
+    auto* buffer = new std::uint64_t[(snapshot.size_ + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t)];
+    snapshot.mapping_ = buffer;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(snapshot.size_));
+    if (!file) {
+        throw std::runtime_error("cannot read snapshot " + path);
+    }
+#endif
+
+    const auto* bytes = static_cast<const unsigned char*>(snapshot.mapping_);
+    SnapshotHeader header{};
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path + " is not a Markov chain snapshot");
+    }
+    if (header.endian != kEndianMarker) {
+        throw std::runtime_error("snapshot " + path + " was written with a different byte order");
+    }
+    if (header.version != kMarkovSnapshotVersion) {
+        throw std::runtime_error("snapshot " + path + " has unsupported version " + std::to_string(header.version));
+    }
+
+    // ID состояний - uint32_t, kEmptyTokenSlot занят под пустую ячейку. В таблице словаря есть хотя бы
+    // одна пустая ячейка - иначе пробирование не остановится
+    if (header.num_states >= kEmptyTokenSlot || !std::has_single_bit(header.num_slots) ||
+        header.num_slots <= header.num_states) {
+        throw std::runtime_error("snapshot " + path + " is corrupted (invalid header sizes)");
+    }
+    const SnapshotLayout layout(header.num_states, header.pool_bytes, header.num_slots, header.num_transitions);
+    if (!layout.fits || header.payload_bytes != layout.end ||
+        snapshot.size_ - sizeof(SnapshotHeader) != layout.end) {
+        throw std::runtime_error("snapshot " + path + " is truncated");
+    }
+
+    const unsigned char* payload = bytes + sizeof(SnapshotHeader);
+    if (verify_checksum && Checksum(payload, layout.end) != header.checksum) {
+        throw std::runtime_error("snapshot " + path + " is corrupted (checksum mismatch)");
+    }
+
+    snapshot.offsets_ = Section<std::uint32_t>(payload, layout.offsets, header.num_states + 1);
+    snapshot.pool_ = Section<char>(payload, layout.pool, header.pool_bytes);
+    snapshot.slots_ = Section<TokenSlot>(payload, layout.slots, header.num_slots);
+    snapshot.row_offsets_ = Section<std::uint64_t>(payload, layout.row_offsets, header.num_states + 1);
+    snapshot.columns_ = Section<std::uint32_t>(payload, layout.columns, header.num_transitions);
+    snapshot.counts_ = Section<std::uint64_t>(payload, layout.counts, header.num_transitions);
+    snapshot.row_sums_ = Section<std::uint64_t>(payload, layout.row_sums, header.num_states);
+    snapshot.alias_ = Section<AliasSlot>(payload, layout.alias, header.num_transitions);
+    snapshot.CheckStructure(path);
+    return snapshot;
+}
+
+void MarkovSnapshot::CheckStructure(const std::string& path) const {
+    auto fail = [&path](const char* what) {
+        throw std::runtime_error("snapshot " + path + " is corrupted (" + what + ")");
+    };
+    const std::size_t num_states = row_sums_.size();
+
+    if (offsets_.front() != 0 || offsets_.back() != pool_.size() ||
+        !std::is_sorted(offsets_.begin(), offsets_.end())) {
+        fail("token offsets");
+    }
+
+    // Каждое состояние ровно в одной ячейке: остальные пусты, и пробирование упирается в пустую
+    std::size_t occupied = 0;
+    for (const TokenSlot& slot : slots_) {
+        if (slot.id == kEmptyTokenSlot) {
+            continue;
+        }
+        if (slot.id >= num_states) {
+            fail("token table");
+        }
+        ++occupied;
+    }
+    if (occupied != num_states) {
+        fail("token table");
+    }
+
+    if (row_offsets_.front() != 0 || row_offsets_.back() != columns_.size() ||
+        !std::is_sorted(row_offsets_.begin(), row_offsets_.end())) {
+        fail("row offsets");
+    }
+    for (const std::uint32_t column : columns_) {
+        if (column >= num_states) {
+            fail("transition target");
+        }
+    }
+
+    // Ячейка Уолкера ссылается на слагаемое своей строки; строка короче 2^32 - условие SampleAlias
+    for (std::size_t i = 0; i < num_states; ++i) {
+        const std::uint64_t length = row_offsets_[i + 1] - row_offsets_[i];
+        if (length > std::numeric_limits<std::uint32_t>::max()) {
+            fail("row length");
+        }
+        for (std::size_t k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+            if (alias_[k].alias >= length) {
+                fail("alias table");
+            }
+        }
+    }
+}
+
+MarkovSnapshot::MarkovSnapshot(MarkovSnapshot&& other) noexcept {
+    *this = std::move(other);
+}
+
+MarkovSnapshot& MarkovSnapshot::operator=(MarkovSnapshot&& other) noexcept {
+    if (this != &other) {
+        Release();
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = other.mapped_;
+        pool_ = other.pool_;
+        offsets_ = other.offsets_;
+        slots_ = other.slots_;
+        row_offsets_ = other.row_offsets_;
+        columns_ = other.columns_;
+        counts_ = other.counts_;
+        row_sums_ = other.row_sums_;
+        alias_ = other.alias_;
+    }
+    return *this;
+}
+
+MarkovSnapshot::~MarkovSnapshot() {
+    Release();
+}
+
+void MarkovSnapshot::Release() noexcept {
+    if (mapping_ == nullptr) {
+        return;
+    }
+#ifdef PTM_SNAPSHOT_MMAP
+    if (mapped_) {
+        ::munmap(mapping_, size_);
+    }
+#else
+    delete[] static_cast<std::uint64_t*>(mapping_);
+#endif
+    mapping_ = nullptr;
+}
+
+TokenTableView MarkovSnapshot::Vocabulary() const noexcept {
+    return {pool_, offsets_, slots_};
+}
+
+std::optional<MarkovSnapshot::StateId> MarkovSnapshot::FindState(std::string_view token) const noexcept {
+    return Vocabulary().Find(token);
+}
+
+std::string_view MarkovSnapshot::StateName(StateId id) const noexcept {
+    return Vocabulary().Resolve(id);
+}
+
+std::size_t MarkovSnapshot::NumStates() const noexcept {
+    return row_sums_.size();
+}
+
+std::size_t MarkovSnapshot::NumTransitions() const noexcept {
+    return columns_.size();
+}
+
+double MarkovSnapshot::TransitionProbability(StateId from, StateId to) const noexcept {
+    if (from >= NumStates() || row_sums_[from] == 0) {
+        return 0.0;
+    }
+    const auto row = columns_.subspan(row_offsets_[from], row_offsets_[from + 1] - row_offsets_[from]);
+    const auto it = std::lower_bound(row.begin(), row.end(), to);
+    if (it == row.end() || *it != to) {
+        return 0.0;
+    }
+    const std::uint64_t count = counts_[row_offsets_[from] + static_cast<std::size_t>(it - row.begin())];
+    return static_cast<double>(count) / static_cast<double>(row_sums_[from]);
+}
+
+std::optional<MarkovSnapshot::StateId> MarkovSnapshot::SampleNext(StateId current, RngRef rng) const {
+    if (current >= NumStates()) {
+        return std::nullopt;
+    }
+    const std::size_t begin = row_offsets_[current];
+    const std::size_t end = row_offsets_[current + 1];
+    if (begin == end) {
+        return std::nullopt;
+    }
+    return columns_[begin + SampleAlias(alias_.subspan(begin, end - begin), rng)];
+}
+
+std::size_t MarkovSnapshot::GenerateIds(StateId start, std::size_t length, RngRef rng,
+                                        std::vector<StateId>& out) const {
+    if (length == 0 || start >= NumStates()) {
+        return 0;
+    }
+
+    out.push_back(start);
+    std::size_t produced = 1;
+    StateId cur = start;
+    while (produced < length) {
+        const auto next = SampleNext(cur, rng);
+        if (!next.has_value()) {
+            break;
+        }
+        cur = *next;
+        out.push_back(cur);
+        ++produced;
+    }
+    return produced;
+}
+
+std::size_t MarkovSnapshot::SizeBytes() const noexcept {
+    return size_;
+}
+
+} // namespace ptm
@@ -0,0 +1,88 @@
+#ifndef PTM_MARKOVSNAPSHOT_HPP_
+#define PTM_MARKOVSNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AliasTable.hpp"
+#include "MarkovChain.hpp"
+#include "TokenInterner.hpp"
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Бинарный снимок обученной цепи. Файл - заголовок и секции, выровненные по 64 байтам:
+// словарь (пул байтов, смещения, хеш-таблица), CSR (row_offsets, columns, counts, row_sums)
+// и таблицы Уолкера. Массивы лежат ровно в том виде, в каком их читает цепь, поэтому загрузка -
+// это mmap и проверка заголовка и структуры, без разбора и выделений на элемент; страницы файла
+// разделяются между процессами. Заголовок хранит версию формата, маркер порядка байт и контрольную
+// сумму секций
+inline constexpr std::uint32_t kMarkovSnapshotVersion = 1;
+
+// Записать снимок цепи в path через временный файл в том же каталоге и rename: уже открытые снимки
+// продолжают видеть прежний файл. std::runtime_error при ошибке записи
+void SaveSnapshot(const MarkovChain& chain, const std::string& path);
+
+// Цепь только для чтения поверх отображённого в память снимка
+class MarkovSnapshot {
+public:
+  using StateId = MarkovChain::StateId;
+
+  // Отобразить файл и проверить заголовок и структуру секций: размеры, монотонность смещений, границы
+  // ID, столбцов и ячеек Уолкера - этого достаточно, чтобы чтение не вышло за массивы и пробирование
+  // словаря останавливалось. verify_checksum - ещё и пересчитать сумму секций, которая ловит и порчу
+  // значений (счётчиков, порогов). std::runtime_error, если файл не открывается, обрезан, другой
+  // версии или повреждён
+  static MarkovSnapshot Open(const std::string& path, bool verify_checksum = true);
+
+  MarkovSnapshot(MarkovSnapshot&& other) noexcept;
+  MarkovSnapshot& operator=(MarkovSnapshot&& other) noexcept;
+  MarkovSnapshot(const MarkovSnapshot&) = delete;
+  MarkovSnapshot& operator=(const MarkovSnapshot&) = delete;
+  ~MarkovSnapshot();
+
+  [[nodiscard]] std::optional<StateId> FindState(std::string_view token) const noexcept;
+  [[nodiscard]] std::string_view StateName(StateId id) const noexcept;
+  [[nodiscard]] std::size_t NumStates() const noexcept;
+  [[nodiscard]] std::size_t NumTransitions() const noexcept;
+
+  // P(to | from), 0 - если перехода нет
+  [[nodiscard]] double TransitionProbability(StateId from, StateId to) const noexcept;
+
+  // Те же выборки, что у MarkovChain с тем же генератором
+  std::optional<StateId> SampleNext(StateId current, RngRef rng) const;
+  std::size_t GenerateIds(StateId start, std::size_t length, RngRef rng, std::vector<StateId>& out) const;
+
+  // Размер отображённого файла
+  [[nodiscard]] std::size_t SizeBytes() const noexcept;
+
+private:
+  MarkovSnapshot() = default;
+
+  void* mapping_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false; // false - файл прочитан в кучу (платформы без mmap)
+
+  std::span<const char> pool_;
+  std::span<const std::uint32_t> offsets_;
+  std::span<const TokenSlot> slots_;
+  std::span<const std::uint64_t> row_offsets_;
+  std::span<const std::uint32_t> columns_;
+  std::span<const std::uint64_t> counts_;
+  std::span<const std::uint64_t> row_sums_;
+  std::span<const AliasSlot> alias_;
+
+  [[nodiscard]] TokenTableView Vocabulary() const noexcept;
+  // Проверка секций, без которой чтение вышло бы за массивы; std::runtime_error при нарушении
+  void CheckStructure(const std::string& path) const;
+  void Release() noexcept;
+};
+
+} // namespace ptm
+
+#endif // PTM_MARKOVSNAPSHOT_HPP_
@@ -1,156 +1,326 @@
 #include "MarkovTextModel.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "parallel/ParallelFor.hpp"
+
 namespace ptm {
 
-MarkovTextModel::MarkovTextModel(TokenLevel level) : level_(level), chain_() {}
+namespace {
+
+// Меньшие участки текста не окупают слияния словарей
+constexpr std::size_t kMinBytesPerPiece = 1 << 18;
+
+} // namespace
+
+MarkovTextModel::MarkovTextModel(TokenLevel level, std::size_t order) : level_(level), chain_() {
+    if (order != 1) {
+        ngram_.emplace(order);
+    }
+}
 
 const MarkovChain& MarkovTextModel::Chain() const noexcept { return chain_; }
 
+std::size_t MarkovTextModel::Order() const noexcept { return ngram_.has_value() ? ngram_->Order() : 1; }
+
 static bool IsWordChar(unsigned char c) {
     return std::isalnum(c) != 0 || c == '\'';
 }
 
 static bool IsPunctChar(unsigned char c) {
-    const std::string punct = ".,!?;:()[]{}\"";
-    return punct.find(static_cast<char>(c)) != std::string::npos;
+    const std::string_view punct = ".,!?;:()[]{}\"";
+    return punct.find(static_cast<char>(c)) != std::string_view::npos;
 }
 
-static bool NoSpaceBefore(const std::string& tok) {
+static bool NoSpaceBefore(std::string_view tok) {
     if (tok.size() != 1) {
         return false;
     }
 
     const char c = tok[0];
-    const std::string set = ".,!?;:)]}\"";
-    return set.find(c) != std::string::npos;
+    const std::string_view set = ".,!?;:)]}\"";
+    return set.find(c) != std::string_view::npos;
 }
 
-static bool NoSpaceAfterPrev(const std::string& prev) {
+static bool NoSpaceAfterPrev(std::string_view prev) {
     if (prev.size() != 1) {
         return false;
     }
     const char c = prev[0];
-    const std::string set = "([{\"";
-    return set.find(c) != std::string::npos;
+    const std::string_view set = "([{\"";
+    return set.find(c) != std::string_view::npos;
 }
 
-void MarkovTextModel::TrainFromText(const std::string& text) {
-    auto tokens = Tokenize(text);
-    chain_.Train(tokens);
+// Дописать накопленное слово (в нижнем регистре) токеном
+template <typename Intern>
+static void FlushWord(std::string& word, Intern&& intern, std::vector<MarkovChain::StateId>& tokens) {
+    if (word.empty()) return;
+    for (char& ch : word) {
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    tokens.push_back(intern(std::string_view(word)));
+    word.clear();
 }
 
-std::vector<std::string> MarkovTextModel::Tokenize(const std::string& text_in) const {
-    std::string text = text_in;
-
-    std::vector<std::string> tokens;
-
-    if (level_ == TokenLevel::Character) {
-        tokens.reserve(text.size());
-        for (unsigned char c : text) {
-            tokens.emplace_back(1, static_cast<char>(c));
+// Разбор куска текста на токены; каждый токен сразу отдаётся intern, его ID дописывается в tokens.
+// Незаконченное слово остаётся в word и продолжается следующим куском - так текст можно подавать частями.
+// Один буфер на все слова: после прогрева интернирование уже встречавшегося слова не выделяет память
+template <typename Intern>
+static void TokenizeChunk(std::string_view text, MarkovTextModel::TokenLevel level, Intern&& intern,
+                          std::string& word, std::vector<MarkovChain::StateId>& tokens) {
+    if (level == MarkovTextModel::TokenLevel::Character) {
+        tokens.reserve(tokens.size() + text.size());
+        for (const char& c : text) {
+            tokens.push_back(intern(std::string_view(&c, 1)));
         }
-        return tokens;
+        return;
     }
 
-    std::string cur;
-
-    auto flush_word = [&]() {
-        if (cur.empty()) return;
-        for (char& ch : cur) {
-            ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-        }
-        tokens.push_back(cur);
-        cur.clear();
-    };
-
-    for (unsigned char uc : text) {
+    for (const char& c : text) {
+        const auto uc = static_cast<unsigned char>(c);
         if (std::isspace(uc) != 0) {
-            flush_word();
+            FlushWord(word, intern, tokens);
             continue;
         }
 
         if (IsWordChar(uc)) {
-            cur.push_back(static_cast<char>(uc));
+            word.push_back(c);
             continue;
         }
 
-    flush_word();
-
-    tokens.emplace_back(1, static_cast<char>(uc));
+        FlushWord(word, intern, tokens);
+        tokens.push_back(intern(std::string_view(&c, 1)));
     }
-
-    flush_word();
-    return tokens;
 }
 
-std::string MarkovTextModel::Detokenize(const std::vector<std::string>& tokens) const {
-    if (tokens.empty()) return {};
+template <typename Intern>
+static void TokenizeInto(std::string_view text, MarkovTextModel::TokenLevel level, Intern&& intern,
+                         std::vector<MarkovChain::StateId>& tokens) {
+    std::string word;
+    TokenizeChunk(text, level, intern, word, tokens);
+    FlushWord(word, intern, tokens);
+}
 
-    if (level_ == TokenLevel::Character) {
-        std::string out;
-        out.reserve(tokens.size());
-        for (const auto& t : tokens) {
-            out += t;
+// Границы участков для параллельного разбора: на уровне слов - сразу после пробельного символа,
+// там разбор начинается с чистого состояния, поэтому токены участков в сумме те же, что у всего текста
+static std::vector<std::string_view> SplitAtTokenBoundaries(std::string_view text, MarkovTextModel::TokenLevel level,
+                                                            std::size_t num_pieces) {
+    std::vector<std::string_view> pieces;
+    std::size_t begin = 0;
+    for (std::size_t p = 1; p <= num_pieces && begin < text.size(); ++p) {
+        std::size_t end = p == num_pieces ? text.size() : std::max(begin, p * text.size() / num_pieces);
+        if (level == MarkovTextModel::TokenLevel::Word) {
+            while (end < text.size() && (end == 0 || std::isspace(static_cast<unsigned char>(text[end - 1])) == 0)) {
+                ++end;
+            }
         }
-        return out;
+        pieces.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return pieces;
+}
+
+void MarkovTextModel::TrainFromText(const std::string& text, std::size_t num_threads) {
+    const auto tokens = num_threads == 1 ? Tokenize(text) : TokenizeParallel(text, num_threads);
+    chain_.TrainIds(tokens, num_threads);
+    if (ngram_.has_value()) {
+        ngram_->Train(tokens);
     }
+}
 
-    std::string out;
-    out.reserve(tokens.size() * 4);
+void MarkovTextModel::TrainFromStream(std::istream& in, std::size_t chunk_bytes) {
+    if (chunk_bytes == 0) {
+        throw std::invalid_argument("chunk_bytes must be positive");
+    }
 
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const auto& tok = tokens[i];
-        if (tok.empty()) continue;
+    auto intern = [this](std::string_view token) { return chain_.Intern(token); };
 
-        if (i == 0) {
-            out += tok;
-            continue;
+    // Перед токенами очередного куска лежат последние Order() токенов предыдущего: они служат только
+    // контекстом, поэтому переходы через границу кусков считаются ровно один раз
+    const std::size_t history = Order();
+    std::vector<char> chunk(chunk_bytes);
+    std::vector<MarkovChain::StateId> tokens;
+    std::string word;
+    TransitionAccumulator chain_pending;
+    TransitionAccumulator ngram_pending;
+
+    auto count = [&](std::size_t carried) {
+        for (std::size_t i = std::max<std::size_t>(carried, 1); i < tokens.size(); ++i) {
+            chain_pending.Add(tokens[i - 1], tokens[i]);
+        }
+        if (ngram_.has_value()) {
+            ngram_->Accumulate(tokens, carried, ngram_pending);
         }
+        const std::size_t keep = std::min(history, tokens.size());
+        tokens.erase(tokens.begin(), tokens.end() - static_cast<std::ptrdiff_t>(keep));
+        return keep;
+    };
 
-        const auto& prev = tokens[i - 1];
+    std::size_t carried = 0;
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const auto got = static_cast<std::size_t>(in.gcount());
+        if (got == 0) {
+            break;
+        }
+        TokenizeChunk(std::string_view(chunk.data(), got), level_, intern, word, tokens);
+        carried = count(carried);
+    }
+    FlushWord(word, intern, tokens);
+    count(carried);
 
-        if (tok.size() == 1 && IsPunctChar(static_cast<unsigned char>(tok[0])) && NoSpaceBefore(tok)) {
-            out += tok;
-            continue;
+    // Счётчики сливаются в CSR один раз на весь поток
+    chain_.Commit(chain_pending);
+    if (ngram_.has_value()) {
+        ngram_->Commit(ngram_pending);
+    }
+}
+
+void MarkovTextModel::TrainFromFile(const std::string& path, std::size_t chunk_bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    TrainFromStream(in, chunk_bytes);
+}
+
+std::vector<MarkovChain::StateId> MarkovTextModel::Tokenize(const std::string& text) {
+    std::vector<MarkovChain::StateId> tokens;
+    TokenizeInto(text, level_, [this](std::string_view token) { return chain_.Intern(token); }, tokens);
+    return tokens;
+}
+
+std::vector<MarkovChain::StateId> MarkovTextModel::TokenizeParallel(const std::string& text,
+                                                                    std::size_t num_threads) {
+    const std::size_t num_pieces =
+        std::clamp<std::size_t>(text.size() / kMinBytesPerPiece, 1, ResolveThreadCount(num_threads));
+    const auto pieces = SplitAtTokenBoundaries(text, level_, num_pieces);
+
+    // Участки разбираются в свои словари с локальными ID
+    std::vector<TokenInterner> local(pieces.size());
+    std::vector<std::vector<MarkovChain::StateId>> local_tokens(pieces.size());
+    ParallelFor(pieces.size(), num_threads, [&](std::size_t p) {
+        TokenizeInto(pieces[p], level_, [&](std::string_view token) { return local[p].Intern(token); },
+                     local_tokens[p]);
+    });
+
+    // Словари вливаются в общий по порядку участков: локальные ID идут в порядке первого появления,
+    // поэтому глобальные ID те же, что дал бы последовательный разбор
+    std::vector<std::vector<MarkovChain::StateId>> to_global(pieces.size());
+    std::vector<std::size_t> offsets(pieces.size() + 1, 0);
+    for (std::size_t p = 0; p < pieces.size(); ++p) {
+        to_global[p].resize(local[p].Size());
+        for (TokenInterner::Id id = 0; id < local[p].Size(); ++id) {
+            to_global[p][id] = chain_.Intern(local[p].Resolve(id));
         }
+        offsets[p + 1] = offsets[p] + local_tokens[p].size();
+    }
 
-        if (NoSpaceAfterPrev(prev)) {
-            out += tok;
-            continue;
+    std::vector<MarkovChain::StateId> tokens(offsets.back());
+    ParallelFor(pieces.size(), num_threads, [&](std::size_t p) {
+        for (std::size_t i = 0; i < local_tokens[p].size(); ++i) {
+            tokens[offsets[p] + i] = to_global[p][local_tokens[p][i]];
         }
+    });
+    return tokens;
+}
 
-        out += ' ';
+void MarkovTextModel::AppendToken(std::string& out, std::string_view prev, std::string_view tok, bool first) const {
+    if (level_ == TokenLevel::Character || first) {
         out += tok;
+        return;
     }
 
-    return out;
+    if (tok.size() == 1 && IsPunctChar(static_cast<unsigned char>(tok[0])) && NoSpaceBefore(tok)) {
+        out += tok;
+        return;
+    }
+
+    if (NoSpaceAfterPrev(prev)) {
+        out += tok;
+        return;
+    }
+
+    out += ' ';
+    out += tok;
 }
 
-std::string MarkovTextModel::GenerateText(std::size_t num_tokens,
-                                         std::mt19937& rng,
-                                         const std::string& start_token) const {
-    if (num_tokens == 0) return {};
+MarkovChain::StateId MarkovTextModel::StartState(std::string_view start_token) const {
+    if (level_ == TokenLevel::Character) {
+        return chain_.FindState(start_token).value_or(0);
+    }
 
-    auto states = chain_.States();
-    if (states.empty()) return {};
+    // Нижний регистр в буфер на стеке; более длинный токен - редкий случай, там допустима строка
+    std::array<char, kStackTokenBytes> stack_buffer{};
+    std::string heap_buffer;
+    char* lowered = stack_buffer.data();
+    if (start_token.size() > stack_buffer.size()) {
+        heap_buffer.resize(start_token.size());
+        lowered = heap_buffer.data();
+    }
+    for (std::size_t i = 0; i < start_token.size(); ++i) {
+        lowered[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(start_token[i])));
+    }
+    return chain_.FindState(std::string_view(lowered, start_token.size())).value_or(0);
+}
 
-    std::string start = start_token;
-    if (level_ == TokenLevel::Word) {
-        for (char& ch : start) {
-            ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+void MarkovTextModel::GenerateTextInto(std::size_t num_tokens, RngRef rng, std::string_view start_token,
+                                       std::string& out) const {
+    if (num_tokens == 0 || chain_.NumStates() == 0) return;
+
+    // Поиск стартового токена - одна хеш-проба; токены сразу дописываются в out
+    MarkovChain::StateId cur = StartState(start_token);
+    std::string_view prev = chain_.StateName(cur);
+    AppendToken(out, {}, prev, true);
+
+    if (ngram_.has_value()) {
+        // Окно последних Order() токенов на стеке, как в NGramModel::Generate
+        std::array<MarkovChain::StateId, NGramModel::kMaxOrder> window{};
+        const std::size_t order = ngram_->Order();
+        window[0] = cur;
+        std::size_t filled = 1;
+        for (std::size_t produced = 1; produced < num_tokens; ++produced) {
+            const auto next = ngram_->SampleNext(std::span<const MarkovChain::StateId>(window.data(), filled), rng);
+            if (!next.has_value()) {
+                break;
+            }
+            const std::string_view tok = chain_.StateName(*next);
+            AppendToken(out, prev, tok, false);
+            prev = tok;
+            if (filled == order) {
+                std::copy(window.begin() + 1, window.begin() + static_cast<std::ptrdiff_t>(filled), window.begin());
+                --filled;
+            }
+            window[filled++] = *next;
         }
+        return;
     }
 
-    if (start.empty() || std::ranges::find(states, start) == states.end()) {
-        start = states.front();
+    for (std::size_t produced = 1; produced < num_tokens; ++produced) {
+        const auto next = chain_.SampleNextId(cur, rng);
+        if (!next.has_value()) {
+            break;
+        }
+        cur = *next;
+        const std::string_view tok = chain_.StateName(cur);
+        AppendToken(out, prev, tok, false);
+        prev = tok;
     }
+}
 
-    auto generated_tokens = chain_.Generate(start, num_tokens, rng);
-    return Detokenize(generated_tokens);
+std::string MarkovTextModel::GenerateText(std::size_t num_tokens,
+                                         RngRef rng,
+                                         const std::string& start_token) const {
+    std::string out;
+    GenerateTextInto(num_tokens, rng, start_token, out);
+    return out;
 }
 
 } // namespace ptm
@@ -1,10 +1,17 @@
 #ifndef PTM_MARKOVTEXTMODEL_HPP_
 #define PTM_MARKOVTEXTMODEL_HPP_
 
+#include <cstddef>
+#include <istream>
+#include <optional>
 #include <random>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "MarkovChain.hpp"
+#include "NGramModel.hpp"
 
 namespace ptm {
 
@@ -12,25 +19,56 @@ class MarkovTextModel {
 public:
   enum class TokenLevel { Character, Word }; // NOLINT
 
-  explicit MarkovTextModel(TokenLevel level = TokenLevel::Word);
+  static constexpr std::size_t kDefaultChunkBytes = 1 << 20;
 
-  // Первичное обучение / дообучение на тексте (одинаково, TrainFromText можно вызывать сколько угодно)
-  void TrainFromText(const std::string& text);
+  // order - длина контекста (1 - обычная цепь); при order > 1 генерация идёт по NGramModel с бэкоффом
+  explicit MarkovTextModel(TokenLevel level = TokenLevel::Word, std::size_t order = 1);
+
+  // Первичное обучение / дообучение на тексте (одинаково, TrainFromText можно вызывать сколько угодно).
+  // num_threads != 1 - разбор и подсчёт переходов параллельно по участкам текста (0 - по числу ядер);
+  // словарь и счётчики цепи совпадают с последовательным обучением
+  void TrainFromText(const std::string& text, std::size_t num_threads = 1);
+
+  // То же для текста из потока: читается кусками по chunk_bytes, разбор продолжается через границы
+  // кусков. Память - один кусок плюс сама модель и её счётчики, независимо от длины текста.
+  // Результат совпадает с TrainFromText на всём тексте
+  void TrainFromStream(std::istream& in, std::size_t chunk_bytes = kDefaultChunkBytes);
+
+  // TrainFromStream по файлу; std::runtime_error, если файл не открывается
+  void TrainFromFile(const std::string& path, std::size_t chunk_bytes = kDefaultChunkBytes);
 
   // Генерация текста:
   // - num_tokens: количество токенов (символов или слов в зависимости от уровня)
   // - start_token: опциональный стартовый токен; если не задан или не встречался,
   //   берётся первый известный токен модели
-  std::string GenerateText(std::size_t num_tokens, std::mt19937& rng, const std::string& start_token = "") const;
+  std::string GenerateText(std::size_t num_tokens, RngRef rng, const std::string& start_token = "") const;
+
+  // То же, но текст дописывается в конец out. Стартовый токен ищется одной хеш-пробой, токены
+  // пишутся в out по мере выборки; когда ёмкость out устоялась, вызов ничего не выделяет
+  void GenerateTextInto(std::size_t num_tokens, RngRef rng, std::string_view start_token, std::string& out) const;
 
+  // Цепь первого порядка; при любом order хранит словарь модели
   const MarkovChain& Chain() const noexcept;
 
+  [[nodiscard]] std::size_t Order() const noexcept;
+
 private:
   TokenLevel level_;
   MarkovChain chain_;
+  std::optional<NGramModel> ngram_;
+
+  // Токены сразу интернируются в словарь цепи - строка на токен не создаётся
+  std::vector<MarkovChain::StateId> Tokenize(const std::string& text);
+  std::vector<MarkovChain::StateId> TokenizeParallel(const std::string& text, std::size_t num_threads);
+
+  // Стартовые токены не длиннее этого переводятся в нижний регистр без выделения памяти
+  static constexpr std::size_t kStackTokenBytes = 256;
+
+  // ID стартового токена (в нижнем регистре для слов); незнакомый - первый токен словаря
+  [[nodiscard]] MarkovChain::StateId StartState(std::string_view start_token) const;
 
-  std::vector<std::string> Tokenize(const std::string& text) const;
-  std::string Detokenize(const std::vector<std::string>& tokens) const;
+  // Дописать tok после prev с пробелами по правилам пунктуации
+  void AppendToken(std::string& out, std::string_view prev, std::string_view tok, bool first) const;
 };
 
 } // namespace ptm
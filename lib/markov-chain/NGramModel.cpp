@@ -0,0 +1,180 @@
+#include "NGramModel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace ptm {
+
+namespace {
+
+std::uint64_t EdgeKey(std::uint32_t node, std::uint32_t token) {
+    return (static_cast<std::uint64_t>(node) << 32) | token;
+}
+
+} // namespace
+
+NGramModel::NGramModel(std::size_t order) : order_(order) {
+    if (order == 0 || order > kMaxOrder) {
+        throw std::invalid_argument("order must be in [1, kMaxOrder]");
+    }
+    counts_.row_offsets.push_back(0);
+    counts_.row_sums.push_back(0);
+}
+
+void NGramModel::Train(std::span<const Id> sequence) {
+    if (sequence.size() < 2) return;
+
+    sampling_.Reset();
+    frozen_.Reset();
+    Accumulate(sequence, 0, pending_);
+    num_rows_ = num_nodes_;
+}
+
+void NGramModel::Accumulate(std::span<const Id> sequence, std::size_t history, TransitionAccumulator& pending) {
+    for (std::size_t i = std::max<std::size_t>(history, 1); i < sequence.size(); ++i) {
+        const Id next = sequence[i];
+        Id node = kRoot;
+        pending.Add(node, next);
+
+        // Каждый узел пути получает счётчик, поэтому у любого узла дерева есть исходящие переходы
+        const std::size_t depth = std::min(order_, i);
+        for (std::size_t d = 1; d <= depth; ++d) {
+            const auto [child, inserted] = children_.TryEmplace(EdgeKey(node, sequence[i - d]), num_nodes_);
+            if (inserted && ++num_nodes_ == FlatHashMap<Id>::kEmptyKey >> 32) {
+                throw std::length_error("too many n-gram contexts");
+            }
+            node = *child;
+            pending.Add(node, next);
+        }
+    }
+}
+
+void NGramModel::Commit(TransitionAccumulator& pending) {
+    sampling_.Reset();
+    frozen_.Reset();
+    num_rows_ = num_nodes_;
+    if (pending_.Empty()) {
+        std::swap(pending_, pending);
+    } else {
+        pending_.Merge(pending);
+    }
+    pending = TransitionAccumulator();
+}
+
+const CsrTransitions& NGramModel::Counts() const {
+    frozen_.Get([this] {
+        pending_.FlushInto(counts_, num_rows_);
+        return Frozen{};
+    });
+    return counts_;
+}
+
+std::optional<NGramModel::Id> NGramModel::Child(Id node, Id token) const {
+    const Id* child = children_.Find(EdgeKey(node, token));
+    if (child == nullptr) {
+        return std::nullopt;
+    }
+    return *child;
+}
+
+std::pair<NGramModel::Id, std::size_t> NGramModel::Deepest(std::span<const Id> history) const {
+    const std::size_t num_rows = Counts().NumRows();
+    Id node = kRoot;
+    const std::size_t depth = std::min(order_, history.size());
+    for (std::size_t d = 1; d <= depth; ++d) {
+        // Узлы, созданные Accumulate до Commit, ещё без строки в CSR - для поиска их нет
+        const auto child = Child(node, history[history.size() - d]);
+        if (!child.has_value() || *child >= num_rows) {
+            return {node, d - 1};
+        }
+        node = *child;
+    }
+    return {node, depth};
+}
+
+double NGramModel::Probability(std::span<const Id> history, Id next) const {
+    const Id node = Deepest(history).first;
+    const CsrTransitions& counts = Counts();
+    const std::size_t sum = counts.row_sums[node];
+    if (sum == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(counts.Count(node, next)) / static_cast<double>(sum);
+}
+
+std::size_t NGramModel::MatchedOrder(std::span<const Id> history) const {
+    return Deepest(history).second;
+}
+
+const NGramModel::SamplingTables& NGramModel::Sampling() const {
+    const CsrTransitions& counts = Counts();
+    return sampling_.Get([&counts] {
+        SamplingTables tables;
+        tables.slots.resize(counts.columns.size());
+        for (std::size_t i = 0; i < counts.NumRows(); ++i) {
+            const auto row = counts.RowCounts(i);
+            if (!row.empty()) {
+                BuildAliasTable(row, std::span<AliasSlot>(tables.slots).subspan(counts.row_offsets[i], row.size()));
+            }
+        }
+        return tables;
+    });
+}
+
+std::optional<NGramModel::Id> NGramModel::SampleFrom(Id node, RngRef rng, const SamplingTables& tables) const {
+    const std::size_t begin = counts_.row_offsets[node];
+    const std::size_t end = counts_.row_offsets[node + 1];
+    if (begin == end) {
+        return std::nullopt;
+    }
+
+    const std::span<const AliasSlot> row(tables.slots.data() + begin, end - begin);
+    return counts_.columns[begin + SampleAlias(row, rng)];
+}
+
+std::optional<NGramModel::Id> NGramModel::SampleNext(std::span<const Id> history, RngRef rng) const {
+    return SampleFrom(Deepest(history).first, rng, Sampling());
+}
+
+std::size_t NGramModel::Generate(std::span<const Id> context, std::size_t length, RngRef rng,
+                                 std::vector<Id>& out) const {
+    const SamplingTables& tables = Sampling();
+
+    // Последние order_ токенов: сдвиг окна из <= kMaxOrder элементов дешевле обращения к дереву
+    std::array<Id, kMaxOrder> window{};
+    std::size_t filled = std::min(order_, context.size());
+    std::copy(context.end() - static_cast<std::ptrdiff_t>(filled), context.end(), window.begin());
+
+    std::size_t produced = 0;
+    while (produced < length) {
+        const auto next = SampleFrom(Deepest(std::span<const Id>(window.data(), filled)).first, rng, tables);
+        if (!next.has_value()) {
+            break;
+        }
+        out.push_back(*next);
+        ++produced;
+
+        if (filled == order_) {
+            std::copy(window.begin() + 1, window.begin() + static_cast<std::ptrdiff_t>(filled), window.begin());
+            --filled;
+        }
+        window[filled++] = *next;
+    }
+    return produced;
+}
+
+std::size_t NGramModel::Order() const noexcept {
+    return order_;
+}
+
+std::size_t NGramModel::NumContexts() const noexcept {
+    return num_nodes_;
+}
+
+std::size_t NGramModel::MemoryBytes() const {
+    return children_.MemoryBytes() + Counts().MemoryBytes();
+}
+
+} // namespace ptm
@@ -0,0 +1,101 @@
+#ifndef PTM_NGRAMMODEL_HPP_
+#define PTM_NGRAMMODEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "AliasTable.hpp"
+#include "FlatHashMap.hpp"
+#include "LazyCache.hpp"
+#include "TransitionTable.hpp"
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Марковская модель порядка k над ID токенов (см. TokenInterner).
+// Контексты хранятся в обратном префиксном дереве: от корня (пустой контекст) ребро ведёт к узлу
+// последнего токена, от него - к предпоследнему и т.д. до глубины k, так что контексты с общим
+// хвостом делят узлы. Рёбра - одна хеш-таблица (узел, токен) -> узел, счётчики следующего токена
+// для всех узлов - общий CSR, строка = узел.
+// Бэкофф: следующий токен берётся из самого глубокого узла, до которого доходит история;
+// незнакомый контекст сводится к более короткому, в пределе - к униграммам корня
+class NGramModel {
+public:
+  using Id = std::uint32_t;
+
+  static constexpr std::size_t kMaxOrder = 16;
+
+  // 1 <= order <= kMaxOrder, иначе std::invalid_argument
+  explicit NGramModel(std::size_t order);
+
+  // Обучение на одной последовательности (инкрементально); контекст не переходит между вызовами.
+  // O(n * k) хеш-обращений, счётчики сливаются в CSR при первом чтении после обучения. Память -
+  // O(число различных контекстов + различных пар контекст-токен)
+  void Train(std::span<const Id> sequence);
+
+  // Потоковое обучение: первые history токенов sequence - только контекст (хвост предыдущего куска),
+  // счётчики остальных копятся в pending; Commit передаёт их модели (в CSR - при первом чтении)
+  void Accumulate(std::span<const Id> sequence, std::size_t history, TransitionAccumulator& pending);
+  void Commit(TransitionAccumulator& pending);
+
+  // P(next | history) в самом длинном известном суффиксе history (последний элемент - самый свежий)
+  [[nodiscard]] double Probability(std::span<const Id> history, Id next) const;
+
+  // Длина контекста, из которого будет выбран следующий токен после history
+  [[nodiscard]] std::size_t MatchedOrder(std::span<const Id> history) const;
+
+  // Следующий токен за O(k) проходов по дереву и O(1) выборки. std::nullopt - модель не обучена
+  std::optional<Id> SampleNext(std::span<const Id> history, RngRef rng) const;
+
+  // Дописать в out до length токенов, продолжающих context; возвращает число дописанных
+  std::size_t Generate(std::span<const Id> context, std::size_t length, RngRef rng, std::vector<Id>& out) const;
+
+  [[nodiscard]] std::size_t Order() const noexcept;
+
+  // Число узлов дерева вместе с корнем
+  [[nodiscard]] std::size_t NumContexts() const noexcept;
+
+  // Байты дерева и счётчиков (без таблиц выборки)
+  [[nodiscard]] std::size_t MemoryBytes() const;
+
+private:
+  static constexpr Id kRoot = 0;
+
+  std::size_t order_;
+  Id num_nodes_ = 1;
+
+  // (родитель << 32 | токен) -> дочерний узел
+  FlatHashMap<Id> children_;
+
+  // Счётчики следующего токена по узлам; добавленные после последнего чтения лежат в pending_,
+  // CSR доводится до num_rows_ строк (узлы на момент последнего Train / Commit) при заморозке
+  mutable CsrTransitions counts_;
+  mutable TransitionAccumulator pending_;
+  Id num_rows_ = 1;
+
+  // Метка заморозки, как в MarkovChain: слияние идёт ровно один раз под замком LazyCache
+  struct Frozen {};
+  LazyCache<Frozen> frozen_;
+
+  struct SamplingTables {
+    std::vector<AliasSlot> slots;
+  };
+  LazyCache<SamplingTables> sampling_;
+
+  [[nodiscard]] std::optional<Id> Child(Id node, Id token) const;
+
+  // Самый глубокий узел, соответствующий суффиксу history, и его глубина
+  [[nodiscard]] std::pair<Id, std::size_t> Deepest(std::span<const Id> history) const;
+
+  [[nodiscard]] const CsrTransitions& Counts() const;
+  [[nodiscard]] const SamplingTables& Sampling() const;
+  [[nodiscard]] std::optional<Id> SampleFrom(Id node, RngRef rng, const SamplingTables& tables) const;
+};
+
+} // namespace ptm
+
+#endif // PTM_NGRAMMODEL_HPP_
@@ -0,0 +1,136 @@
+#include "TokenInterner.hpp"
+
+#include <stdexcept>
+
+namespace ptm {
+
+namespace {
+
+constexpr std::size_t kInitialSlots = 1024;
+
+} // namespace
+
+std::uint64_t HashToken(std::string_view token) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : token) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+TokenTableView::TokenTableView(std::span<const char> pool, std::span<const std::uint32_t> offsets,
+                               std::span<const TokenSlot> slots) noexcept
+    : pool_(pool), offsets_(offsets), slots_(slots) {
+}
+
+std::size_t TokenTableView::Probe(std::string_view token, std::uint64_t hash) const noexcept {
+    const std::size_t mask = slots_.size() - 1;
+    const auto tag = static_cast<std::uint32_t>(hash >> 32);
+    for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        const TokenSlot& slot = slots_[pos];
+        if (slot.id == kEmptyTokenSlot || (slot.hash == tag && Resolve(slot.id) == token)) {
+            return pos;
+        }
+    }
+}
+
+std::optional<std::uint32_t> TokenTableView::Find(std::string_view token) const noexcept {
+    const TokenSlot& slot = slots_[Probe(token, HashToken(token))];
+    if (slot.id == kEmptyTokenSlot) {
+        return std::nullopt;
+    }
+    return slot.id;
+}
+
+std::string_view TokenTableView::Resolve(std::uint32_t id) const noexcept {
+    return {pool_.data() + offsets_[id], offsets_[id + 1] - offsets_[id]};
+}
+
+std::size_t TokenTableView::Size() const noexcept {
+    return offsets_.size() - 1;
+}
+
+TokenInterner::TokenInterner() : offsets_{0}, slots_(kInitialSlots) {
+}
+
+TokenInterner::Id TokenInterner::Intern(std::string_view token) {
+    const std::uint64_t hash = HashToken(token);
+    std::size_t pos = View().Probe(token, hash);
+    if (slots_[pos].id != kEmptyTokenSlot) {
+        return slots_[pos].id;
+    }
+
+    if (Size() >= kEmptyTokenSlot - 1) {
+        throw std::length_error("too many distinct tokens");
+    }
+
+    const auto id = static_cast<Id>(Size());
+    pool_.insert(pool_.end(), token.begin(), token.end());
+    offsets_.push_back(static_cast<std::uint32_t>(pool_.size()));
+
+    // Заполнение не выше 1/2 - пробы остаются короткими
+    if (2 * Size() > slots_.size()) {
+        Grow();
+        pos = View().Probe(token, hash);
+    }
+    slots_[pos] = {id, static_cast<std::uint32_t>(hash >> 32)};
+    return id;
+}
+
+std::optional<TokenInterner::Id> TokenInterner::Find(std::string_view token) const {
+    return View().Find(token);
+}
+
+std::string_view TokenInterner::Resolve(Id id) const {
+    return View().Resolve(id);
+}
+
+std::size_t TokenInterner::Size() const noexcept {
+    return offsets_.size() - 1;
+}
+
+std::size_t TokenInterner::MemoryBytes() const noexcept {
+    return pool_.capacity() + offsets_.capacity() * sizeof(std::uint32_t) + slots_.capacity() * sizeof(TokenSlot);
+}
+
+TokenTableView TokenInterner::View() const noexcept {
+    return {pool_, offsets_, slots_};
+}
+
+std::span<const char> TokenInterner::Pool() const noexcept {
+    return pool_;
+}
+
+std::span<const std::uint32_t> TokenInterner::Offsets() const noexcept {
+    return offsets_;
+}
+
+std::span<const TokenSlot> TokenInterner::Slots() const noexcept {
+    return slots_;
+}
+
+void TokenInterner::Grow() {
+    std::vector<TokenSlot> old(slots_.size() * 2);
+    old.swap(slots_);
+
+    const std::size_t mask = slots_.size() - 1;
+    for (const TokenSlot& slot : old) {
+        if (slot.id == kEmptyTokenSlot) {
+            continue;
+        }
+        // Полный хеш пересчитывается по байтам из пула - в ячейке хранится только старшая половина
+        std::size_t pos = HashToken(Resolve(slot.id)) & mask;
+        while (slots_[pos].id != kEmptyTokenSlot) {
+            pos = (pos + 1) & mask;
+        }
+        slots_[pos] = slot;
+    }
+}
+
+} // namespace ptm
@@ -0,0 +1,82 @@
+#ifndef PTM_TOKENINTERNER_HPP_
+#define PTM_TOKENINTERNER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ptm {
+
+inline constexpr std::uint32_t kEmptyTokenSlot = 0xffffffffU;
+
+// Ячейка хеш-таблицы словаря: ID токена и старшая половина его хеша
+struct TokenSlot {
+  std::uint32_t id = kEmptyTokenSlot;
+  std::uint32_t hash = 0;
+};
+
+// FNV-1a с финальным перемешиванием из SplitMix64: токены короткие, а младшие биты должны быть хорошими
+[[nodiscard]] std::uint64_t HashToken(std::string_view token) noexcept;
+
+// Словарь только для чтения поверх чужих массивов (словарь TokenInterner или отображённый снимок):
+// токен i - pool[offsets[i], offsets[i + 1]), slots - таблица с линейным пробированием размера 2^m
+class TokenTableView {
+public:
+  TokenTableView(std::span<const char> pool, std::span<const std::uint32_t> offsets,
+                 std::span<const TokenSlot> slots) noexcept;
+
+  [[nodiscard]] std::optional<std::uint32_t> Find(std::string_view token) const noexcept;
+  [[nodiscard]] std::string_view Resolve(std::uint32_t id) const noexcept;
+  [[nodiscard]] std::size_t Size() const noexcept;
+
+  // Ячейка с токеном или первая пустая на его пути
+  [[nodiscard]] std::size_t Probe(std::string_view token, std::uint64_t hash) const noexcept;
+
+private:
+  std::span<const char> pool_;
+  std::span<const std::uint32_t> offsets_;
+  std::span<const TokenSlot> slots_;
+};
+
+// Словарь токенов: строка <-> плотный uint32_t ID в порядке первого появления.
+// Байты всех токенов лежат подряд в одном пуле (без отдельной кучи на токен), поиск -
+// открытая адресация с линейным пробированием по степени двойки, в ячейке ID и часть хеша
+class TokenInterner {
+public:
+  using Id = std::uint32_t;
+
+  TokenInterner();
+
+  // ID токена; новый токен получает следующий свободный ID
+  Id Intern(std::string_view token);
+
+  [[nodiscard]] std::optional<Id> Find(std::string_view token) const;
+
+  // Представление действительно, пока в словарь не добавлен новый токен
+  [[nodiscard]] std::string_view Resolve(Id id) const;
+
+  [[nodiscard]] std::size_t Size() const noexcept;
+
+  // Байты пула, смещений и хеш-таблицы
+  [[nodiscard]] std::size_t MemoryBytes() const noexcept;
+
+  // Массивы словаря как есть (для сериализации); действительны до следующего Intern
+  [[nodiscard]] TokenTableView View() const noexcept;
+  [[nodiscard]] std::span<const char> Pool() const noexcept;
+  [[nodiscard]] std::span<const std::uint32_t> Offsets() const noexcept;
+  [[nodiscard]] std::span<const TokenSlot> Slots() const noexcept;
+
+private:
+  std::vector<char> pool_;
+  std::vector<std::uint32_t> offsets_; // токен i - pool_[offsets_[i], offsets_[i + 1])
+  std::vector<TokenSlot> slots_;
+
+  void Grow();
+};
+
+} // namespace ptm
+
+#endif // PTM_TOKENINTERNER_HPP_
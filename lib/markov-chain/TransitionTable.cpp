@@ -0,0 +1,209 @@
+#include "TransitionTable.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "parallel/ParallelFor.hpp"
+
+namespace ptm {
+
+std::size_t CsrTransitions::NumRows() const noexcept {
+    return row_offsets.size() - 1;
+}
+
+std::span<const std::uint32_t> CsrTransitions::RowColumns(std::size_t i) const noexcept {
+    return std::span<const std::uint32_t>(columns).subspan(row_offsets[i], row_offsets[i + 1] - row_offsets[i]);
+}
+
+std::span<const std::size_t> CsrTransitions::RowCounts(std::size_t i) const noexcept {
+    return std::span<const std::size_t>(counts).subspan(row_offsets[i], row_offsets[i + 1] - row_offsets[i]);
+}
+
+std::size_t CsrTransitions::Count(std::size_t i, std::size_t j) const noexcept {
+    const auto row = RowColumns(i);
+    const auto it = std::lower_bound(row.begin(), row.end(), j);
+    if (it == row.end() || *it != j) {
+        return 0;
+    }
+    return counts[row_offsets[i] + static_cast<std::size_t>(it - row.begin())];
+}
+
+std::size_t CsrTransitions::MemoryBytes() const noexcept {
+    return row_offsets.capacity() * sizeof(std::size_t) + columns.capacity() * sizeof(std::uint32_t) +
+           counts.capacity() * sizeof(std::size_t) + row_sums.capacity() * sizeof(std::size_t);
+}
+
+void TransitionAccumulator::Add(std::uint32_t from, std::uint32_t to, std::size_t count) {
+    counts_[(static_cast<std::uint64_t>(from) << 32) | to] += count;
+}
+
+void TransitionAccumulator::Merge(const TransitionAccumulator& other) {
+    other.counts_.ForEach([this](std::uint64_t key, std::size_t count) { counts_[key] += count; });
+}
+
+bool TransitionAccumulator::Empty() const noexcept {
+    return counts_.Empty();
+}
+
+void TransitionAccumulator::FlushInto(CsrTransitions& csr, std::size_t num_rows) {
+    if (counts_.Empty() && csr.NumRows() == num_rows) {
+        return;
+    }
+
+    // Ключ from << 32 | to: сортировка по ключу сразу даёт порядок строк и столбцов CSR
+    std::vector<std::pair<std::uint64_t, std::size_t>> added;
+    added.reserve(counts_.Size());
+    counts_.ForEach([&added](std::uint64_t key, std::size_t count) { added.emplace_back(key, count); });
+    counts_.Clear();
+    std::sort(added.begin(), added.end());
+
+    MergeSortedCounts(csr, added, num_rows);
+}
+
+void MergeSortedCounts(CsrTransitions& csr, std::span<const std::pair<std::uint64_t, std::size_t>> added,
+                       std::size_t num_rows) {
+    CsrTransitions merged;
+    merged.row_offsets.reserve(num_rows + 1);
+    merged.columns.reserve(csr.columns.size() + added.size());
+    merged.counts.reserve(csr.counts.size() + added.size());
+    merged.row_sums.assign(num_rows, 0);
+
+    // Слияние двух отсортированных списков строка за строкой
+    std::size_t a = 0;
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        const std::size_t old_begin = i < csr.NumRows() ? csr.row_offsets[i] : csr.columns.size();
+        const std::size_t old_end = i < csr.NumRows() ? csr.row_offsets[i + 1] : csr.columns.size();
+        std::size_t o = old_begin;
+
+        auto push = [&](std::uint32_t column, std::size_t count) {
+            if (!merged.columns.empty() && merged.columns.size() > merged.row_offsets.back() &&
+                merged.columns.back() == column) {
+                merged.counts.back() += count;
+            } else {
+                merged.columns.push_back(column);
+                merged.counts.push_back(count);
+            }
+            merged.row_sums[i] += count;
+        };
+
+        while (o < old_end || (a < added.size() && (added[a].first >> 32) == i)) {
+            const bool take_old = a >= added.size() || (added[a].first >> 32) != i ||
+                                  (o < old_end && csr.columns[o] <= static_cast<std::uint32_t>(added[a].first));
+            if (take_old) {
+                push(csr.columns[o], csr.counts[o]);
+                ++o;
+            } else {
+                push(static_cast<std::uint32_t>(added[a].first), added[a].second);
+                ++a;
+            }
+        }
+        merged.row_offsets.push_back(merged.columns.size());
+    }
+
+    csr = std::move(merged);
+}
+
+void AddTransitionsParallel(std::span<const std::uint32_t> sequence, std::size_t num_rows, std::size_t num_threads,
+                            CsrTransitions& csr) {
+    const std::size_t num_pairs = sequence.empty() ? 0 : sequence.size() - 1;
+    const std::size_t num_shards =
+        std::clamp<std::size_t>(num_pairs / kMinPairsPerShard, 1, ResolveThreadCount(num_threads));
+
+    if (num_shards == 1) {
+        TransitionAccumulator pending;
+        for (std::size_t i = 0; i < num_pairs; ++i) {
+            pending.Add(sequence[i], sequence[i + 1]);
+        }
+        pending.FlushInto(csr, num_rows);
+        return;
+    }
+
+    // 1. Каждый участок считает свои переходы и гистограмму различных пар по строкам
+    std::vector<FlatHashMap<std::size_t>> local(num_shards);
+    std::vector<std::vector<std::size_t>> row_pairs(num_shards);
+    ParallelFor(num_shards, num_shards, [&](std::size_t s) {
+        const std::size_t begin = s * num_pairs / num_shards;
+        const std::size_t end = (s + 1) * num_pairs / num_shards;
+        FlatHashMap<std::size_t>& counts = local[s];
+        for (std::size_t i = begin; i < end; ++i) {
+            counts[(static_cast<std::uint64_t>(sequence[i]) << 32) | sequence[i + 1]] += 1;
+        }
+        row_pairs[s].assign(num_rows, 0);
+        counts.ForEach([&](std::uint64_t key, std::size_t /*count*/) { ++row_pairs[s][key >> 32]; });
+    });
+
+    // 2. Диапазоны строк с примерно равным числом пар - по одному на поток свёртки
+    std::size_t total_pairs = 0;
+    for (const auto& hist : row_pairs) {
+        for (std::size_t c : hist) {
+            total_pairs += c;
+        }
+    }
+    std::vector<std::uint32_t> part_of_row(num_rows);
+    {
+        std::size_t part = 0;
+        std::size_t seen = 0;
+        for (std::size_t r = 0; r < num_rows; ++r) {
+            while (part + 1 < num_shards && seen >= (part + 1) * total_pairs / num_shards) {
+                ++part;
+            }
+            part_of_row[r] = static_cast<std::uint32_t>(part);
+            for (const auto& hist : row_pairs) {
+                seen += hist[r];
+            }
+        }
+    }
+    row_pairs.clear();
+
+    // 3. Каждый участок раскладывает свои пары по диапазонам строк
+    using Entry = std::pair<std::uint64_t, std::size_t>;
+    std::vector<std::vector<std::vector<Entry>>> buckets(num_shards, std::vector<std::vector<Entry>>(num_shards));
+    ParallelFor(num_shards, num_shards, [&](std::size_t s) {
+        local[s].ForEach([&](std::uint64_t key, std::size_t count) {
+            buckets[s][part_of_row[key >> 32]].emplace_back(key, count);
+        });
+        local[s] = FlatHashMap<std::size_t>();
+    });
+
+    // 4. Свёртка диапазона: сортировка и сложение одинаковых ключей из разных участков
+    std::vector<std::vector<Entry>> reduced(num_shards);
+    ParallelFor(num_shards, num_shards, [&](std::size_t p) {
+        std::vector<Entry>& out = reduced[p];
+        std::size_t size = 0;
+        for (std::size_t s = 0; s < num_shards; ++s) {
+            size += buckets[s][p].size();
+        }
+        out.reserve(size);
+        for (std::size_t s = 0; s < num_shards; ++s) {
+            out.insert(out.end(), buckets[s][p].begin(), buckets[s][p].end());
+            std::vector<Entry>().swap(buckets[s][p]);
+        }
+        std::sort(out.begin(), out.end());
+
+        std::size_t w = 0;
+        for (std::size_t r = 0; r < out.size(); ++r) {
+            if (w > 0 && out[w - 1].first == out[r].first) {
+                out[w - 1].second += out[r].second;
+            } else {
+                out[w++] = out[r];
+            }
+        }
+        out.resize(w);
+    });
+
+    // Диапазоны идут по возрастанию строк, поэтому их конкатенация отсортирована
+    std::vector<Entry> added;
+    std::size_t size = 0;
+    for (const auto& part : reduced) {
+        size += part.size();
+    }
+    added.reserve(size);
+    for (auto& part : reduced) {
+        added.insert(added.end(), part.begin(), part.end());
+        std::vector<Entry>().swap(part);
+    }
+
+    MergeSortedCounts(csr, added, num_rows);
+}
+
+} // namespace ptm
@@ -0,0 +1,69 @@
+#ifndef PTM_TRANSITIONTABLE_HPP_
+#define PTM_TRANSITIONTABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "FlatHashMap.hpp"
+
+namespace ptm {
+
+// Замороженные счётчики переходов в формате CSR: переходы из i лежат в
+// [row_offsets[i], row_offsets[i + 1]) массивов columns/counts, столбцы строки по возрастанию.
+// Память - O(|V| + число различных переходов) вместо |V|^2 у плотной матрицы
+struct CsrTransitions {
+  std::vector<std::size_t> row_offsets = {0};
+  std::vector<std::uint32_t> columns;
+  std::vector<std::size_t> counts;
+  std::vector<std::size_t> row_sums;
+
+  [[nodiscard]] std::size_t NumRows() const noexcept;
+  [[nodiscard]] std::span<const std::uint32_t> RowColumns(std::size_t i) const noexcept;
+  [[nodiscard]] std::span<const std::size_t> RowCounts(std::size_t i) const noexcept;
+
+  // c_ij бинарным поиском по строке, 0 - если перехода нет
+  [[nodiscard]] std::size_t Count(std::size_t i, std::size_t j) const noexcept;
+
+  // Байты, занятые массивами
+  [[nodiscard]] std::size_t MemoryBytes() const noexcept;
+};
+
+// Счётчики на время обучения: плоская хеш-таблица (from, to) -> count, добавление за O(1).
+// FlushInto сливает их в CSR и очищает накопитель
+class TransitionAccumulator {
+public:
+  void Add(std::uint32_t from, std::uint32_t to, std::size_t count = 1);
+  void Merge(const TransitionAccumulator& other);
+
+  [[nodiscard]] bool Empty() const noexcept;
+
+  // Слить накопленное в csr, доведя число строк до num_rows; O(nnz(csr) + k log k) для k новых пар,
+  // ничего не делает, если сливать нечего и строк уже num_rows
+  void FlushInto(CsrTransitions& csr, std::size_t num_rows);
+
+private:
+  FlatHashMap<std::size_t> counts_;
+};
+
+// Слить в csr счётчики added - пары (from << 32 | to, count), отсортированные по ключу без повторов;
+// число строк доводится до num_rows. O(nnz(csr) + added.size())
+void MergeSortedCounts(CsrTransitions& csr, std::span<const std::pair<std::uint64_t, std::size_t>> added,
+                       std::size_t num_rows);
+
+// Переходов на участок AddTransitionsParallel: меньшие участки не окупают слияния
+inline constexpr std::size_t kMinPairsPerShard = 1 << 16;
+
+// Добавить в csr переходы sequence[i] -> sequence[i + 1] на num_threads потоках (0 - по числу ядер).
+// Последовательность режется на участки по позициям; переход через границу участков считает левый
+// участок, так что ни один не теряется и не удваивается. Каждый поток копит свою хеш-таблицу, затем
+// пары раскладываются по диапазонам строк примерно равного объёма и сортируются параллельно.
+// Результат совпадает с TransitionAccumulator + FlushInto при любом num_threads
+void AddTransitionsParallel(std::span<const std::uint32_t> sequence, std::size_t num_rows, std::size_t num_threads,
+                            CsrTransitions& csr);
+
+} // namespace ptm
+
+#endif // PTM_TRANSITIONTABLE_HPP_
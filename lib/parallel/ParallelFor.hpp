@@ -0,0 +1,99 @@
+#ifndef PTM_PARALLELFOR_HPP_
+#define PTM_PARALLELFOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ThreadPool.hpp"
+
+namespace ptm {
+
+// Число потоков по умолчанию (num_threads == 0)
+inline std::size_t ResolveThreadCount(std::size_t num_threads) {
+  if (num_threads != 0) {
+    return num_threads;
+  }
+  return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Выполнить fn(i) для i из [0, num_tasks) на num_threads потоках: вызывающий поток
+// и num_threads - 1 помощников из ThreadPool::Shared().
+// Задачи раздаются динамически, поэтому fn не должна полагаться на порядок или распределение по потокам.
+// Вызывающий поток не ждёт помощников, которые не успели стартовать, поэтому вложенные вызовы не блокируются.
+// Первое исключение из fn пробрасывается после завершения всех участников
+template <typename F>
+void ParallelFor(std::size_t num_tasks, std::size_t num_threads, F&& fn) {
+  num_threads = std::min(ResolveThreadCount(num_threads), num_tasks);
+
+  if (num_threads <= 1) {
+    for (std::size_t i = 0; i < num_tasks; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  struct State {
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t active = 0;
+    bool closed = false;
+    std::exception_ptr error;
+  };
+  auto state = std::make_shared<State>();
+
+  auto run = [&fn, num_tasks](State& s) {
+    try {
+      for (std::size_t i = s.next.fetch_add(1); i < num_tasks; i = s.next.fetch_add(1)) {
+        fn(i);
+      }
+    } catch (...) {
+      s.next.store(num_tasks);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (!s.error) {
+        s.error = std::current_exception();
+      }
+    }
+  };
+
+  ThreadPool& pool = ThreadPool::Shared();
+  pool.EnsureWorkers(num_threads - 1);
+
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    pool.Submit([state, run]() {
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->closed) {
+          return;
+        }
+        ++state->active;
+      }
+      run(*state);
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        --state->active;
+      }
+      state->cv.notify_all();
+    });
+  }
+
+  run(*state);
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->closed = true;
+  state->cv.wait(lock, [&]() { return state->active == 0; });
+
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+} // namespace ptm
+
+#endif // PTM_PARALLELFOR_HPP_
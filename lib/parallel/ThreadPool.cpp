@@ -0,0 +1,64 @@
+#include "ThreadPool.hpp"
+
+#include <utility>
+
+namespace ptm {
+
+ThreadPool::ThreadPool(std::size_t num_workers) {
+    EnsureWorkers(num_workers);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::EnsureWorkers(std::size_t num_workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (workers_.size() < num_workers) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+std::size_t ThreadPool::GetWorkerCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workers_.size();
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace ptm
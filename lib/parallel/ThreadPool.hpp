@@ -0,0 +1,48 @@
+#ifndef PTM_THREADPOOL_HPP_
+#define PTM_THREADPOOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ptm {
+
+// Пул рабочих потоков с общей очередью задач. Потоки создаются один раз и переиспользуются
+// между вызовами ParallelFor, поэтому короткие параллельные циклы не платят за создание потоков
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t num_workers = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  void Submit(std::function<void()> task);
+
+  // Дорастить пул до num_workers потоков (пул никогда не уменьшается)
+  void EnsureWorkers(std::size_t num_workers);
+
+  [[nodiscard]] std::size_t GetWorkerCount() const;
+
+  // Общий пул процесса, на нём работает ParallelFor
+  static ThreadPool& Shared();
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+
+  void WorkerLoop();
+};
+
+} // namespace ptm
+
+#endif // PTM_THREADPOOL_HPP_
@@ -0,0 +1,30 @@
+#ifndef PTM_COUNTERSTREAMS_HPP_
+#define PTM_COUNTERSTREAMS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Philox4x32.hpp"
+
+namespace ptm {
+
+// Ключ воспроизводимого эксперимента. Работа режется на блоки фиксированного размера,
+// и блок block получает собственный поток Philox, адресуемый тройкой (seed, stream, block).
+// Результат поэтому не зависит ни от числа потоков исполнения, ни от порядка обработки блоков
+struct StreamKey {
+  std::uint64_t seed = 0;
+  std::uint32_t stream = 0;
+};
+
+// Число значений выборки в одном блоке. Часть ключа воспроизводимости: при смене размера меняются результаты
+constexpr std::size_t kStreamBlockSize = std::size_t{1} << 16;
+
+// Генератор блока: ключ Philox = seed, номер потока Philox = (stream << 32) | block.
+// Внутри блока доступно 2^64 значений, поэтому блоки не пересекаются при любом расходе случайности
+inline Philox4x32 BlockRng(const StreamKey& key, std::uint32_t block) {
+  return Philox4x32(key.seed, (static_cast<std::uint64_t>(key.stream) << 32) | block);
+}
+
+} // namespace ptm
+
+#endif // PTM_COUNTERSTREAMS_HPP_
@@ -0,0 +1,86 @@
+#include "Pcg64.hpp"
+
+namespace ptm {
+
+namespace {
+
+// Полное 64 x 64 -> 128 умножение
+void Mul64(std::uint64_t a, std::uint64_t b, std::uint64_t& hi, std::uint64_t& lo) {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+    hi = static_cast<std::uint64_t>(p >> 64);
+    lo = static_cast<std::uint64_t>(p);
+#else
+    const std::uint64_t a_lo = a & 0xffffffffULL;
+    const std::uint64_t a_hi = a >> 32;
+    const std::uint64_t b_lo = b & 0xffffffffULL;
+    const std::uint64_t b_hi = b >> 32;
+
+    const std::uint64_t ll = a_lo * b_lo;
+    const std::uint64_t lh = a_lo * b_hi;
+    const std::uint64_t hl = a_hi * b_lo;
+    const std::uint64_t hh = a_hi * b_hi;
+
+    const std::uint64_t mid = (ll >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+    lo = (mid << 32) | (ll & 0xffffffffULL);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+} // namespace
+
+Pcg64::Uint128 Pcg64::Add(Uint128 a, Uint128 b) {
+    Uint128 r;
+    r.lo = a.lo + b.lo;
+    r.hi = a.hi + b.hi + (r.lo < a.lo ? 1 : 0);
+    return r;
+}
+
+Pcg64::Uint128 Pcg64::Mul(Uint128 a, Uint128 b) {
+    Uint128 r;
+    Mul64(a.lo, b.lo, r.hi, r.lo);
+    r.hi += a.hi * b.lo + a.lo * b.hi;
+    return r;
+}
+
+// Инициализация как pcg_setseq_128_srandom_r: старшая половина seed/stream нулевая
+Pcg64::Pcg64(std::uint64_t seed, std::uint64_t stream) {
+    inc_ = {stream >> 63, (stream << 1) | 1};
+    Step();
+    state_ = Add(state_, Uint128{0, seed});
+    Step();
+}
+
+// Brown, "Random Number Generation with Arbitrary Stride"
+void Pcg64::Advance(Uint128 delta) {
+    Uint128 cur_mult = kMultiplier;
+    Uint128 cur_plus = inc_;
+    Uint128 acc_mult = {0, 1};
+    Uint128 acc_plus = {0, 0};
+
+    while (delta.hi != 0 || delta.lo != 0) {
+        if ((delta.lo & 1) != 0) {
+            acc_mult = Mul(acc_mult, cur_mult);
+            acc_plus = Add(Mul(acc_plus, cur_mult), cur_plus);
+        }
+        cur_plus = Mul(Add(cur_mult, Uint128{0, 1}), cur_plus);
+        cur_mult = Mul(cur_mult, cur_mult);
+
+        delta.lo = (delta.lo >> 1) | (delta.hi << 63);
+        delta.hi >>= 1;
+    }
+
+    state_ = Add(Mul(acc_mult, state_), acc_plus);
+}
+
+void Pcg64::Jump() {
+    Advance({0x9e3779b97f4a7c15ULL, 0xf39cc0605cedc834ULL});
+}
+
+Pcg64 Pcg64::Split() {
+    Pcg64 current = *this;
+    Jump();
+    return current;
+}
+
+} // namespace ptm
@@ -0,0 +1,63 @@
+#ifndef PTM_PCG64_HPP_
+#define PTM_PCG64_HPP_
+
+#include <cstdint>
+#include <limits>
+
+namespace ptm {
+
+// PCG64 (O'Neill, XSL-RR 128/64): 128-битный LCG с перестановкой выхода.
+// stream задаёт приращение LCG, поэтому генераторы с разными stream независимы
+class Pcg64 {
+public:
+  using result_type = std::uint64_t;
+
+  // 128-битное беззнаковое число без опоры на расширения компилятора
+  struct Uint128 {
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+  };
+
+  explicit Pcg64(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+  static constexpr result_type min() { // NOLINT
+    return 0;
+  }
+
+  static constexpr result_type max() { // NOLINT
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    Step();
+    const std::uint64_t xored = state_.hi ^ state_.lo;
+    const unsigned rot = static_cast<unsigned>(state_.hi >> 58);
+    return (xored >> rot) | (xored << ((64 - rot) & 63));
+  }
+
+  // Перейти на delta шагов вперёд за O(log delta)
+  void Advance(Uint128 delta);
+
+  // Сдвиг на floor(2^128 / phi) шагов - как jumped() в numpy
+  void Jump();
+
+  // Вернуть генератор на текущей позиции, а самому прыгнуть вперёд через Jump
+  Pcg64 Split();
+
+private:
+  Uint128 state_;
+  Uint128 inc_;
+
+  static Uint128 Add(Uint128 a, Uint128 b);
+  static Uint128 Mul(Uint128 a, Uint128 b);
+
+  void Step() {
+    state_ = Add(Mul(state_, kMultiplier), inc_);
+  }
+
+  static constexpr Uint128 kMultiplier = {0x2360ed051fc65da4ULL, 0x4385df649fccf645ULL};
+};
+
+} // namespace ptm
+
+#endif // PTM_PCG64_HPP_
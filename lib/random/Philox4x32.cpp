@@ -0,0 +1,89 @@
+#include "Philox4x32.hpp"
+
+namespace ptm {
+
+namespace {
+
+constexpr std::uint32_t kMul0 = 0xD2511F53U;
+constexpr std::uint32_t kMul1 = 0xCD9E8D57U;
+constexpr std::uint32_t kWeyl0 = 0x9E3779B9U;
+constexpr std::uint32_t kWeyl1 = 0xBB67AE85U;
+
+void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo) {
+    const std::uint64_t p = static_cast<std::uint64_t>(a) * b;
+    hi = static_cast<std::uint32_t>(p >> 32);
+    lo = static_cast<std::uint32_t>(p);
+}
+
+} // namespace
+
+Philox4x32::Block Philox4x32::Encrypt(Block c, Key k) {
+    for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+            k[0] += kWeyl0;
+            k[1] += kWeyl1;
+        }
+
+        std::uint32_t hi0 = 0;
+        std::uint32_t lo0 = 0;
+        std::uint32_t hi1 = 0;
+        std::uint32_t lo1 = 0;
+        MulHiLo(kMul0, c[0], hi0, lo0);
+        MulHiLo(kMul1, c[2], hi1, lo1);
+
+        c = {hi1 ^ c[1] ^ k[0], lo1, hi0 ^ c[3] ^ k[1], lo0};
+    }
+    return c;
+}
+
+Philox4x32::Philox4x32(std::uint64_t seed, std::uint64_t stream) :
+    key_({static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}),
+    stream_(stream),
+    block_(0),
+    buffer_(),
+    index_(2) {
+}
+
+void Philox4x32::Refill() {
+    const Block counter = {static_cast<std::uint32_t>(block_),
+                           static_cast<std::uint32_t>(block_ >> 32),
+                           static_cast<std::uint32_t>(stream_),
+                           static_cast<std::uint32_t>(stream_ >> 32)};
+    buffer_ = Encrypt(counter, key_);
+    ++block_;
+    index_ = 0;
+}
+
+void Philox4x32::Discard(std::uint64_t n) {
+    const std::uint64_t position = GetPosition() + n;
+    block_ = position / 2;
+    index_ = 2;
+
+    if (position % 2 != 0) {
+        Refill();
+        index_ = 1;
+    }
+}
+
+void Philox4x32::Jump() {
+    ++stream_;
+    block_ = 0;
+    index_ = 2;
+}
+
+Philox4x32 Philox4x32::Split() {
+    Philox4x32 current = *this;
+    Jump();
+    return current;
+}
+
+std::uint64_t Philox4x32::GetStream() const noexcept {
+    return stream_;
+}
+
+std::uint64_t Philox4x32::GetPosition() const noexcept {
+    // block_ уже указывает на следующий блок, если буфер заполнен
+    return index_ == 2 ? 2 * block_ : 2 * (block_ - 1) + index_;
+}
+
+} // namespace ptm
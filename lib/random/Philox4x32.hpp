@@ -0,0 +1,69 @@
+#ifndef PTM_PHILOX4X32_HPP_
+#define PTM_PHILOX4X32_HPP_
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace ptm {
+
+// Philox4x32-10 (Salmon et al., Random123): счётчиковый генератор.
+// Блок из 128 бит = Philox(key, counter); key берётся из seed, старшие 64 бита счётчика - номер потока,
+// младшие 64 бита - номер блока внутри потока. Состояние - 32 байта, любая позиция доступна за O(1)
+class Philox4x32 {
+public:
+  using result_type = std::uint64_t;
+  using Block = std::array<std::uint32_t, 4>;
+  using Key = std::array<std::uint32_t, 2>;
+
+  explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+  static constexpr result_type min() { // NOLINT
+    return 0;
+  }
+
+  static constexpr result_type max() { // NOLINT
+    return std::numeric_limits<result_type>::max();
+  }
+
+  // Каждый блок даёт два 64-битных значения
+  result_type operator()() {
+    if (index_ == 2) {
+      Refill();
+    }
+    const std::uint64_t hi = buffer_[2 * index_];
+    const std::uint64_t lo = buffer_[2 * index_ + 1];
+    ++index_;
+    return (hi << 32) | lo;
+  }
+
+  // Чистая функция раундов: 10 раундов Philox над counter с ключом key
+  static Block Encrypt(Block counter, Key key);
+
+  // Пропустить n 64-битных значений за O(1)
+  void Discard(std::uint64_t n);
+
+  // Перейти к следующему потоку (номер потока + 1, позиция 0)
+  void Jump();
+
+  // Вернуть генератор на текущем потоке, а самому перейти к следующему
+  Philox4x32 Split();
+
+  [[nodiscard]] std::uint64_t GetStream() const noexcept;
+
+  // Номер следующего 64-битного значения внутри потока
+  [[nodiscard]] std::uint64_t GetPosition() const noexcept;
+
+private:
+  Key key_;
+  std::uint64_t stream_;
+  std::uint64_t block_;
+  Block buffer_;
+  std::uint32_t index_;
+
+  void Refill();
+};
+
+} // namespace ptm
+
+#endif // PTM_PHILOX4X32_HPP_
@@ -0,0 +1,112 @@
+#ifndef PTM_RNGREF_HPP_
+#define PTM_RNGREF_HPP_
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <type_traits>
+
+namespace ptm {
+
+// Генератор, выдающий равномерные 32- или 64-битные слова (std::mt19937, std::mt19937_64, Xoshiro256PlusPlus, ...)
+template <typename G>
+concept FullRangeBitGenerator =
+    std::uniform_random_bit_generator<G> && G::min() == 0 &&
+    (G::max() == std::numeric_limits<std::uint32_t>::max() || G::max() == std::numeric_limits<std::uint64_t>::max());
+
+// Невладеющая ссылка на произвольный генератор со стёртым типом.
+// Виртуальный API распределений принимает RngRef, поэтому подходит любой генератор; пакетные
+// FillBits/FillUniform делают один косвенный вызов на блок, а цикл по генератору внутри инлайнится.
+// Сам RngRef тоже удовлетворяет std::uniform_random_bit_generator (64-битные значения)
+class RngRef {
+public:
+  using result_type = std::uint64_t;
+
+  template <FullRangeBitGenerator G>
+    requires(!std::same_as<std::remove_cv_t<G>, RngRef>)
+  RngRef(G& engine) noexcept : engine_(&engine), ops_(&kOps<G>) { // NOLINT(google-explicit-constructor)
+  }
+
+  static constexpr result_type min() { // NOLINT
+    return 0;
+  }
+
+  static constexpr result_type max() { // NOLINT
+    return std::numeric_limits<result_type>::max();
+  }
+
+  // 64 равномерных бита (32-битные генераторы отдают два выхода: старший, затем младший)
+  result_type operator()() {
+    return ops_->next_bits(engine_);
+  }
+
+  // U(0, 1) без концов. Для 32-битных генераторов - (x + 0.5) / 2^32 от одного выхода,
+  // для 64-битных - 53 старших бита: ((x >> 11) + 0.5) / 2^53
+  double NextUniform() {
+    return ops_->next_uniform(engine_);
+  }
+
+  void FillBits(std::span<std::uint64_t> out) {
+    ops_->fill_bits(engine_, out.data(), out.size());
+  }
+
+  void FillUniform(std::span<double> out) {
+    ops_->fill_uniform(engine_, out.data(), out.size());
+  }
+
+private:
+  struct Ops {
+    std::uint64_t (*next_bits)(void*);
+    double (*next_uniform)(void*);
+    void (*fill_bits)(void*, std::uint64_t*, std::size_t);
+    void (*fill_uniform)(void*, double*, std::size_t);
+  };
+
+  template <typename G>
+  static std::uint64_t Bits(G& g) {
+    if constexpr (G::max() == std::numeric_limits<std::uint64_t>::max()) {
+      return static_cast<std::uint64_t>(g());
+    } else {
+      const std::uint64_t hi = static_cast<std::uint32_t>(g());
+      const std::uint64_t lo = static_cast<std::uint32_t>(g());
+      return (hi << 32) | lo;
+    }
+  }
+
+  template <typename G>
+  static double Uniform(G& g) {
+    if constexpr (G::max() == std::numeric_limits<std::uint64_t>::max()) {
+      return (static_cast<double>(static_cast<std::uint64_t>(g()) >> 11) + 0.5) * 0x1.0p-53;
+    } else {
+      return (static_cast<double>(static_cast<std::uint32_t>(g())) + 0.5) * 0x1.0p-32;
+    }
+  }
+
+  template <typename G>
+  static constexpr Ops kOps = {
+      [](void* e) { return Bits(*static_cast<G*>(e)); },
+      [](void* e) { return Uniform(*static_cast<G*>(e)); },
+      [](void* e, std::uint64_t* out, std::size_t n) {
+        G& g = *static_cast<G*>(e);
+        for (std::size_t i = 0; i < n; ++i) {
+          out[i] = Bits(g);
+        }
+      },
+      [](void* e, double* out, std::size_t n) {
+        G& g = *static_cast<G*>(e);
+        for (std::size_t i = 0; i < n; ++i) {
+          out[i] = Uniform(g);
+        }
+      },
+  };
+
+  void* engine_;
+  const Ops* ops_;
+};
+
+} // namespace ptm
+
+#endif // PTM_RNGREF_HPP_
@@ -0,0 +1,26 @@
+#ifndef PTM_SPLITMIX64_HPP_
+#define PTM_SPLITMIX64_HPP_
+
+#include <cstdint>
+
+namespace ptm {
+
+// SplitMix64 (Steele, Lea, Flood) - для раскладки 64-битного seed в состояние других генераторов
+class SplitMix64 {
+public:
+  explicit SplitMix64(std::uint64_t seed) : state_(seed) {}
+
+  std::uint64_t Next() {
+    std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+private:
+  std::uint64_t state_;
+};
+
+} // namespace ptm
+
+#endif // PTM_SPLITMIX64_HPP_
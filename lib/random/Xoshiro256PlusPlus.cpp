@@ -0,0 +1,52 @@
+#include "Xoshiro256PlusPlus.hpp"
+
+#include "SplitMix64.hpp"
+
+namespace ptm {
+
+Xoshiro256PlusPlus::Xoshiro256PlusPlus(std::uint64_t seed) : s_() {
+    SplitMix64 sm(seed);
+    for (auto& word : s_) {
+        word = sm.Next();
+    }
+}
+
+Xoshiro256PlusPlus::Xoshiro256PlusPlus(const std::array<std::uint64_t, 4>& state) : s_(state) {
+}
+
+void Xoshiro256PlusPlus::ApplyJump(const std::array<std::uint64_t, 4>& polynomial) {
+    std::array<std::uint64_t, 4> acc = {0, 0, 0, 0};
+
+    for (std::uint64_t word : polynomial) {
+        for (int b = 0; b < 64; ++b) {
+            if ((word & (1ULL << b)) != 0) {
+                for (std::size_t i = 0; i < acc.size(); ++i) {
+                    acc[i] ^= s_[i];
+                }
+            }
+            (*this)();
+        }
+    }
+
+    s_ = acc;
+}
+
+void Xoshiro256PlusPlus::Jump() {
+    ApplyJump({0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL});
+}
+
+void Xoshiro256PlusPlus::LongJump() {
+    ApplyJump({0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL});
+}
+
+Xoshiro256PlusPlus Xoshiro256PlusPlus::Split() {
+    Xoshiro256PlusPlus current = *this;
+    Jump();
+    return current;
+}
+
+const std::array<std::uint64_t, 4>& Xoshiro256PlusPlus::GetState() const noexcept {
+    return s_;
+}
+
+} // namespace ptm
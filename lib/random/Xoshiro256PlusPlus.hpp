@@ -0,0 +1,62 @@
+#ifndef PTM_XOSHIRO256PLUSPLUS_HPP_
+#define PTM_XOSHIRO256PLUSPLUS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace ptm {
+
+// xoshiro256++ (Blackman, Vigna): 32 байта состояния, период 2^256 - 1.
+// Jump сдвигает поток на 2^128 значений, LongJump - на 2^192
+class Xoshiro256PlusPlus {
+public:
+  using result_type = std::uint64_t;
+
+  explicit Xoshiro256PlusPlus(std::uint64_t seed = 0);
+  explicit Xoshiro256PlusPlus(const std::array<std::uint64_t, 4>& state);
+
+  static constexpr result_type min() { // NOLINT
+    return 0;
+  }
+
+  static constexpr result_type max() { // NOLINT
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    const std::uint64_t result = Rotl(s_[0] + s_[3], 23) + s_[0];
+    const std::uint64_t t = s_[1] << 17;
+
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl(s_[3], 45);
+
+    return result;
+  }
+
+  void Jump();
+  void LongJump();
+
+  // Вернуть генератор на текущем потоке, а самому перейти к следующему (через Jump).
+  // Последовательные вызовы дают непересекающиеся потоки длины 2^128 - по одному на поток исполнения
+  Xoshiro256PlusPlus Split();
+
+  [[nodiscard]] const std::array<std::uint64_t, 4>& GetState() const noexcept;
+
+private:
+  std::array<std::uint64_t, 4> s_;
+
+  static std::uint64_t Rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  void ApplyJump(const std::array<std::uint64_t, 4>& polynomial);
+};
+
+} // namespace ptm
+
+#endif // PTM_XOSHIRO256PLUSPLUS_HPP_
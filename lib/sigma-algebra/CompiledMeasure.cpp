@@ -0,0 +1,165 @@
+#include "CompiledMeasure.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#include "parallel/ParallelFor.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+#define PTM_MEASURE_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define PTM_MEASURE_CLONES
+#endif
+
+// Разбор слова обязан встроиться в каждый клон - иначе вызов внутри цикла мешает векторизации
+#if defined(__GNUC__)
+#define PTM_FORCE_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define PTM_FORCE_INLINE __forceinline
+#else
+#define PTM_FORCE_INLINE inline
+#endif
+
+namespace ptm {
+
+namespace {
+
+// Слов события на блок: блоки - единица параллельной работы и компенсированного сложения
+constexpr std::size_t kWordsPerBlock = 4096;
+// Событий на задачу пакетного вычисления
+constexpr std::size_t kEventsPerTask = 16;
+
+// Сумма Неймайера: компенсация копит потерянные при округлении младшие разряды
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void Add(double x) {
+        const double t = sum + x;
+        if (std::abs(sum) >= std::abs(x)) {
+            compensation += (sum - t) + x;
+        } else {
+            compensation += (x - t) + sum;
+        }
+        sum = t;
+    }
+
+    [[nodiscard]] double Value() const {
+        return sum + compensation;
+    }
+};
+
+// Σ p[b] по битам слова. Бит превращается в маску из нулей или единиц и накладывается на биты p[b],
+// затем 64 слагаемых складываются попарно, половина к половине. Оба шага - поэлементные циклы без
+// ветвлений, которые векторизуются без перестановки сложений
+PTM_FORCE_INLINE double MaskedWordSum(const double* p, std::uint64_t word) {
+    double terms[Event::kWordBits];
+    for (std::size_t b = 0; b < Event::kWordBits; ++b) {
+        const std::uint64_t mask = std::uint64_t{0} - ((word >> b) & 1);
+        terms[b] = std::bit_cast<double>(std::bit_cast<std::uint64_t>(p[b]) & mask);
+    }
+    for (std::size_t half = Event::kWordBits / 2; half != 0; half /= 2) {
+        for (std::size_t b = 0; b < half; ++b) {
+            terms[b] += terms[b + half];
+        }
+    }
+    return terms[0];
+}
+
+PTM_MEASURE_CLONES
+CompensatedSum MaskedDot(const double* probs, const double* word_sums, const std::uint64_t* words,
+                         std::size_t begin, std::size_t end) {
+    CompensatedSum acc;
+    for (std::size_t w = begin; w < end; ++w) {
+        const std::uint64_t word = words[w];
+        if (word == 0) {
+            continue;
+        }
+        acc.Add(word == ~std::uint64_t{0} ? word_sums[w] : MaskedWordSum(probs + w * Event::kWordBits, word));
+    }
+    return acc;
+}
+
+// Суммы блоков складываются по порядку блоков, каждая - сначала sum, затем compensation
+double CombineBlocks(std::span<const CompensatedSum> blocks) {
+    CompensatedSum total;
+    for (const CompensatedSum& block : blocks) {
+        total.Add(block.sum);
+        total.Add(block.compensation);
+    }
+    return total.Value();
+}
+
+} // namespace
+
+CompiledMeasure::CompiledMeasure(const ProbabilityMeasure& measure)
+    : CompiledMeasure(measure.AtomicProbabilities()) {}
+
+CompiledMeasure::CompiledMeasure(std::span<const double> atom_probs) : size_(atom_probs.size()) {
+    const std::size_t num_words = (size_ + Event::kWordBits - 1) / Event::kWordBits;
+    probs_.assign(num_words * Event::kWordBits, 0.0);
+    std::copy(atom_probs.begin(), atom_probs.end(), probs_.begin());
+
+    word_sums_.resize(num_words);
+    for (std::size_t w = 0; w < num_words; ++w) {
+        word_sums_[w] = MaskedWordSum(probs_.data() + w * Event::kWordBits, ~std::uint64_t{0});
+    }
+}
+
+std::size_t CompiledMeasure::GetSize() const noexcept {
+    return size_;
+}
+
+double CompiledMeasure::TotalMass() const noexcept {
+    const std::size_t num_words = word_sums_.size();
+    CompensatedSum total;
+    for (std::size_t w = 0; w < num_words; ++w) {
+        total.Add(word_sums_[w]);
+    }
+    return total.Value();
+}
+
+double CompiledMeasure::Probability(const Event& event, std::size_t num_threads) const {
+    const auto words = event.Words();
+    const std::size_t num_words = std::min(words.size(), word_sums_.size());
+    const std::size_t num_blocks = (num_words + kWordsPerBlock - 1) / kWordsPerBlock;
+
+    if (ResolveThreadCount(num_threads) == 1 || num_blocks <= 1) {
+        // Тот же порядок сложения, что у CombineBlocks, но без массива сумм блоков
+        CompensatedSum total;
+        for (std::size_t b = 0; b < num_blocks; ++b) {
+            const CompensatedSum block = MaskedDot(probs_.data(), word_sums_.data(), words.data(),
+                                                   b * kWordsPerBlock, std::min(num_words, (b + 1) * kWordsPerBlock));
+            total.Add(block.sum);
+            total.Add(block.compensation);
+        }
+        return total.Value();
+    }
+
+    std::vector<CompensatedSum> blocks(num_blocks);
+    ParallelFor(num_blocks, num_threads, [&](std::size_t b) {
+        blocks[b] = MaskedDot(probs_.data(), word_sums_.data(), words.data(), b * kWordsPerBlock,
+                              std::min(num_words, (b + 1) * kWordsPerBlock));
+    });
+    return CombineBlocks(blocks);
+}
+
+void CompiledMeasure::Probabilities(std::span<const Event> events, std::span<double> out,
+                                    std::size_t num_threads) const {
+    if (events.size() != out.size()) {
+        throw std::invalid_argument("events and out must have the same size");
+    }
+
+    const std::size_t num_tasks = (events.size() + kEventsPerTask - 1) / kEventsPerTask;
+    ParallelFor(num_tasks, num_threads, [&](std::size_t task) {
+        const std::size_t end = std::min(events.size(), (task + 1) * kEventsPerTask);
+        for (std::size_t k = task * kEventsPerTask; k < end; ++k) {
+            out[k] = Probability(events[k], 1);
+        }
+    });
+}
+
+} // namespace ptm
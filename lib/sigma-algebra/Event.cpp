@@ -1,54 +1,165 @@
 #include "Event.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
 namespace ptm {
 
-Event::Event(std::vector<bool> mask) : mask_(std::move(mask)) {
+Event::Event(std::size_t n) : size_(n) {
+    if (NumWords(n) > kInlineWords) {
+        heap_.assign(NumWords(n), 0);
+    }
+}
+
+Event::Event(Event&& other) noexcept
+    : size_(std::exchange(other.size_, 0)),
+      inline_(other.inline_),
+      heap_(std::move(other.heap_)) {
+    other.heap_.clear();
+}
+
+Event& Event::operator=(Event&& other) noexcept {
+    if (this != &other) {
+        size_ = std::exchange(other.size_, 0);
+        inline_ = other.inline_;
+        heap_ = std::move(other.heap_);
+        other.heap_.clear();
+    }
+    return *this;
+}
+
+Event::Event(std::vector<bool> mask) : Event(mask.size()) {
+    Word* words = Data();
+    for (std::size_t i = 0; i < mask.size(); ++i) {
+        words[i / kWordBits] |= static_cast<Word>(mask[i]) << (i % kWordBits);
+    }
+}
+
+std::size_t Event::NumWords(std::size_t n) noexcept {
+    return (n + kWordBits - 1) / kWordBits;
+}
+
+Event::Word* Event::Data() noexcept {
+    return size_ <= kInlineWords * kWordBits ? inline_.data() : heap_.data();
+}
+
+const Event::Word* Event::Data() const noexcept {
+    return size_ <= kInlineWords * kWordBits ? inline_.data() : heap_.data();
+}
+
+void Event::ClearTail() noexcept {
+    if (size_ % kWordBits != 0) {
+        Data()[size_ / kWordBits] &= (Word{1} << (size_ % kWordBits)) - 1;
+    }
 }
 
 size_t Event::GetSize() const noexcept {
-    return mask_.size();
+    return size_;
 }
 
 bool Event::Contains(OutcomeSpace::OutcomeId id) const {
-    return id < mask_.size() && mask_[id];
+    return id < size_ && ((Data()[id / kWordBits] >> (id % kWordBits)) & 1) != 0;
+}
+
+void Event::Insert(OutcomeSpace::OutcomeId id) {
+    if (id >= size_) {
+        throw std::out_of_range("Outcome ID is outside the event");
+    }
+    Data()[id / kWordBits] |= Word{1} << (id % kWordBits);
+}
+
+void Event::Erase(OutcomeSpace::OutcomeId id) {
+    if (id >= size_) {
+        throw std::out_of_range("Outcome ID is outside the event");
+    }
+    Data()[id / kWordBits] &= ~(Word{1} << (id % kWordBits));
+}
+
+std::size_t Event::Count() const noexcept {
+    std::size_t count = 0;
+    for (Word w : Words()) {
+        count += static_cast<std::size_t>(std::popcount(w));
+    }
+    return count;
+}
+
+bool Event::IsEmpty() const noexcept {
+    const std::span<const Word> words = Words();
+    return std::all_of(words.begin(), words.end(), [](Word w) { return w == 0; });
+}
+
+std::vector<bool> Event::GetMask() const {
+    std::vector<bool> mask(size_, false);
+    ForEachSetBit([&](OutcomeSpace::OutcomeId id) { mask[id] = true; });
+    return mask;
+}
+
+std::span<const Event::Word> Event::Words() const noexcept {
+    return {Data(), NumWords(size_)};
+}
+
+std::uint64_t Event::Hash() const noexcept {
+    // Шаги перемешивания SplitMix64 по каждому слову, затем его финализатор
+    std::uint64_t h = static_cast<std::uint64_t>(size_) * 0x9e3779b97f4a7c15ULL;
+    for (Word w : Words()) {
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
 }
 
-const std::vector<bool>& Event::GetMask() const noexcept {
-    return mask_;
+bool operator==(const Event& a, const Event& b) noexcept {
+    const std::span<const Event::Word> wa = a.Words();
+    const std::span<const Event::Word> wb = b.Words();
+    return a.size_ == b.size_ && std::equal(wa.begin(), wa.end(), wb.begin());
 }
 
 Event Event::Empty(std::size_t n) {
-    return Event(std::vector<bool>(n, false));
+    return Event(n);
 }
 
 Event Event::Full(std::size_t n) {
-    return Event(std::vector<bool>(n, true));
+    Event res(n);
+    std::fill_n(res.Data(), NumWords(n), ~Word{0});
+    res.ClearTail();
+    return res;
 }
 
 Event Event::Complement(const Event& e) {
-    std::vector<bool> res(e.mask_.size());
-    for (std::size_t i = 0; i < e.mask_.size(); ++i) {
-        res[i] = !e.mask_[i];
+    Event res(e.size_);
+    const Word* in = e.Data();
+    Word* out = res.Data();
+    for (std::size_t w = 0; w < NumWords(e.size_); ++w) {
+        out[w] = ~in[w];
     }
-    return Event(std::move(res));
+    res.ClearTail();
+    return res;
 }
 
 Event Event::Unite(const Event& a, const Event& b) {
-    std::size_t n = std::min(a.mask_.size(), b.mask_.size());
-    std::vector<bool> res(n, false);
-    for (std::size_t i = 0; i < n; ++i) {
-        res[i] = a.mask_[i] || b.mask_[i];
+    Event res(std::min(a.size_, b.size_));
+    const Word* wa = a.Data();
+    const Word* wb = b.Data();
+    Word* out = res.Data();
+    for (std::size_t w = 0; w < NumWords(res.size_); ++w) {
+        out[w] = wa[w] | wb[w];
     }
-    return Event(std::move(res));
+    res.ClearTail();
+    return res;
 }
 
 Event Event::Intersect(const Event& a, const Event& b) {
-    std::size_t n = std::min(a.mask_.size(), b.mask_.size());
-    std::vector<bool> res(n, false);
-    for (std::size_t i = 0; i < n; ++i) {
-        res[i] = a.mask_[i] && b.mask_[i];
+    Event res(std::min(a.size_, b.size_));
+    const Word* wa = a.Data();
+    const Word* wb = b.Data();
+    Word* out = res.Data();
+    for (std::size_t w = 0; w < NumWords(res.size_); ++w) {
+        out[w] = wa[w] & wb[w];
     }
-    return Event(std::move(res));
+    return res;
 }
 
 } // namespace ptm
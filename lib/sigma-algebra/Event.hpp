@@ -1,30 +1,87 @@
 #ifndef PTM_EVENT_HPP_
 #define PTM_EVENT_HPP_
 
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 #include "OutcomeSpace.hpp"
 
 namespace ptm {
 
+// Событие - подмножество Ω в виде битового множества по 64-битным словам: бит i слова i / 64
+// отвечает исходу i. Для |Ω| <= 256 слова лежат внутри объекта, иначе - в куче. Операции алгебры
+// событий идут по словам (циклы без ветвлений, компилятор векторизует их сам); биты последнего
+// слова за пределами GetSize() всегда нулевые, поэтому слова можно сравнивать и считать целиком
 class Event {
 public:
+  using Word = std::uint64_t;
+  static constexpr std::size_t kWordBits = 64;
+  static constexpr std::size_t kInlineWords = 4;
+
   Event() = default;
+  Event(const Event&) = default;
+  Event& operator=(const Event&) = default;
+  // Перемещённое событие становится пустым над пустым Ω: иначе size_ > 256 указывал бы на пустую кучу
+  Event(Event&& other) noexcept;
+  Event& operator=(Event&& other) noexcept;
+  // Пустое событие над Ω из n исходов
+  explicit Event(std::size_t n);
   explicit Event(std::vector<bool> mask);
 
   [[nodiscard]] size_t GetSize() const noexcept;
   [[nodiscard]] bool Contains(OutcomeSpace::OutcomeId id) const;
 
-  [[nodiscard]] const std::vector<bool>& GetMask() const noexcept;
+  // Добавить / убрать исход; std::out_of_range, если id >= GetSize()
+  void Insert(OutcomeSpace::OutcomeId id);
+  void Erase(OutcomeSpace::OutcomeId id);
+
+  // Число исходов в событии
+  [[nodiscard]] std::size_t Count() const noexcept;
+  [[nodiscard]] bool IsEmpty() const noexcept;
+
+  // Маска по исходам; собирается из слов при каждом вызове
+  [[nodiscard]] std::vector<bool> GetMask() const;
+  // Слова битового множества, ceil(GetSize() / 64) штук
+  [[nodiscard]] std::span<const Word> Words() const noexcept;
+
+  // fn(id) для каждого исхода события по возрастанию id
+  template <typename F>
+  void ForEachSetBit(F&& fn) const {
+    const std::span<const Word> words = Words();
+    for (std::size_t w = 0; w < words.size(); ++w) {
+      for (Word bits = words[w]; bits != 0; bits &= bits - 1) {
+        fn(static_cast<OutcomeSpace::OutcomeId>(w * kWordBits + std::countr_zero(bits)));
+      }
+    }
+  }
+
+  // Хеш размера и слов: равные события дают равный хеш
+  [[nodiscard]] std::uint64_t Hash() const noexcept;
+
+  // Равны, если совпадают размер Ω и множество исходов
+  friend bool operator==(const Event& a, const Event& b) noexcept;
 
   static Event Empty(std::size_t n);
   static Event Full(std::size_t n);
   static Event Complement(const Event& e);
+  // Для событий разного размера результат - над меньшим из Ω
   static Event Unite(const Event& a, const Event& b);
   static Event Intersect(const Event& a, const Event& b);
 
 private:
-  std::vector<bool> mask_;
+  std::size_t size_ = 0;
+  std::array<Word, kInlineWords> inline_{};
+  std::vector<Word> heap_;
+
+  [[nodiscard]] static std::size_t NumWords(std::size_t n) noexcept;
+  [[nodiscard]] Word* Data() noexcept;
+  [[nodiscard]] const Word* Data() const noexcept;
+  // Обнулить биты последнего слова за пределами size_
+  void ClearTail() noexcept;
 };
 
 } // namespace ptm
@@ -0,0 +1,50 @@
+#include "EventSet.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace ptm {
+
+EventSet::EventSet(std::span<const Event> events) : events_(events) {
+    slots_.resize(std::bit_ceil(std::max<std::size_t>(2 * events.size(), 16)));
+    const std::size_t mask = slots_.size() - 1;
+
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const std::uint64_t hash = events[i].Hash();
+        for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            Slot& slot = slots_[pos];
+            if (slot.index == kEmptySlot) {
+                slot = {hash, i};
+                ++size_;
+                break;
+            }
+            if (slot.hash == hash && events_[slot.index] == events[i]) {
+                break;
+            }
+        }
+    }
+}
+
+std::optional<std::size_t> EventSet::Find(const Event& e) const noexcept {
+    const std::uint64_t hash = e.Hash();
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        const Slot& slot = slots_[pos];
+        if (slot.index == kEmptySlot) {
+            return std::nullopt;
+        }
+        if (slot.hash == hash && events_[slot.index] == e) {
+            return slot.index;
+        }
+    }
+}
+
+bool EventSet::Contains(const Event& e) const noexcept {
+    return Find(e).has_value();
+}
+
+std::size_t EventSet::Size() const noexcept {
+    return size_;
+}
+
+} // namespace ptm
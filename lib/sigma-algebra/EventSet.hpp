@@ -0,0 +1,43 @@
+#ifndef PTM_EVENTSET_HPP_
+#define PTM_EVENTSET_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Event.hpp"
+
+namespace ptm {
+
+// Множество событий для поиска за O(n / 64) в среднем: открытая адресация с линейным
+// пробированием, слот - хеш события и его индекс в массиве events. Сами события не копируются,
+// поэтому массив должен жить не меньше EventSet. Заполнение таблицы не больше 1/2
+class EventSet {
+public:
+  explicit EventSet(std::span<const Event> events);
+
+  // Индекс первого события массива, равного e
+  [[nodiscard]] std::optional<std::size_t> Find(const Event& e) const noexcept;
+  [[nodiscard]] bool Contains(const Event& e) const noexcept;
+
+  // Число различных событий
+  [[nodiscard]] std::size_t Size() const noexcept;
+
+private:
+  static constexpr std::size_t kEmptySlot = ~std::size_t{0};
+
+  struct Slot {
+    std::uint64_t hash = 0;
+    std::size_t index = kEmptySlot;
+  };
+
+  std::span<const Event> events_;
+  std::vector<Slot> slots_;
+  std::size_t size_ = 0;
+};
+
+} // namespace ptm
+
+#endif // PTM_EVENTSET_HPP_
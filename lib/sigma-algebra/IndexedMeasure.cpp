@@ -0,0 +1,121 @@
+#include "IndexedMeasure.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace ptm {
+
+IndexedMeasure::IndexedMeasure(const OutcomeSpace& omega)
+    : size_(omega.GetSize()),
+      leaves_(std::bit_ceil(std::max<std::size_t>(size_, 1))),
+      tree_(2 * leaves_, 0.0) {}
+
+IndexedMeasure::IndexedMeasure(const ProbabilityMeasure& measure) : size_(measure.AtomicProbabilities().size()) {
+    leaves_ = std::bit_ceil(std::max<std::size_t>(size_, 1));
+    tree_.assign(2 * leaves_, 0.0);
+    const auto probs = measure.AtomicProbabilities();
+    for (std::size_t i = 0; i < size_; ++i) {
+        if (!(probs[i] >= 0.0)) {
+            throw std::invalid_argument("Atomic probability must be non-negative");
+        }
+        tree_[leaves_ + i] = probs[i];
+    }
+    Build();
+}
+
+void IndexedMeasure::Build() {
+    for (std::size_t node = leaves_ - 1; node >= 1; --node) {
+        tree_[node] = tree_[2 * node] + tree_[2 * node + 1];
+    }
+}
+
+void IndexedMeasure::SetAtomicProbability(OutcomeSpace::OutcomeId id, double p) {
+    if (id >= size_) {
+        throw std::out_of_range("Outcome ID is outside Omega");
+    }
+    if (!(p >= 0.0)) {
+        throw std::invalid_argument("Atomic probability must be non-negative");
+    }
+    std::size_t node = leaves_ + id;
+    tree_[node] = p;
+    for (node /= 2; node >= 1; node /= 2) {
+        tree_[node] = tree_[2 * node] + tree_[2 * node + 1];
+    }
+}
+
+double IndexedMeasure::GetAtomicProbability(OutcomeSpace::OutcomeId id) const {
+    if (id >= size_) {
+        return 0.0;
+    }
+    return tree_[leaves_ + id];
+}
+
+std::size_t IndexedMeasure::GetSize() const noexcept {
+    return size_;
+}
+
+double IndexedMeasure::TotalMass() const noexcept {
+    return tree_[1];
+}
+
+bool IndexedMeasure::IsValid(double eps) const noexcept {
+    return std::fabs(TotalMass() - 1.0) <= eps;
+}
+
+double IndexedMeasure::RangeProbability(OutcomeSpace::OutcomeId first, OutcomeSpace::OutcomeId last) const noexcept {
+    last = std::min(last, size_);
+    if (first >= last) {
+        return 0.0;
+    }
+
+    // Снизу вверх: на каждом уровне крайний узел, не целиком покрытый родителем, берётся сам
+    double left = 0.0;
+    double right = 0.0;
+    for (std::size_t lo = first + leaves_, hi = last + leaves_; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) {
+            left += tree_[lo++];
+        }
+        if (hi & 1) {
+            right = tree_[--hi] + right;
+        }
+    }
+    return left + right;
+}
+
+double IndexedMeasure::Probability(const Event& event) const {
+    double result = 0.0;
+    event.ForEachSetBit([&](OutcomeSpace::OutcomeId id) {
+        if (id < size_) {
+            result += tree_[leaves_ + id];
+        }
+    });
+    return result;
+}
+
+std::optional<OutcomeSpace::OutcomeId> IndexedMeasure::FindByCumulative(double u) const noexcept {
+    if (!(TotalMass() > 0.0)) {
+        return std::nullopt;
+    }
+
+    // В поддерево без массы спуск не заходит: налево - если там есть масса и u попадает в неё
+    // или справа пусто, иначе направо с вычетом левой массы
+    std::size_t node = 1;
+    while (node < leaves_) {
+        const double left = tree_[2 * node];
+        if (left > 0.0 && (u < left || !(tree_[2 * node + 1] > 0.0))) {
+            node = 2 * node;
+        } else {
+            u -= left;
+            node = 2 * node + 1;
+        }
+    }
+    return node - leaves_;
+}
+
+std::optional<OutcomeSpace::OutcomeId> IndexedMeasure::Sample(RngRef rng) const {
+    return FindByCumulative(rng.NextUniform() * TotalMass());
+}
+
+} // namespace ptm
@@ -0,0 +1,56 @@
+#ifndef PTM_INDEXEDMEASURE_HPP_
+#define PTM_INDEXEDMEASURE_HPP_
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "Event.hpp"
+#include "OutcomeSpace.hpp"
+#include "ProbabilityMeasure.hpp"
+#include "random/RngRef.hpp"
+
+namespace ptm {
+
+// Мера для часто меняющихся вероятностей атомов: дерево отрезков над p_i. Листья - p_i, внутренний
+// узел - сумма двух детей; при изменении p_i узлы пути к корню пересчитываются из детей заново, а не
+// сдвигаются на разность, поэтому ошибки округления не копятся от обновления к обновлению.
+// Изменение и P([first, last)) - O(log n), полная масса - корень, O(1), выбор исхода спуском от
+// корня по массе поддеревьев (обращение функции распределения) - O(log n)
+class IndexedMeasure {
+public:
+  // Нулевая мера над n исходами Ω
+  explicit IndexedMeasure(const OutcomeSpace& omega);
+  // Копия вероятностей measure, построение за O(n)
+  explicit IndexedMeasure(const ProbabilityMeasure& measure);
+
+  // Задать P({ω_i}) = p_i; std::out_of_range для id вне Ω, std::invalid_argument для p < 0 или NaN
+  void SetAtomicProbability(OutcomeSpace::OutcomeId id, double p);
+  [[nodiscard]] double GetAtomicProbability(OutcomeSpace::OutcomeId id) const;
+
+  [[nodiscard]] std::size_t GetSize() const noexcept;
+  [[nodiscard]] double TotalMass() const noexcept;
+  // |Σ p_i - 1| <= eps за O(1)
+  [[nodiscard]] bool IsValid(double eps) const noexcept;
+
+  // P({ω_first, ..., ω_(last-1)}); границы обрезаются по Ω
+  [[nodiscard]] double RangeProbability(OutcomeSpace::OutcomeId first, OutcomeSpace::OutcomeId last) const noexcept;
+  [[nodiscard]] double Probability(const Event& event) const;
+
+  // Исход i с Σ_{j<i} p_j <= u < Σ_{j<=i} p_j, всегда с p_i > 0; u за пределами [0, TotalMass())
+  // прижимается к первому или последнему такому исходу. std::nullopt, если масса нулевая
+  [[nodiscard]] std::optional<OutcomeSpace::OutcomeId> FindByCumulative(double u) const noexcept;
+  // Исход с вероятностью p_i / TotalMass()
+  std::optional<OutcomeSpace::OutcomeId> Sample(RngRef rng) const;
+
+private:
+  std::size_t size_ = 0;
+  std::size_t leaves_ = 1;    // степень двойки >= size_
+  std::vector<double> tree_;  // tree_[1] - корень, листья - tree_[leaves_ + i]
+
+  void Build();
+};
+
+} // namespace ptm
+
+#endif // PTM_INDEXEDMEASURE_HPP_
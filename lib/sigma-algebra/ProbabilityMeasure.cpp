@@ -1,5 +1,7 @@
 #include "ProbabilityMeasure.hpp"
 
+#include <algorithm>
+
 namespace ptm {
 
 ProbabilityMeasure::ProbabilityMeasure(const OutcomeSpace& omega) : omega_(omega), atom_probs_(omega.GetSize(), 0.0) {
@@ -19,6 +21,10 @@ void ProbabilityMeasure::SetAtomicProbability(OutcomeSpace::OutcomeId id, double
     atom_probs_[id] = p;
 }
 
+std::span<const double> ProbabilityMeasure::AtomicProbabilities() const noexcept {
+    return atom_probs_;
+}
+
 bool ProbabilityMeasure::IsValid(double eps) const {
     if (atom_probs_.size() != omega_.GetSize()) {
         return false;
@@ -31,13 +37,14 @@ bool ProbabilityMeasure::IsValid(double eps) const {
 }
 
 double ProbabilityMeasure::Probability(const Event& event) const {
-    const std::size_t n = std::min(event.GetSize(), omega_.GetSize());
+    // Только исходы события, по возрастанию id; исходы вне меры вклада не дают
+    const std::size_t n = std::min(event.GetSize(), atom_probs_.size());
     double result = 0.0;
-    for (std::size_t i = 0; i < n; ++i) {
-        if (event.Contains(i)) {
-            result += GetAtomicProbability(i);
+    event.ForEachSetBit([&](OutcomeSpace::OutcomeId id) {
+        if (id < n) {
+            result += atom_probs_[id];
         }
-    }
+    });
     return result;
 }
 
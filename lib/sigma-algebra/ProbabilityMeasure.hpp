@@ -1,6 +1,7 @@
 #ifndef PTM_PROBABILITYMEASURE_HPP_
 #define PTM_PROBABILITYMEASURE_HPP_
 
+#include <span>
 #include <vector>
 #include <stdexcept>
 #include <cmath>
@@ -18,6 +19,9 @@ public:
   void SetAtomicProbability(OutcomeSpace::OutcomeId id, double p);
   [[nodiscard]] double GetAtomicProbability(OutcomeSpace::OutcomeId id) const;
 
+  // p_i всех исходов, по id
+  [[nodiscard]] std::span<const double> AtomicProbabilities() const noexcept;
+
   [[nodiscard]] bool IsValid(double eps) const;
 
   [[nodiscard]] double Probability(const Event& event) const;
@@ -1,138 +1,355 @@
 #include "SigmaAlgebra.hpp"
 
-namespace ptm {
-
-SigmaAlgebra::SigmaAlgebra(const OutcomeSpace& omega, std::vector<Event> events)
-    : omega_(omega),
-      events_(std::move(events)) {}
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <utility>
 
-const OutcomeSpace& SigmaAlgebra::GetOutcomeSpace() const noexcept {
-    return omega_;
-}
+#include "EventSet.hpp"
+#include "parallel/ParallelFor.hpp"
 
-const std::vector<Event>& SigmaAlgebra::GetEvents() const noexcept {
-  return events_;
-}
+namespace ptm {
 
-bool EventsEqual(const Event& a, const Event& b) {
-  return a.GetMask() == b.GetMask();
-}
+namespace {
 
-bool ContainsEvent(const std::vector<Event>& events, const Event& target) {
-  return std::any_of(events.begin(), events.end(), [&](const Event& e) { return EventsEqual(e, target); });
-}
+constexpr std::uint32_t kNoAtom = ~std::uint32_t{0};
 
-std::vector<Event> DeduplicateEvents(const std::vector<Event>& events) {
-  std::vector<Event> out;
-  out.reserve(events.size());
-  for (const auto& e : events) {
-    if (!ContainsEvent(out, e)) {
-      out.push_back(e);
+// Транспонирование битовой матрицы 64x64: бит c слова r меняется местами с битом r слова c.
+// Обмен блоков 32x32, затем 16x16 и т. д. - 6 проходов по 64 словам вместо 4096 операций с битами
+void Transpose64(std::array<std::uint64_t, 64>& rows) {
+  std::uint64_t mask = 0x00000000FFFFFFFFULL;
+  for (std::size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (std::size_t k = 0; k < 64; k = (k + j + 1) & ~j) {
+      const std::uint64_t t = ((rows[k] >> j) ^ rows[k + j]) & mask;
+      rows[k] ^= t << j;
+      rows[k + j] ^= t;
     }
   }
-  return out;
 }
 
-bool SigmaAlgebra::IsSigmaAlgebra() const {
-  const std::size_t n = omega_.GetSize();
+// Новый номер атома для пары (старый атом, столбец): открытая адресация, заполнение не больше 1/2.
+// Номера выдаются подряд в порядке первого запроса
+class AtomRemap {
+public:
+  void Reset() {
+    slots_.assign(kInitialSlots, Slot{});
+    size_ = 0;
+  }
 
-  for (const auto& e : events_) {
-    if (e.GetSize() != n) {
-      return false;
+  std::uint32_t Get(std::uint32_t atom, std::uint64_t column) {
+    const std::uint64_t hash = Hash(atom, column);
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+      Slot& slot = slots_[pos];
+      if (slot.id == kNoAtom) {
+        slot = {column, atom, static_cast<std::uint32_t>(size_++)};
+        const std::uint32_t id = slot.id;
+        if (2 * size_ > slots_.size()) {
+          Grow();
+        }
+        return id;
+      }
+      if (slot.atom == atom && slot.column == column) {
+        return slot.id;
+      }
     }
   }
 
-  const Event empty = Event::Empty(n);
-  const Event full = Event::Full(n);
+  [[nodiscard]] std::size_t Size() const noexcept {
+    return size_;
+  }
+
+private:
+  static constexpr std::size_t kInitialSlots = 1024;
 
-  if (!ContainsEvent(events_, empty)) return false;
-  if (!ContainsEvent(events_, full)) return false;
+  struct Slot {
+    std::uint64_t column = 0;
+    std::uint32_t atom = 0;
+    std::uint32_t id = kNoAtom;
+  };
 
-  for (const auto& e: events_) {
-    const Event comp = Event::Complement(e);
-    if (!ContainsEvent(events_, comp)) {
-      return false;
+  // Финализатор SplitMix64
+  static std::uint64_t Hash(std::uint32_t atom, std::uint64_t column) noexcept {
+    std::uint64_t z = column ^ (static_cast<std::uint64_t>(atom) * 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  void Grow() {
+    std::vector<Slot> old(2 * slots_.size());
+    old.swap(slots_);
+    const std::size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+      if (slot.id == kNoAtom) {
+        continue;
+      }
+      std::size_t pos = Hash(slot.atom, slot.column) & mask;
+      while (slots_[pos].id != kNoAtom) {
+        pos = (pos + 1) & mask;
+      }
+      slots_[pos] = slot;
     }
   }
 
-  for (std::size_t i = 0; i < events_.size(); ++i) {
-    for (std::size_t j = 0; j < events_.size(); ++j) {
-      const Event u = Event::Unite(events_[i], events_[j]);
-      if (!ContainsEvent(events_, u)) {
-        return false;
+  std::vector<Slot> slots_;
+  std::size_t size_ = 0;
+};
+
+} // namespace
+
+AtomPartition ComputeAtoms(std::size_t n, std::span<const Event> generators) {
+  AtomPartition result;
+  result.atom_of.assign(n, 0);
+  result.num_atoms = n > 0 ? 1 : 0;
+
+  const std::size_t num_words = (n + Event::kWordBits - 1) / Event::kWordBits;
+  std::array<std::uint64_t, 64> columns{};
+  AtomRemap remap;
+
+  // Разбиение на одноэлементные атомы дальше не измельчается
+  for (std::size_t block = 0; block < generators.size() && result.num_atoms < n; block += 64) {
+    const std::size_t block_size = std::min<std::size_t>(64, generators.size() - block);
+    remap.Reset();
+    std::uint32_t last_atom = kNoAtom;
+    std::uint64_t last_column = 0;
+    std::uint32_t last_id = kNoAtom;
+
+    for (std::size_t w = 0; w < num_words; ++w) {
+      // Слово w каждого генератора блока; после транспонирования columns[r] - столбец исхода 64w + r
+      columns.fill(0);
+      for (std::size_t g = 0; g < block_size; ++g) {
+        const auto words = generators[block + g].Words();
+        columns[g] = w < words.size() ? words[w] : 0;
+      }
+      Transpose64(columns);
+
+      const std::size_t end = std::min(n, (w + 1) * Event::kWordBits);
+      for (std::size_t i = w * Event::kWordBits; i < end; ++i) {
+        const std::uint32_t atom = result.atom_of[i];
+        const std::uint64_t column = columns[i % Event::kWordBits];
+        // Соседние исходы часто в одном атоме - повтор ключа обходится без хеш-таблицы
+        if (atom != last_atom || column != last_column) {
+          last_atom = atom;
+          last_column = column;
+          last_id = remap.Get(atom, column);
+        }
+        result.atom_of[i] = last_id;
       }
     }
+    result.num_atoms = remap.Size();
   }
+  return result;
+}
 
-  return true;
+SigmaAlgebra::SigmaAlgebra(const OutcomeSpace& omega, std::vector<Event> events)
+    : omega_(omega),
+      events_(std::move(events)) {
+  AtomPartition atoms = ComputeAtoms(omega.GetSize(), events_);
+  atom_of_ = std::move(atoms.atom_of);
+  BuildMembers(atoms.num_atoms);
 }
 
-std::string SignatureForOutcome(OutcomeSpace::OutcomeId id, const std::vector<Event>& generators) {
-  std::string sig;
-  sig.reserve(generators.size());
-  for (const auto& g : generators) {
-    sig.push_back(g.Contains(id) ? '1' : '0');
+SigmaAlgebra::SigmaAlgebra(const OutcomeSpace& omega, std::vector<std::uint32_t> atom_of, std::size_t num_atoms)
+    : omega_(omega),
+      explicit_(false),
+      atom_of_(std::move(atom_of)) {
+  BuildMembers(num_atoms);
+}
+
+void SigmaAlgebra::BuildMembers(std::size_t num_atoms) {
+  atom_offsets_.assign(num_atoms + 1, 0);
+  for (std::uint32_t atom : atom_of_) {
+    ++atom_offsets_[atom + 1];
+  }
+  for (std::size_t k = 0; k < num_atoms; ++k) {
+    atom_offsets_[k + 1] += atom_offsets_[k];
+  }
+  atom_members_.resize(atom_of_.size());
+  std::vector<std::size_t> cursor(atom_offsets_.begin(), atom_offsets_.end() - 1);
+  for (std::size_t i = 0; i < atom_of_.size(); ++i) {
+    atom_members_[cursor[atom_of_[i]]++] = static_cast<std::uint32_t>(i);
   }
-  return sig;
 }
 
-SigmaAlgebra SigmaAlgebra::Generate(const OutcomeSpace& omega, const std::vector<Event>& generators) {
-  const std::size_t n = omega.GetSize();
+const OutcomeSpace& SigmaAlgebra::GetOutcomeSpace() const noexcept {
+    return omega_;
+}
 
-  if (generators.empty()) {
-    return SigmaAlgebra(omega, {Event::Empty(n), Event::Full(n)});
+std::vector<Event> SigmaAlgebra::GetEvents() const {
+  if (explicit_) {
+    return events_;
+  }
+  if (NumAtoms() >= 63) {
+    throw std::runtime_error("Too many atoms to enumerate sigma-algebra");
   }
 
-  std::unordered_map<std::string, std::vector<bool>> atoms_map;
-  atoms_map.reserve(n * 2);
+  std::vector<Event> events;
+  events.reserve(std::size_t{1} << NumAtoms());
+  EventEnumerator it(*this);
+  do {
+    events.push_back(it.Current());
+  } while (it.Next());
+  return events;
+}
 
-  for (std::size_t outcome = 0; outcome < n; ++outcome) {
-    const std::string sig = SignatureForOutcome(outcome, generators);
+bool SigmaAlgebra::IsSigmaAlgebra(std::size_t num_threads) const {
+  return !FindViolation(num_threads).has_value();
+}
 
-    auto it = atoms_map.find(sig);
-    if (it == atoms_map.end()) {
-      std::vector<bool> mask(n, false);
-      mask[outcome] = true;
-      atoms_map.emplace(sig, std::move(mask));
-    } else {
-      it->second[outcome] = true;
+std::optional<SigmaAlgebraViolation> SigmaAlgebra::FindViolation(std::size_t num_threads) const {
+  using Kind = SigmaAlgebraViolation::Kind;
+  const std::size_t n = omega_.GetSize();
+  if (!explicit_) {
+    if (atom_of_.size() != n) {
+      return SigmaAlgebraViolation{Kind::WrongSize};
     }
+    return std::nullopt;
   }
 
-  std::vector<Event> atoms;
-  atoms.reserve(atoms_map.size());
-  for (auto& kv : atoms_map) {
-    atoms.emplace_back(std::move(kv.second));
+  for (std::size_t i = 0; i < events_.size(); ++i) {
+    if (events_[i].GetSize() != n) {
+      return SigmaAlgebraViolation{Kind::WrongSize, i};
+    }
   }
 
-  const std::size_t m = atoms.size();
-
-  if (m >= 63) {
-    throw std::runtime_error("Too many atoms to generate full sigma-algebra");
+  const EventSet set(events_);
+  // Все события семейства лежат в σ(events), а в ней ровно 2^m событий
+  if (NumAtoms() < 64 && set.Size() == (std::uint64_t{1} << NumAtoms())) {
+    return std::nullopt;
   }
 
-  const std::uint64_t total = (m == 64) ? 0 : (1ULL << m);
+  if (!set.Contains(Event::Empty(n))) return SigmaAlgebraViolation{Kind::MissingEmpty};
+  if (!set.Contains(Event::Full(n))) return SigmaAlgebraViolation{Kind::MissingFull};
 
-  std::vector<Event> events;
-  events.reserve(static_cast<std::size_t>(total));
+  // Дальше - только первые вхождения различных событий
+  std::vector<std::size_t> distinct;
+  distinct.reserve(set.Size());
+  for (std::size_t i = 0; i < events_.size(); ++i) {
+    if (*set.Find(events_[i]) == i) {
+      distinct.push_back(i);
+    }
+  }
 
-  for (std::uint64_t mask_atoms = 0; mask_atoms < total; ++mask_atoms) {
-    std::vector<bool> mask_event(n, false);
+  for (std::size_t i : distinct) {
+    if (!set.Contains(Event::Complement(events_[i]))) {
+      return SigmaAlgebraViolation{Kind::MissingComplement, i};
+    }
+  }
 
-    for (std::size_t i = 0; i < m; ++i) {
-      if (mask_atoms & (1ULL << i)) {
-        const auto& am = atoms[i].GetMask();
-        for (std::size_t j = 0; j < n; ++j) {
-          mask_event[j] = mask_event[j] || am[j];
+  // Строка a - пары (a, b) с b >= a. Строки после уже найденного нарушения не проверяются,
+  // а из строк до него побеждает наименьшая, поэтому ответ не зависит от раздачи задач
+  constexpr std::size_t kNone = ~std::size_t{0};
+  std::atomic<std::size_t> first_row{kNone};
+  std::vector<std::size_t> missing_in_row(distinct.size(), kNone);
+  ParallelFor(distinct.size(), num_threads, [&](std::size_t a) {
+    if (a > first_row.load(std::memory_order_relaxed)) {
+      return;
+    }
+    for (std::size_t b = a; b < distinct.size(); ++b) {
+      if (!set.Contains(Event::Unite(events_[distinct[a]], events_[distinct[b]]))) {
+        missing_in_row[a] = b;
+        std::size_t current = first_row.load(std::memory_order_relaxed);
+        while (a < current && !first_row.compare_exchange_weak(current, a, std::memory_order_relaxed)) {
         }
+        return;
       }
     }
+  });
 
-    events.emplace_back(std::move(mask_event));
+  const std::size_t row = first_row.load();
+  if (row == kNone) {
+    return std::nullopt;
   }
+  return SigmaAlgebraViolation{Kind::MissingUnion, distinct[row], distinct[missing_in_row[row]]};
+}
+
+SigmaAlgebra SigmaAlgebra::Generate(const OutcomeSpace& omega, const std::vector<Event>& generators) {
+  AtomPartition atoms = ComputeAtoms(omega.GetSize(), generators);
+  return SigmaAlgebra(omega, std::move(atoms.atom_of), atoms.num_atoms);
+}
+
+std::size_t SigmaAlgebra::NumAtoms() const noexcept {
+  return atom_offsets_.size() - 1;
+}
+
+std::optional<std::size_t> SigmaAlgebra::AtomOf(OutcomeSpace::OutcomeId id) const noexcept {
+  if (id >= atom_of_.size()) {
+    return std::nullopt;
+  }
+  return atom_of_[id];
+}
+
+std::span<const std::uint32_t> SigmaAlgebra::AtomOutcomes(std::size_t atom) const {
+  if (atom >= NumAtoms()) {
+    throw std::out_of_range("Atom index is out of range");
+  }
+  return std::span<const std::uint32_t>(atom_members_)
+      .subspan(atom_offsets_[atom], atom_offsets_[atom + 1] - atom_offsets_[atom]);
+}
 
-  events = DeduplicateEvents(events);
-  return SigmaAlgebra(omega, std::move(events));
+Event SigmaAlgebra::Atom(std::size_t atom) const {
+  Event e(atom_of_.size());
+  for (std::uint32_t id : AtomOutcomes(atom)) {
+    e.Insert(id);
+  }
+  return e;
+}
+
+bool SigmaAlgebra::IsMeasurable(const Event& event) const {
+  if (event.GetSize() != atom_of_.size()) {
+    return false;
+  }
+  for (std::size_t k = 0; k < NumAtoms(); ++k) {
+    const auto members = AtomOutcomes(k);
+    const bool inside = event.Contains(members.front());
+    for (std::uint32_t id : members) {
+      if (event.Contains(id) != inside) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+SigmaAlgebra::EventEnumerator::EventEnumerator(const SigmaAlgebra& algebra)
+    : algebra_(&algebra),
+      counter_(algebra.NumAtoms()),
+      current_(algebra.atom_of_.size()) {}
+
+const Event& SigmaAlgebra::EventEnumerator::Current() const noexcept {
+  return current_;
+}
+
+bool SigmaAlgebra::EventEnumerator::Next() {
+  if (done_) {
+    return false;
+  }
+
+  // Прибавить единицу к счётчику: код Грея меняется в позиции младшего нулевого бита
+  const std::size_t m = algebra_->NumAtoms();
+  std::size_t flip = 0;
+  while (flip < m && counter_.Contains(flip)) {
+    counter_.Erase(flip);
+    ++flip;
+  }
+  if (flip == m) {
+    done_ = true;
+    return false;
+  }
+  counter_.Insert(flip);
+
+  const auto members = algebra_->AtomOutcomes(flip);
+  if (current_.Contains(members.front())) {
+    for (std::uint32_t id : members) {
+      current_.Erase(id);
+    }
+  } else {
+    for (std::uint32_t id : members) {
+      current_.Insert(id);
+    }
+  }
+  return true;
 }
 
-} // namesapce ptm
\ No newline at end of file
+} // namespace ptm
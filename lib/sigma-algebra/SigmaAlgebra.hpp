@@ -5,28 +5,109 @@
 #include "OutcomeSpace.hpp"
 
 #include <algorithm>
-#include <unordered_map>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 
 namespace ptm {
 
+// Первое найденное нарушение аксиом σ-алгебры
+struct SigmaAlgebraViolation {
+  enum class Kind {
+    WrongSize,         // событие first не над Ω
+    MissingEmpty,      // нет пустого события
+    MissingFull,       // нет Ω
+    MissingComplement, // нет дополнения события first
+    MissingUnion,      // нет объединения событий first и second
+  };
+
+  Kind kind;
+  std::size_t first = 0;
+  std::size_t second = 0;
+};
+
+// Разбиение Ω на атомы
+struct AtomPartition {
+  std::vector<std::uint32_t> atom_of; // атом каждого исхода; номера - в порядке первого исхода
+  std::size_t num_atoms = 0;
+};
+
+// Атомы σ(generators) над Ω из n исходов: исходы в одном атоме, если каждый генератор содержит
+// либо оба, либо ни одного. Генераторы идут блоками по 64: слова блока транспонируются матрицами
+// 64x64 в 64-битный "столбец" принадлежности каждого исхода, и разбиение измельчается по паре
+// (атом, столбец) через хеш-таблицу. O(n * |G| / 64) поисков в таблице, без строк и масок на атом.
+// Генератор другого размера считается не содержащим исходы вне своего Ω
+AtomPartition ComputeAtoms(std::size_t n, std::span<const Event> generators);
+
+// Конечная σ-алгебра. Хранится разбиение Ω на атомы - минимальные непустые множества алгебры:
+// любое её событие - объединение атомов, и их 2^m для m атомов. Поэтому сами события не
+// хранятся: принадлежность проверяется по атомам за O(n), а перечисляются они по требованию.
+// Алгебра, заданная явным семейством событий, хранит и само семейство, а атомы у неё - атомы σ(events)
 class SigmaAlgebra {
 public:
   SigmaAlgebra(const OutcomeSpace& omega, std::vector<Event> events);
 
   [[nodiscard]] const OutcomeSpace& GetOutcomeSpace() const noexcept;
-  [[nodiscard]] const std::vector<Event>& GetEvents() const noexcept;
 
-  [[nodiscard]] bool IsSigmaAlgebra() const;
+  // Явно заданное семейство или все 2^m событий порождённой алгебры (собираются при каждом
+  // вызове; std::runtime_error при m >= 63). Для больших алгебр - EventEnumerator
+  [[nodiscard]] std::vector<Event> GetEvents() const;
+
+  [[nodiscard]] bool IsSigmaAlgebra(std::size_t num_threads = 1) const;
+
+  // Проверка аксиом с диагностикой. События хешируются в EventSet, так что каждый поиск - O(n / 64).
+  // Семейство, в котором различных событий ровно 2^m для атомов σ(events), совпадает с σ(events) -
+  // это проверяется за O(E * n / 64). Иначе нарушение ищется по порядку: размеры, пустое, Ω,
+  // дополнения, затем пары i <= j различных событий на num_threads потоках (0 - по числу ядер).
+  // Индексы - позиции в семействе; среди пар выдаётся наименьшая, независимо от числа потоков
+  [[nodiscard]] std::optional<SigmaAlgebraViolation> FindViolation(std::size_t num_threads = 1) const;
 
   // Построение сигма-алгебры из множества генераторов
   static SigmaAlgebra Generate(const OutcomeSpace& omega, const std::vector<Event>& generators);
 
+  // Число атомов m
+  [[nodiscard]] std::size_t NumAtoms() const noexcept;
+  // Номер атома, содержащего исход; std::nullopt - исход вне Ω
+  [[nodiscard]] std::optional<std::size_t> AtomOf(OutcomeSpace::OutcomeId id) const noexcept;
+  // Исходы атома по возрастанию; std::out_of_range при atom >= NumAtoms()
+  [[nodiscard]] std::span<const std::uint32_t> AtomOutcomes(std::size_t atom) const;
+  [[nodiscard]] Event Atom(std::size_t atom) const;
+
+  // Измеримо ли событие: оно над тем же Ω и каждый атом лежит в нём целиком или не пересекается с ним
+  [[nodiscard]] bool IsMeasurable(const Event& event) const;
+
+  // Обход всех 2^m событий без их хранения: соседние события отличаются одним атомом (код Грея),
+  // так что шаг стоит O(размер атома) в среднем. Первое событие - пустое
+  class EventEnumerator {
+  public:
+    explicit EventEnumerator(const SigmaAlgebra& algebra);
+
+    [[nodiscard]] const Event& Current() const noexcept;
+    // Перейти к следующему событию; false - события кончились, Current() не меняется
+    bool Next();
+
+  private:
+    const SigmaAlgebra* algebra_;
+    Event counter_; // двоичный счётчик по атомам; младший нулевой бит - атом, который переключается
+    Event current_;
+    bool done_ = false;
+  };
+
 private:
+  // Разбиение: atom_of_[i] - атом исхода i, исходы атома k - atom_members_[atom_offsets_[k], atom_offsets_[k + 1])
+  SigmaAlgebra(const OutcomeSpace& omega, std::vector<std::uint32_t> atom_of, std::size_t num_atoms);
+
+  void BuildMembers(std::size_t num_atoms);
+
   const OutcomeSpace& omega_;
   std::vector<Event> events_;
+  bool explicit_ = true;
+  std::vector<std::uint32_t> atom_of_;
+  std::vector<std::size_t> atom_offsets_ = {0};
+  std::vector<std::uint32_t> atom_members_;
 };
 
 } // namespace ptm
@@ -1,14 +1,22 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
 #include <cmath>
 
+#include "lib/distributions/BatchKernels.hpp"
 #include "lib/distributions/BernoulliDistribution.hpp"
 #include "lib/distributions/BinomialDistribution.hpp"
 #include "lib/distributions/CauchyDistribution.hpp"
 #include "lib/distributions/DistributionExperiment.hpp"
+#include "lib/distributions/EmpiricalDistribution.hpp"
 #include "lib/distributions/ExponentialDistribution.hpp"
 #include "lib/distributions/GeometricDistribution.hpp"
+#include "lib/distributions/GoodnessOfFit.hpp"
 #include "lib/distributions/LaplaceDistribution.hpp"
+#include "lib/distributions/MomentAccumulator.hpp"
 #include "lib/distributions/NormalDistribution.hpp"
 #include "lib/distributions/PoissonDistribution.hpp"
 #include "lib/distributions/UniformDistribution.hpp"
@@ -25,6 +33,19 @@ TEST(DistributionTest, NormalDistributionBasicProperties) {
   EXPECT_NEAR(cdf0, 0.5, 1e-3);
 }
 
+// sqrt(n) * D_n для отсортированной выборки; порог 1.95 соответствует уровню ~0.001
+static double ScaledKolmogorovStatistic(std::vector<double> samples, const ptm::Distribution& dist) {
+  std::sort(samples.begin(), samples.end());
+  const double n = static_cast<double>(samples.size());
+
+  double d = 0;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    const double f = dist.Cdf(samples[i]);
+    d = std::max(d, std::max(f - static_cast<double>(i) / n, static_cast<double>(i + 1) / n - f));
+  }
+  return d * std::sqrt(n);
+}
+
 TEST(DistributionExperimentTest, EmpiricalMeanCloseToTheoretical) {
   using namespace ptm;
 
@@ -217,3 +238,444 @@ TEST(DistributionExperimentTest, EmpiricalCdfCloseToTheoretical) {
     EXPECT_NEAR(cdf[i], dist->Cdf(grid[i]), 0.02);
   }
 }
+
+TEST(DistributionTest, SampleNMatchesTheoreticalMoments) {
+  using namespace ptm;
+
+  std::vector<std::shared_ptr<Distribution>> dists = {
+      std::make_shared<NormalDistribution>(1.0, 2.0),
+      std::make_shared<UniformDistribution>(-1.0, 3.0),
+      std::make_shared<ExponentialDistribution>(2.0),
+      std::make_shared<LaplaceDistribution>(0.5, 1.0),
+      std::make_shared<BernoulliDistribution>(0.3),
+      std::make_shared<BinomialDistribution>(10, 0.4),
+      std::make_shared<GeometricDistribution>(0.25),
+      std::make_shared<PoissonDistribution>(3.0),
+  };
+
+  std::mt19937 rng(2024);
+  std::vector<double> samples(100001);
+
+  for (const auto& dist : dists) {
+    dist->SampleN(samples, rng);
+
+    double mean = 0;
+    for (double x : samples) {
+      mean += x;
+    }
+    mean /= static_cast<double>(samples.size());
+
+    double variance = 0;
+    for (double x : samples) {
+      variance += (x - mean) * (x - mean);
+    }
+    variance /= static_cast<double>(samples.size());
+
+    EXPECT_NEAR(mean, dist->TheoreticalMean(), 0.05);
+    EXPECT_NEAR(variance, dist->TheoreticalVariance(), 0.05 * dist->TheoreticalVariance() + 0.01);
+  }
+}
+
+TEST(DistributionTest, SampleNFollowsSampleSequence) {
+  using namespace ptm;
+
+  BernoulliDistribution bd(0.4);
+  std::mt19937 rng1(7);
+  std::mt19937 rng2(7);
+
+  std::vector<double> batch(1000);
+  bd.SampleN(batch, rng1);
+
+  for (double x : batch) {
+    EXPECT_EQ(x, bd.Sample(rng2));
+  }
+}
+
+TEST(DistributionTest, SampleNFloatVariant) {
+  using namespace ptm;
+
+  CauchyDistribution cd(0.0, 1.0);
+  std::mt19937 rng1(11);
+  std::mt19937 rng2(11);
+
+  std::vector<double> as_double(1000);
+  std::vector<float> as_float(1000);
+  cd.SampleN(as_double, rng1);
+  cd.SampleN(std::span<float>(as_float), rng2);
+
+  for (size_t i = 0; i < as_double.size(); ++i) {
+    EXPECT_EQ(as_float[i], static_cast<float>(as_double[i]));
+  }
+}
+
+TEST(DistributionTest, NormalZigguratPassesKolmogorovTest) {
+  using namespace ptm;
+
+  NormalDistribution nd(1.0, 2.0, NormalDistribution::Method::Ziggurat);
+  std::mt19937 rng(99);
+  std::vector<double> samples(200000);
+  nd.SampleN(samples, rng);
+
+  EXPECT_LT(ScaledKolmogorovStatistic(samples, nd), 1.95);
+
+  const double tail = 1.0 + 2.0 * 3.8;
+  const auto tail_count = std::ranges::count_if(samples, [&](double x) { return x > tail; });
+  EXPECT_GT(tail_count, 0);
+}
+
+TEST(DistributionTest, ExponentialZigguratPassesKolmogorovTest) {
+  using namespace ptm;
+
+  ExponentialDistribution ex(0.5, ExponentialDistribution::Method::Ziggurat);
+  std::mt19937 rng(100);
+  std::vector<double> samples(200000);
+  ex.SampleN(samples, rng);
+
+  EXPECT_LT(ScaledKolmogorovStatistic(samples, ex), 1.95);
+
+  for (double x : samples) {
+    EXPECT_GE(x, 0.0);
+  }
+}
+
+TEST(DistributionExperimentTest, StreamRunIsIndependentOfThreadCount) {
+  using namespace ptm;
+
+  auto dist = std::make_shared<NormalDistribution>(1.0, 3.0, NormalDistribution::Method::Ziggurat);
+  DistributionExperiment experiment(dist, 40 * kStreamBlockSize + 123);
+  const StreamKey key{.seed = 2024, .stream = 7};
+
+  const ExperimentStats reference = experiment.Run(key, 1);
+  EXPECT_NEAR(reference.empirical_mean, 1.0, 0.01);
+  EXPECT_NEAR(reference.empirical_variance, 9.0, 0.05);
+
+  for (size_t threads : {2, 8, 32}) {
+    const ExperimentStats stats = experiment.Run(key, threads);
+    EXPECT_EQ(stats.empirical_mean, reference.empirical_mean) << threads << " threads";
+    EXPECT_EQ(stats.empirical_variance, reference.empirical_variance) << threads << " threads";
+  }
+
+  const ExperimentStats other_stream = experiment.Run(StreamKey{.seed = 2024, .stream = 8}, 8);
+  EXPECT_NE(other_stream.empirical_mean, reference.empirical_mean);
+}
+
+TEST(DistributionExperimentTest, StreamRunMatchesMaterializedSample) {
+  using namespace ptm;
+
+  auto dist = std::make_shared<ExponentialDistribution>(0.5);
+  const size_t n = 3 * kStreamBlockSize + 5000;
+  DistributionExperiment experiment(dist, n);
+  const StreamKey key{.seed = 5};
+
+  // Та же выборка, собранная целиком: блок b кусками по 4096 из BlockRng(key, b)
+  std::vector<double> samples;
+  for (size_t begin = 0; begin < n; begin += kStreamBlockSize) {
+    Philox4x32 rng = BlockRng(key, static_cast<std::uint32_t>(begin / kStreamBlockSize));
+    const size_t len = std::min(kStreamBlockSize, n - begin);
+    for (size_t offset = 0; offset < len; offset += 4096) {
+      std::vector<double> chunk(std::min<size_t>(4096, len - offset));
+      dist->SampleN(chunk, rng);
+      samples.insert(samples.end(), chunk.begin(), chunk.end());
+    }
+  }
+
+  double mean = 0;
+  for (double x : samples) {
+    mean += x;
+  }
+  mean /= static_cast<double>(n);
+
+  double variance = 0;
+  for (double x : samples) {
+    variance += (x - mean) * (x - mean);
+  }
+  variance /= static_cast<double>(n);
+
+  const ExperimentStats stats = experiment.Run(key, 4);
+  EXPECT_NEAR(stats.empirical_mean, mean, 1e-12);
+  EXPECT_NEAR(stats.empirical_variance, variance, 1e-10);
+}
+
+TEST(MomentAccumulatorTest, PushBatchAndMergeAgreeWithTwoPass) {
+  using namespace ptm;
+
+  std::mt19937 rng(8);
+  std::vector<double> xs(10007);
+  ExponentialDistribution(1.5).SampleN(xs, rng);
+
+  const double n = static_cast<double>(xs.size());
+  double mean = 0;
+  for (double x : xs) {
+    mean += x;
+  }
+  mean /= n;
+  double m2 = 0;
+  double m3 = 0;
+  double m4 = 0;
+  for (double x : xs) {
+    const double d = x - mean;
+    m2 += d * d;
+    m3 += d * d * d;
+    m4 += d * d * d * d;
+  }
+  const double skewness = std::sqrt(n) * m3 / std::pow(m2, 1.5);
+  const double kurtosis = n * m4 / (m2 * m2) - 3;
+
+  MomentAccumulator one_by_one;
+  for (double x : xs) {
+    one_by_one.Push(x);
+  }
+
+  MomentAccumulator left;
+  MomentAccumulator right;
+  left.Push(std::span<const double>(xs).first(3000));
+  right.Push(std::span<const double>(xs).subspan(3000));
+  left.Merge(right);
+
+  for (const auto& acc : {one_by_one, left}) {
+    EXPECT_EQ(acc.Count(), xs.size());
+    EXPECT_NEAR(acc.Mean(), mean, 1e-12);
+    EXPECT_NEAR(acc.Variance(), m2 / n, 1e-12);
+    EXPECT_NEAR(acc.UnbiasedVariance(), m2 / (n - 1), 1e-12);
+    EXPECT_NEAR(acc.Skewness(), skewness, 1e-9);
+    EXPECT_NEAR(acc.ExcessKurtosis(), kurtosis, 1e-9);
+  }
+}
+
+TEST(DistributionExperimentTest, ReportsHigherMoments) {
+  using namespace ptm;
+
+  std::mt19937 rng(31);
+  auto dist = std::make_shared<ExponentialDistribution>(2.0);
+  DistributionExperiment experiment(dist, 1000000);
+
+  // Для экспоненциального распределения: асимметрия 2, эксцесс 6
+  auto stats = experiment.Run(rng);
+  EXPECT_NEAR(stats.empirical_mean, 0.5, 0.005);
+  EXPECT_NEAR(stats.empirical_skewness, 2.0, 0.1);
+  EXPECT_NEAR(stats.empirical_excess_kurtosis, 6.0, 0.6);
+
+  auto parallel = experiment.Run(StreamKey{.seed = 1}, 4);
+  EXPECT_NEAR(parallel.empirical_skewness, 2.0, 0.1);
+  EXPECT_NEAR(parallel.empirical_excess_kurtosis, 6.0, 0.6);
+}
+
+TEST(EmpiricalDistributionTest, CdfQuantileAndExactModeAgreeWithBruteForce) {
+  using namespace ptm;
+
+  // Выборка больше порога поразрядной сортировки, с повторами и отрицательными значениями
+  std::mt19937 rng(77);
+  std::vector<double> sample(100000);
+  NormalDistribution(0.0, 3.0).SampleN(sample, rng);
+  for (std::size_t i = 0; i < sample.size(); i += 10) {
+    sample[i] = std::round(sample[i]);
+  }
+
+  EmpiricalDistribution empirical(sample);
+  auto sorted = sample;
+  std::sort(sorted.begin(), sorted.end());
+  ASSERT_TRUE(std::ranges::equal(empirical.SortedSample(), sorted));
+
+  const auto n = static_cast<double>(sample.size());
+  std::vector<double> grid;
+  for (double x = -12; x <= 12; x += 0.25) {
+    grid.push_back(x);
+  }
+  const auto cdf = empirical.CdfOnGrid(grid);
+  for (std::size_t i = 0; i < grid.size(); ++i) {
+    const auto count = std::ranges::count_if(sample, [&](double x) { return x <= grid[i]; });
+    EXPECT_DOUBLE_EQ(cdf[i], static_cast<double>(count) / n);
+    EXPECT_DOUBLE_EQ(empirical.Cdf(grid[i]), cdf[i]);
+  }
+
+  std::vector<double> shuffled_grid(grid.rbegin(), grid.rend());
+  const auto reversed = empirical.CdfOnGrid(shuffled_grid);
+  EXPECT_TRUE(std::ranges::equal(reversed, std::vector<double>(cdf.rbegin(), cdf.rend())));
+
+  const auto table = empirical.ExactCdf();
+  ASSERT_EQ(table.x.size(), table.cdf.size());
+  EXPECT_DOUBLE_EQ(table.cdf.back(), 1.0);
+  for (std::size_t i = 0; i < table.x.size(); i += 997) {
+    EXPECT_DOUBLE_EQ(table.cdf[i], empirical.Cdf(table.x[i]));
+  }
+  EXPECT_DOUBLE_EQ(empirical.Pdf(0.0), static_cast<double>(std::ranges::count(sample, 0.0)) / n);
+
+  for (double p : {0.0, 0.1, 0.5, 0.9, 1.0}) {
+    const double q = empirical.Quantile(p);
+    EXPECT_GE(empirical.Cdf(q), p);
+    if (p > 0) {
+      EXPECT_LT(empirical.Cdf(std::nextafter(q, -INFINITY)), p);
+    }
+  }
+  EXPECT_DOUBLE_EQ(empirical.Quantile(0.0), sorted.front());
+  EXPECT_DOUBLE_EQ(empirical.Quantile(1.0), sorted.back());
+  EXPECT_THROW(static_cast<void>(empirical.Quantile(1.5)), std::invalid_argument);
+  EXPECT_THROW(EmpiricalDistribution(std::vector<double>{}), std::invalid_argument);
+}
+
+TEST(GoodnessOfFitTest, KolmogorovDistributionKnownValues) {
+  using namespace ptm;
+
+  // Классические критические значения: sqrt(n) D_n = 1.3581 при alpha = 0.05 и 1.6276 при alpha = 0.01
+  EXPECT_NEAR(KolmogorovSurvival(1.3581), 0.05, 1e-4);
+  EXPECT_NEAR(KolmogorovSurvival(1.6276), 0.01, 1e-4);
+  EXPECT_NEAR(KolmogorovCdf(0.5) + KolmogorovSurvival(0.5), 1.0, 1e-15);
+  EXPECT_NEAR(KolmogorovCdf(0.9999999), KolmogorovCdf(1.0000001), 1e-6);
+
+  // n = 1: D_1 = max(U, 1 - U), P(D_1 < d) = 2d - 1
+  EXPECT_NEAR(KolmogorovExactCdf(1, 0.7), 0.4, 1e-12);
+  EXPECT_DOUBLE_EQ(KolmogorovExactCdf(10, 0.04), 0.0);
+  EXPECT_DOUBLE_EQ(KolmogorovExactCdf(10, 1.0), 1.0);
+  EXPECT_TRUE(std::isnan(KolmogorovExactCdf(100000, 0.003)));
+}
+
+TEST(GoodnessOfFitTest, ExactKolmogorovMatchesMonteCarlo) {
+  using namespace ptm;
+
+  constexpr std::size_t kN = 6;
+  constexpr int kReps = 200000;
+  const UniformDistribution uniform(0.0, 1.0);
+  const std::vector<double> ds = {0.2, 0.3, 0.4, 0.5};
+  std::vector<int> below(ds.size(), 0);
+
+  std::mt19937 rng(5);
+  std::vector<double> xs(kN);
+  for (int r = 0; r < kReps; ++r) {
+    uniform.SampleN(xs, rng);
+    const double d = TestGoodnessOfFit(EmpiricalDistribution(xs), uniform).ks_statistic;
+    for (std::size_t i = 0; i < ds.size(); ++i) {
+      below[i] += d < ds[i] ? 1 : 0;
+    }
+  }
+
+  for (std::size_t i = 0; i < ds.size(); ++i) {
+    EXPECT_NEAR(KolmogorovExactCdf(kN, ds[i]), static_cast<double>(below[i]) / kReps, 0.005);
+  }
+}
+
+TEST(GoodnessOfFitTest, StatisticsUnderNullAndAlternative) {
+  using namespace ptm;
+
+  // При H0 E[W^2] = 1/6 и E[A^2] = 1 при любом n
+  constexpr int kReps = 4000;
+  const NormalDistribution normal(1.0, 2.0);
+  std::mt19937 rng(11);
+  std::vector<double> xs(50);
+  double cramer = 0;
+  double anderson = 0;
+  int rejected = 0;
+  for (int r = 0; r < kReps; ++r) {
+    normal.SampleN(xs, rng);
+    const auto result = TestGoodnessOfFit(EmpiricalDistribution(xs), normal);
+    cramer += result.cramer_von_mises;
+    anderson += result.anderson_darling;
+    rejected += result.ks_pvalue_exact < 0.05 ? 1 : 0;
+  }
+  EXPECT_NEAR(cramer / kReps, 1.0 / 6, 0.01);
+  EXPECT_NEAR(anderson / kReps, 1.0, 0.05);
+  EXPECT_NEAR(static_cast<double>(rejected) / kReps, 0.05, 0.015);
+
+  // Сдвинутая выборка отвергается всеми тремя критериями
+  DistributionExperiment experiment(std::make_shared<NormalDistribution>(1.5, 2.0), 2000);
+  const auto shifted = TestGoodnessOfFit(experiment.Empirical(rng, 2000), normal);
+  EXPECT_EQ(shifted.sample_size, 2000U);
+  EXPECT_LT(shifted.ks_pvalue_asymptotic, 1e-6);
+  EXPECT_GT(shifted.anderson_darling, 10.0);
+  EXPECT_GT(shifted.cramer_von_mises, 2.0);
+}
+
+// Расстояние в ULP между двумя double одного знака (через монотонное отображение в целые)
+static std::int64_t UlpDistance(double a, double b) {
+  if (a == b) {
+    return 0;
+  }
+  auto key = [](double x) {
+    const auto bits = std::bit_cast<std::int64_t>(x);
+    return bits < 0 ? std::numeric_limits<std::int64_t>::min() - bits : bits;
+  };
+  const std::int64_t ka = key(a);
+  const std::int64_t kb = key(b);
+  return ka > kb ? ka - kb : kb - ka;
+}
+
+TEST(DistributionTest, BatchEvaluationMatchesScalarWithinUlpBound) {
+  using namespace ptm;
+
+  std::vector<std::shared_ptr<Distribution>> dists = {
+      std::make_shared<NormalDistribution>(1.0, 2.0),
+      std::make_shared<NormalDistribution>(-3.0, 0.1),
+      std::make_shared<UniformDistribution>(-1.0, 3.0),
+      std::make_shared<ExponentialDistribution>(2.0),
+      std::make_shared<ExponentialDistribution>(1e-3),
+      std::make_shared<LaplaceDistribution>(0.5, 1.5),
+      std::make_shared<CauchyDistribution>(1.0, 3.0),
+      std::make_shared<BernoulliDistribution>(0.3),
+  };
+
+  std::vector<double> xs;
+  for (double x = -60; x <= 60; x += 0.0137) {
+    xs.push_back(x);
+  }
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> wide(-1e4, 1e4);
+  for (int i = 0; i < 10000; ++i) {
+    xs.push_back(wide(rng));
+  }
+  for (double x : {0.0, -0.0, 1e-300, -1e-300, 1e-12, 0.5, 3.0, 1e300, -1e300}) {
+    xs.push_back(x);
+  }
+
+  std::vector<double> pdf(xs.size());
+  std::vector<double> log_pdf(xs.size());
+  std::vector<double> cdf(xs.size());
+  for (const auto& dist : dists) {
+    dist->PdfN(xs, pdf);
+    dist->LogPdfN(xs, log_pdf);
+    dist->CdfN(xs, cdf);
+
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      const double x = xs[i];
+      const double scalar_pdf = dist->Pdf(x);
+      if (scalar_pdf == 0 || std::isnormal(scalar_pdf)) {
+        EXPECT_LE(UlpDistance(pdf[i], scalar_pdf), kBatchUlpBound) << "pdf at " << x;
+      }
+      EXPECT_LE(UlpDistance(log_pdf[i], dist->LogPdf(x)), kBatchUlpBound) << "log pdf at " << x;
+      const double scalar_cdf = dist->Cdf(x);
+      if (scalar_cdf == 0 || std::isnormal(scalar_cdf)) {
+        EXPECT_LE(UlpDistance(cdf[i], scalar_cdf), kBatchUlpBound) << "cdf at " << x;
+      }
+      if (std::isnormal(scalar_pdf)) {
+        EXPECT_NEAR(dist->LogPdf(x), std::log(scalar_pdf), 1e-12 * std::max(1.0, std::abs(std::log(scalar_pdf))));
+      }
+    }
+  }
+}
+
+TEST(DistributionTest, DensitiesIntegrateToOne) {
+  using namespace ptm;
+
+  // Плотность равномерного вне [a, b] нулевая, у Коши учитывается масштаб gamma
+  UniformDistribution ud(0.0, 2.0);
+  EXPECT_DOUBLE_EQ(ud.Pdf(-1.0), 0.0);
+  EXPECT_DOUBLE_EQ(ud.Pdf(3.0), 0.0);
+
+  std::vector<std::shared_ptr<Distribution>> dists = {
+      std::make_shared<NormalDistribution>(0.0, 3.0),
+      std::make_shared<LaplaceDistribution>(1.0, 2.0),
+      std::make_shared<CauchyDistribution>(0.0, 2.0),
+  };
+  for (const auto& dist : dists) {
+    constexpr double kStep = 1e-3;
+    std::vector<double> xs;
+    for (double x = -50; x <= 50; x += kStep) {
+      xs.push_back(x);
+    }
+    std::vector<double> pdf(xs.size());
+    dist->PdfN(xs, pdf);
+    double integral = 0;
+    for (double p : pdf) {
+      integral += p * kStep;
+    }
+    EXPECT_NEAR(integral, dist->Cdf(50) - dist->Cdf(-50), 1e-4);
+  }
+}
@@ -103,4 +103,30 @@ TEST(LawOfLargeNumbersTest, DeterministicWithSameSeed) {
     EXPECT_DOUBLE_EQ(r1.entries[i].sample_mean, r2.entries[i].sample_mean);
     EXPECT_DOUBLE_EQ(r1.entries[i].abs_error, r2.entries[i].abs_error);
   }
-}
\ No newline at end of file
+}
+
+TEST(LawOfLargeNumbersTest, StreamSimulationIsIndependentOfThreadCount) {
+  using namespace ptm;
+
+  auto dist = std::make_shared<BernoulliDistribution>(0.3);
+  LawOfLargeNumbersSimulator sim(dist);
+
+  const size_t max_n = 20 * kStreamBlockSize + 777;
+  const size_t step = 1000;
+  const StreamKey key{.seed = 99, .stream = 1};
+
+  LLNPathResult reference = sim.Simulate(key, max_n, step, 1);
+  ASSERT_EQ(reference.entries.size(), max_n / step);
+  EXPECT_EQ(reference.entries.back().n, (max_n / step) * step);
+  EXPECT_NEAR(reference.entries.back().sample_mean, 0.3, 0.01);
+
+  for (size_t threads : {2, 8, 32}) {
+    LLNPathResult r = sim.Simulate(key, max_n, step, threads);
+    ASSERT_EQ(r.entries.size(), reference.entries.size());
+
+    for (size_t i = 0; i < r.entries.size(); ++i) {
+      EXPECT_EQ(r.entries[i].n, reference.entries[i].n);
+      EXPECT_EQ(r.entries[i].sample_mean, reference.entries[i].sample_mean);
+    }
+  }
+}
@@ -1,9 +1,22 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <tuple>
 #include <gtest/gtest.h>
 
+#include "../lib/markov-chain/AliasTable.hpp"
+#include "../lib/markov-chain/ChainAnalysis.hpp"
 #include "../lib/markov-chain/MarkovChain.hpp"
+#include "../lib/markov-chain/MarkovSnapshot.hpp"
 #include "../lib/markov-chain/MarkovTextModel.hpp"
+#include "../lib/markov-chain/NGramModel.hpp"
+#include "../lib/markov-chain/TokenInterner.hpp"
+#include "../lib/markov-chain/TransitionTable.hpp"
 
 TEST(MarkovChainTest, SimpleCountsAndProbabilities) {
   using namespace ptm;
@@ -161,4 +174,718 @@ TEST(MarkovChainTest, GenerateLengthOneReturnsOnlyStart) {
   EXPECT_EQ(seq[0], "A");
 }
 
-// Add your tests...
+TEST(AliasTableTest, FrequenciesMatchWeights) {
+  using namespace ptm;
+
+  const std::vector<std::size_t> weights = {1, 0, 7, 3, 100, 1, 13};
+  std::vector<AliasSlot> slots(weights.size());
+  BuildAliasTable(weights, slots);
+
+  constexpr int kDraws = 1000000;
+  std::vector<int> hits(weights.size(), 0);
+  std::mt19937_64 rng(9);
+  for (int i = 0; i < kDraws; ++i) {
+    ++hits[SampleAlias(slots, rng)];
+  }
+
+  const double total = 125;
+  EXPECT_EQ(hits[1], 0);
+  for (std::size_t i = 0; i < weights.size(); ++i) {
+    const double p = static_cast<double>(weights[i]) / total;
+    EXPECT_NEAR(static_cast<double>(hits[i]) / kDraws, p, 4 * std::sqrt(p * (1 - p) / kDraws) + 1e-9);
+  }
+}
+
+TEST(MarkovChainTest, SampleNextFollowsCountsAndSeesRetraining) {
+  using namespace ptm;
+
+  MarkovChain chain;
+  chain.Train({"A", "B", "A", "B", "A", "C"});
+
+  auto frequency_of_b = [](const MarkovChain& c) {
+    std::mt19937 rng(77);
+    int b = 0;
+    for (int i = 0; i < 100000; ++i) {
+      b += c.SampleNext("A", rng) == "B" ? 1 : 0;
+    }
+    return b / 100000.0;
+  };
+
+  EXPECT_NEAR(frequency_of_b(chain), 2.0 / 3, 0.01);
+
+  // Дообучение сбрасывает таблицы выборки, копия цепочки строит свои
+  chain.Train({"A", "C", "A", "C"});
+  EXPECT_NEAR(frequency_of_b(chain), 2.0 / 5, 0.01);
+  const MarkovChain copy = chain;
+  EXPECT_NEAR(frequency_of_b(copy), 2.0 / 5, 0.01);
+}
+
+TEST(TransitionTableTest, IncrementalFlushMatchesDenseCounts) {
+  using namespace ptm;
+
+  constexpr std::uint32_t kStates = 40;
+  std::vector<std::vector<std::size_t>> dense(kStates, std::vector<std::size_t>(kStates, 0));
+  CsrTransitions csr;
+  std::mt19937 rng(4);
+  std::uniform_int_distribution<std::uint32_t> state(0, kStates - 1);
+
+  // Строки появляются постепенно, как новые токены при дообучении
+  for (std::uint32_t rows = 5; rows <= kStates; rows += 5) {
+    std::uniform_int_distribution<std::uint32_t> known(0, rows - 1);
+    TransitionAccumulator pending;
+    for (int i = 0; i < 300; ++i) {
+      const std::uint32_t from = known(rng);
+      const std::uint32_t to = known(rng);
+      pending.Add(from, to);
+      ++dense[from][to];
+    }
+    pending.FlushInto(csr, rows);
+    EXPECT_TRUE(pending.Empty());
+    ASSERT_EQ(csr.NumRows(), rows);
+  }
+
+  for (std::uint32_t i = 0; i < kStates; ++i) {
+    const auto columns = csr.RowColumns(i);
+    EXPECT_TRUE(std::ranges::is_sorted(columns));
+    std::size_t sum = 0;
+    for (std::uint32_t j = 0; j < kStates; ++j) {
+      EXPECT_EQ(csr.Count(i, j), dense[i][j]);
+      sum += dense[i][j];
+    }
+    EXPECT_EQ(csr.row_sums[i], sum);
+    EXPECT_EQ(columns.size(), static_cast<std::size_t>(std::ranges::count_if(dense[i], [](std::size_t c) { return c > 0; })));
+  }
+}
+
+TEST(TokenInternerTest, RoundTripAcrossGrowth) {
+  using namespace ptm;
+
+  TokenInterner interner;
+  std::vector<std::string> words;
+  for (int i = 0; i < 5000; ++i) {
+    words.push_back("w" + std::to_string(i * 7919 % 10007));
+  }
+
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    EXPECT_EQ(interner.Intern(words[i]), i);
+  }
+  EXPECT_EQ(interner.Size(), words.size());
+
+  // После нескольких перехешей все ID и строки на месте, повторное Intern не добавляет токен
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    EXPECT_EQ(interner.Intern(words[i]), i);
+    EXPECT_EQ(interner.Find(words[i]), i);
+    EXPECT_EQ(interner.Resolve(static_cast<TokenInterner::Id>(i)), words[i]);
+  }
+  EXPECT_EQ(interner.Size(), words.size());
+  EXPECT_FALSE(interner.Find("missing").has_value());
+  EXPECT_FALSE(interner.Find("").has_value());
+}
+
+TEST(MarkovChainTest, IdPipelineMatchesStringPipeline) {
+  using namespace ptm;
+
+  const std::vector<std::string> seq = {"a", "b", "a", "c", "b", "a", "b", "c", "c", "a"};
+
+  MarkovChain by_string;
+  by_string.Train(seq);
+
+  MarkovChain by_id;
+  std::vector<MarkovChain::StateId> ids;
+  for (const auto& s : seq) {
+    ids.push_back(by_id.Intern(s));
+  }
+  by_id.TrainIds(ids);
+
+  ASSERT_EQ(by_id.States(), by_string.States());
+  for (const auto& from : by_string.States()) {
+    for (const auto& to : by_string.States()) {
+      EXPECT_DOUBLE_EQ(by_id.TransitionProbability(from, to), by_string.TransitionProbability(from, to));
+    }
+  }
+
+  // Генерация по ID и по строкам при одном зерне даёт одну и ту же последовательность
+  std::mt19937 rng_a(5);
+  std::mt19937 rng_b(5);
+  const auto strings = by_string.Generate("a", 50, rng_a);
+  std::vector<MarkovChain::StateId> generated;
+  ASSERT_EQ(by_id.GenerateIds(*by_id.FindState("a"), 50, rng_b, generated), strings.size());
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(by_id.StateName(generated[i]), strings[i]);
+  }
+
+  // Интернированное, но ещё не обученное состояние - тупик без переходов
+  const auto fresh = by_id.Intern("d");
+  EXPECT_EQ(by_id.NumStates(), 4U);
+  EXPECT_EQ(by_id.GenerateIds(fresh, 10, rng_b, generated), 1U);
+  EXPECT_TRUE(by_id.NextDistribution("d").empty());
+}
+
+TEST(MarkovChainTest, TrainIdsRejectsUnknownIds) {
+  using namespace ptm;
+
+  MarkovChain chain;
+  const auto a = chain.Intern("a");
+  const auto b = chain.Intern("b");
+  chain.TrainIds(std::vector<MarkovChain::StateId>{a, b, a});
+
+  EXPECT_THROW(chain.TrainIds(std::vector<MarkovChain::StateId>{a, 2, b}), std::invalid_argument);
+  EXPECT_THROW(chain.TrainIds(std::vector<MarkovChain::StateId>{b, a, kEmptyTokenSlot}), std::invalid_argument);
+
+  // Достаточно длинная последовательность, чтобы подсчёт шёл по участкам на нескольких потоках
+  std::vector<MarkovChain::StateId> long_sequence(3 * kMinPairsPerShard);
+  for (std::size_t i = 0; i < long_sequence.size(); ++i) {
+    long_sequence[i] = i % 2 == 0 ? a : b;
+  }
+  long_sequence[long_sequence.size() / 2] = 7;
+  EXPECT_THROW(chain.TrainIds(long_sequence, 4), std::invalid_argument);
+
+  // Отклонённые вызовы ничего не добавили
+  EXPECT_EQ(chain.NumTransitions(), 2U);
+  EXPECT_DOUBLE_EQ(chain.TransitionProbability("a", "b"), 1.0);
+  EXPECT_EQ(chain.Transitions().row_sums, (std::vector<std::size_t>{1, 1}));
+}
+
+TEST(NGramModelTest, LongerContextAndBackoff) {
+  using namespace ptm;
+
+  EXPECT_THROW(NGramModel(0), std::invalid_argument);
+  EXPECT_THROW(NGramModel(NGramModel::kMaxOrder + 1), std::invalid_argument);
+
+  // После 0 идут 1 и 3 поровну, но после (2, 0) - всегда 3, после (4, 0) - всегда 1
+  std::vector<NGramModel::Id> seq;
+  for (int r = 0; r < 10; ++r) {
+    seq.insert(seq.end(), {0, 1, 2, 0, 3, 4});
+  }
+
+  NGramModel first(1);
+  NGramModel second(2);
+  first.Train(seq);
+  second.Train(seq);
+
+  EXPECT_DOUBLE_EQ(first.Probability(std::vector<NGramModel::Id>{2, 0}, 3), 0.5);
+  EXPECT_DOUBLE_EQ(second.Probability(std::vector<NGramModel::Id>{2, 0}, 3), 1.0);
+  EXPECT_DOUBLE_EQ(second.Probability(std::vector<NGramModel::Id>{4, 0}, 1), 1.0);
+  EXPECT_EQ(second.MatchedOrder(std::vector<NGramModel::Id>{2, 0}), 2U);
+
+  // Контекст (3, 3) не встречался - бэкофф к (3), совсем незнакомый токен - к униграммам
+  EXPECT_EQ(second.MatchedOrder(std::vector<NGramModel::Id>{3, 3}), 1U);
+  EXPECT_DOUBLE_EQ(second.Probability(std::vector<NGramModel::Id>{3, 3}, 4), 1.0);
+  EXPECT_EQ(second.MatchedOrder(std::vector<NGramModel::Id>{99}), 0U);
+  EXPECT_NEAR(second.Probability(std::vector<NGramModel::Id>{99}, 0), 19.0 / 59, 1e-12);
+
+  // Порядка 2 достаточно, чтобы генерация повторяла цикл без ошибок
+  std::mt19937 rng(8);
+  const std::vector<NGramModel::Id> context = {0, 1};
+  std::vector<NGramModel::Id> out = context;
+  EXPECT_EQ(second.Generate(context, 60, rng, out), 60U);
+  for (std::size_t i = 6; i < out.size(); ++i) {
+    EXPECT_EQ(out[i], out[i - 6]);
+  }
+}
+
+TEST(MarkovChainTest, ManySmallTrainCallsMatchOneShotTraining) {
+  using namespace ptm;
+
+  std::mt19937 rng(21);
+  std::vector<std::string> words;
+  for (int i = 0; i < 20000; ++i) {
+    words.push_back("w" + std::to_string(rng() % 300));
+  }
+
+  MarkovChain whole;
+  whole.Train(words);
+
+  // Соседние куски делят токен на стыке, так что переходы те же, что у всей последовательности.
+  // Чтения между вызовами заставляют замораживать CSR посреди обучения
+  MarkovChain pieces;
+  std::size_t begin = 0;
+  for (std::size_t piece = 0; begin + 1 < words.size(); ++piece) {
+    const std::size_t end = std::min(words.size(), begin + 2 + rng() % 20);
+    pieces.Train(std::vector<std::string>(words.begin() + static_cast<std::ptrdiff_t>(begin),
+                                          words.begin() + static_cast<std::ptrdiff_t>(end)));
+    if (piece % 97 == 0) {
+      EXPECT_GT(pieces.NumTransitions(), 0U);
+    }
+    begin = end - 1;
+  }
+
+  ASSERT_EQ(pieces.States(), whole.States());
+  EXPECT_EQ(pieces.Transitions().row_offsets, whole.Transitions().row_offsets);
+  EXPECT_EQ(pieces.Transitions().columns, whole.Transitions().columns);
+  EXPECT_EQ(pieces.Transitions().counts, whole.Transitions().counts);
+  EXPECT_EQ(pieces.Transitions().row_sums, whole.Transitions().row_sums);
+
+  std::mt19937 rng_a(4);
+  std::mt19937 rng_b(4);
+  EXPECT_EQ(pieces.Generate("w0", 200, rng_a), whole.Generate("w0", 200, rng_b));
+
+  // У n-граммной модели контекст не переходит между вызовами Train, поэтому эталон - те же куски,
+  // накопленные снаружи и переданные одним Commit
+  NGramModel trained(3);
+  NGramModel committed(3);
+  TransitionAccumulator pending;
+  std::vector<NGramModel::Id> ids;
+  for (const auto& w : words) {
+    ids.push_back(*whole.FindState(w));
+  }
+  for (std::size_t at = 0; at < ids.size(); at += 50) {
+    const std::span<const NGramModel::Id> sentence(ids.data() + at, std::min<std::size_t>(50, ids.size() - at));
+    trained.Train(sentence);
+    committed.Accumulate(sentence, 0, pending);
+    if (at % 5000 == 0) {
+      EXPECT_EQ(trained.MatchedOrder(sentence.first(sentence.size() - 1)), 3U);
+    }
+  }
+  committed.Commit(pending);
+
+  ASSERT_EQ(trained.NumContexts(), committed.NumContexts());
+  for (std::size_t at = 3; at < ids.size(); at += 101) {
+    const std::span<const NGramModel::Id> history(ids.data() + at - 3, 3);
+    EXPECT_EQ(trained.MatchedOrder(history), committed.MatchedOrder(history));
+    EXPECT_DOUBLE_EQ(trained.Probability(history, ids[at]), committed.Probability(history, ids[at]));
+  }
+}
+
+TEST(MarkovTextModelTest, HigherOrderWordModelOnWarAndPeace) {
+  using namespace ptm;
+
+  std::ifstream in("war_and_peace.txt");
+  ASSERT_TRUE(in.good());
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+
+  MarkovTextModel model(MarkovTextModel::TokenLevel::Word, 4);
+  model.TrainFromText(buffer.str());
+  EXPECT_EQ(model.Order(), 4U);
+
+  std::mt19937 rng(11);
+  const std::string generated = model.GenerateText(200, rng, "the");
+  EXPECT_GT(std::ranges::count(generated, ' '), 100);
+}
+
+TEST(TransitionTableTest, ParallelCountingMatchesSequential) {
+  using namespace ptm;
+
+  constexpr std::uint32_t kStates = 700;
+  std::mt19937 rng(21);
+  // Неравномерные частоты: строки с малыми ID заметно тяжелее
+  std::geometric_distribution<std::uint32_t> state(0.01);
+  std::vector<std::uint32_t> seq(400'000);
+  for (auto& s : seq) {
+    s = std::min(state(rng), kStates - 1);
+  }
+
+  CsrTransitions sequential;
+  TransitionAccumulator pending;
+  for (std::size_t i = 0; i + 1 < seq.size(); ++i) {
+    pending.Add(seq[i], seq[i + 1]);
+  }
+  pending.FlushInto(sequential, kStates);
+
+  for (std::size_t threads : {2, 3, 6}) {
+    // Дообучение поверх уже заполненной таблицы тоже сходится
+    CsrTransitions parallel;
+    AddTransitionsParallel(std::span(seq).first(150'001), kStates, threads, parallel);
+    AddTransitionsParallel(std::span(seq).subspan(150'000), kStates, threads, parallel);
+    EXPECT_EQ(parallel.row_offsets, sequential.row_offsets);
+    EXPECT_EQ(parallel.columns, sequential.columns);
+    EXPECT_EQ(parallel.counts, sequential.counts);
+    EXPECT_EQ(parallel.row_sums, sequential.row_sums);
+  }
+}
+
+TEST(MarkovTextModelTest, ParallelTrainingMatchesSequentialOnWarAndPeace) {
+  using namespace ptm;
+
+  std::ifstream in("war_and_peace.txt");
+  ASSERT_TRUE(in.good());
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string text = buffer.str();
+
+  for (auto level : {MarkovTextModel::TokenLevel::Word, MarkovTextModel::TokenLevel::Character}) {
+    MarkovTextModel sequential(level);
+    sequential.TrainFromText(text);
+
+    for (std::size_t threads : {4, 7}) {
+      MarkovTextModel parallel(level);
+      parallel.TrainFromText(text, threads);
+
+      ASSERT_EQ(parallel.Chain().States(), sequential.Chain().States());
+      const CsrTransitions& a = parallel.Chain().Transitions();
+      const CsrTransitions& b = sequential.Chain().Transitions();
+      EXPECT_EQ(a.row_offsets, b.row_offsets);
+      EXPECT_EQ(a.columns, b.columns);
+      EXPECT_EQ(a.counts, b.counts);
+
+      std::mt19937 rng_a(3);
+      std::mt19937 rng_b(3);
+      EXPECT_EQ(parallel.GenerateText(100, rng_a, "the"), sequential.GenerateText(100, rng_b, "the"));
+    }
+  }
+}
+
+TEST(MarkovTextModelTest, StreamingTrainingMatchesWholeText) {
+  using namespace ptm;
+
+  const std::string text = "The cat (a grey one) sat. The dog, however, didn't sit: it ran! Then the cat ran too.";
+
+  for (auto level : {MarkovTextModel::TokenLevel::Word, MarkovTextModel::TokenLevel::Character}) {
+    for (std::size_t order : {1, 3}) {
+      MarkovTextModel whole(level, order);
+      whole.TrainFromText(text);
+
+      // Куски по 1, 5 и 7 байт рвут слова и знаки во всех местах
+      for (std::size_t chunk : {1, 5, 7, 4096}) {
+        MarkovTextModel streamed(level, order);
+        std::istringstream in(text);
+        streamed.TrainFromStream(in, chunk);
+
+        ASSERT_EQ(streamed.Chain().States(), whole.Chain().States());
+        EXPECT_EQ(streamed.Chain().Transitions().columns, whole.Chain().Transitions().columns);
+        EXPECT_EQ(streamed.Chain().Transitions().counts, whole.Chain().Transitions().counts);
+
+        std::mt19937 rng_a(17);
+        std::mt19937 rng_b(17);
+        EXPECT_EQ(streamed.GenerateText(40, rng_a, "the"), whole.GenerateText(40, rng_b, "the"));
+      }
+    }
+  }
+
+  MarkovTextModel model;
+  EXPECT_THROW(model.TrainFromFile("no_such_corpus.txt"), std::runtime_error);
+  std::istringstream in(text);
+  EXPECT_THROW(model.TrainFromStream(in, 0), std::invalid_argument);
+}
+
+TEST(MarkovTextModelTest, TrainFromFileMatchesTrainFromText) {
+  using namespace ptm;
+
+  std::ifstream in("war_and_peace.txt");
+  ASSERT_TRUE(in.good());
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+
+  MarkovTextModel whole(MarkovTextModel::TokenLevel::Word);
+  whole.TrainFromText(buffer.str());
+
+  MarkovTextModel streamed(MarkovTextModel::TokenLevel::Word);
+  streamed.TrainFromFile("war_and_peace.txt", 64 * 1024);
+
+  ASSERT_EQ(streamed.Chain().States(), whole.Chain().States());
+  EXPECT_EQ(streamed.Chain().Transitions().columns, whole.Chain().Transitions().columns);
+  EXPECT_EQ(streamed.Chain().Transitions().counts, whole.Chain().Transitions().counts);
+}
+
+TEST(MarkovSnapshotTest, RoundTripMatchesTrainedChain) {
+  using namespace ptm;
+
+  MarkovTextModel model(MarkovTextModel::TokenLevel::Word);
+  model.TrainFromFile("war_and_peace.txt");
+  const MarkovChain& chain = model.Chain();
+
+  const std::string path = "markov_snapshot_test.bin";
+  SaveSnapshot(chain, path);
+  const MarkovSnapshot snapshot = MarkovSnapshot::Open(path);
+
+  ASSERT_EQ(snapshot.NumStates(), chain.NumStates());
+  EXPECT_EQ(snapshot.NumTransitions(), chain.NumTransitions());
+  for (MarkovChain::StateId id = 0; id < chain.NumStates(); id += 97) {
+    EXPECT_EQ(snapshot.StateName(id), chain.StateName(id));
+    EXPECT_EQ(snapshot.FindState(chain.StateName(id)), id);
+  }
+  EXPECT_FALSE(snapshot.FindState("no-such-word").has_value());
+
+  const auto the = *snapshot.FindState("the");
+  const auto end = *snapshot.FindState(".");
+  EXPECT_DOUBLE_EQ(snapshot.TransitionProbability(the, end),
+                   chain.TransitionProbability("the", "."));
+  const auto of = *snapshot.FindState("of");
+  EXPECT_DOUBLE_EQ(snapshot.TransitionProbability(of, the), chain.TransitionProbability("of", "the"));
+
+  // Таблицы выборки сохранены как есть - генерация с тем же зерном совпадает
+  std::mt19937 rng_a(9);
+  std::mt19937 rng_b(9);
+  std::vector<MarkovChain::StateId> from_chain;
+  std::vector<MarkovChain::StateId> from_snapshot;
+  chain.GenerateIds(the, 500, rng_a, from_chain);
+  snapshot.GenerateIds(the, 500, rng_b, from_snapshot);
+  EXPECT_EQ(from_snapshot, from_chain);
+
+  std::remove(path.c_str());
+}
+
+TEST(MarkovSnapshotTest, RejectsDamagedFiles) {
+  using namespace ptm;
+
+  MarkovChain chain;
+  chain.Train({"a", "b", "a", "c", "a", "b"});
+  chain.Intern("untrained");
+
+  const std::string path = "markov_snapshot_damaged.bin";
+  SaveSnapshot(chain, path);
+  {
+    const MarkovSnapshot snapshot = MarkovSnapshot::Open(path);
+    EXPECT_EQ(snapshot.NumStates(), 4U);
+    std::mt19937 rng(1);
+    EXPECT_FALSE(snapshot.SampleNext(*snapshot.FindState("untrained"), rng).has_value());
+    EXPECT_DOUBLE_EQ(snapshot.TransitionProbability(0, 1), 2.0 / 3);
+  }
+
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  auto write = [&](const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+  };
+
+  std::string corrupted = bytes;
+  corrupted[corrupted.size() - 100] ^= 1;
+  write(corrupted);
+  EXPECT_THROW(MarkovSnapshot::Open(path), std::runtime_error);
+  EXPECT_NO_THROW(MarkovSnapshot::Open(path, false));
+
+  write(bytes.substr(0, bytes.size() - 64));
+  EXPECT_THROW(MarkovSnapshot::Open(path), std::runtime_error);
+
+  std::string wrong_version = bytes;
+  wrong_version[8] = 99;
+  write(wrong_version);
+  EXPECT_THROW(MarkovSnapshot::Open(path), std::runtime_error);
+
+  // Без контрольной суммы структура всё равно проверяется. Заголовок: num_slots по смещению 32,
+  // num_transitions - 40. Четыре перехода: с конца файла по 64 байта таблица Уолкера, row_sums,
+  // counts, columns, row_offsets
+  auto patched = [&](std::size_t offset, auto value) {
+    std::string result = bytes;
+    std::memcpy(result.data() + offset, &value, sizeof(value));
+    return result;
+  };
+  const std::size_t alias_at = bytes.size() - 64;
+  const std::size_t columns_at = bytes.size() - 4 * 64;
+  const std::size_t row_offsets_at = bytes.size() - 5 * 64;
+  for (const std::string& damaged : {patched(32, std::uint64_t{24}),
+                                     patched(40, ~std::uint64_t{0}),
+                                     patched(columns_at, std::uint32_t{4}),
+                                     patched(row_offsets_at + 8, std::uint64_t{5}),
+                                     patched(alias_at + 8, std::uint32_t{2})}) {
+    write(damaged);
+    EXPECT_THROW(MarkovSnapshot::Open(path, false), std::runtime_error);
+  }
+  write(patched(alias_at + 8, std::uint32_t{1}));
+  EXPECT_NO_THROW(MarkovSnapshot::Open(path, false));
+
+  write("not a snapshot at all, just some text that is long enough to hold a header......");
+  EXPECT_THROW(MarkovSnapshot::Open(path), std::runtime_error);
+
+  std::remove(path.c_str());
+  EXPECT_THROW(MarkovSnapshot::Open(path), std::runtime_error);
+}
+
+TEST(MarkovSnapshotTest, ResaveKeepsOpenSnapshotReadable) {
+  using namespace ptm;
+
+  MarkovChain small;
+  small.Train({"a", "b", "a", "c"});
+  MarkovChain large;
+  large.Train({"x", "y", "z", "x", "y", "x", "w", "v", "u", "x"});
+
+  const std::string path = "markov_snapshot_resave.bin";
+  SaveSnapshot(large, path);
+  const MarkovSnapshot old_snapshot = MarkovSnapshot::Open(path);
+
+  // Новый файл короче старого: при перезаписи на месте чтение хвоста старого отображения упало бы
+  SaveSnapshot(small, path);
+  EXPECT_EQ(old_snapshot.NumStates(), large.NumStates());
+  EXPECT_EQ(old_snapshot.StateName(old_snapshot.NumStates() - 1), "u");
+  EXPECT_DOUBLE_EQ(old_snapshot.TransitionProbability(*old_snapshot.FindState("x"), *old_snapshot.FindState("y")),
+                   large.TransitionProbability("x", "y"));
+
+  const MarkovSnapshot new_snapshot = MarkovSnapshot::Open(path);
+  EXPECT_EQ(new_snapshot.NumStates(), small.NumStates());
+  EXPECT_FALSE(new_snapshot.FindState("x").has_value());
+
+  std::remove(path.c_str());
+}
+
+namespace {
+
+ptm::CsrTransitions CountsFromEdges(std::uint32_t num_states,
+                                    std::initializer_list<std::tuple<std::uint32_t, std::uint32_t, std::size_t>> edges) {
+  ptm::TransitionAccumulator pending;
+  for (const auto& [from, to, count] : edges) {
+    pending.Add(from, to, count);
+  }
+  ptm::CsrTransitions csr;
+  pending.FlushInto(csr, num_states);
+  return csr;
+}
+
+} // namespace
+
+TEST(ChainAnalysisTest, StationaryAndNStepDistributions) {
+  using namespace ptm;
+
+  // P = [[1/2, 1/2, 0], [1/4, 1/2, 1/4], [0, 1/2, 1/2]], pi = (1/4, 1/2, 1/4)
+  const auto csr = CountsFromEdges(3, {{0, 0, 1}, {0, 1, 1}, {1, 0, 1}, {1, 1, 2}, {1, 2, 1}, {2, 1, 1}, {2, 2, 1}});
+  const TransitionOperator op(csr);
+
+  const std::vector<double> e0 = {1, 0, 0};
+  const auto two_steps = Propagate(op, e0, 2);
+  EXPECT_DOUBLE_EQ(two_steps[0], 0.375);
+  EXPECT_DOUBLE_EQ(two_steps[1], 0.5);
+  EXPECT_DOUBLE_EQ(two_steps[2], 0.125);
+
+  const auto stationary = StationaryDistribution(op);
+  ASSERT_TRUE(stationary.converged);
+  EXPECT_NEAR(stationary.distribution[0], 0.25, 1e-10);
+  EXPECT_NEAR(stationary.distribution[1], 0.5, 1e-10);
+  EXPECT_NEAR(stationary.distribution[2], 0.25, 1e-10);
+
+  // TV(e_0 P^t, pi) = 0.75 * 2^-t (собственное число 1/2): впервые <= 0.05 при t = 4
+  const std::vector<std::uint32_t> starts = {0, 2};
+  EXPECT_EQ(MixingTime(op, stationary.distribution, starts, 0.05), 4U);
+  EXPECT_FALSE(MixingTime(op, stationary.distribution, starts, 0.05, 3).has_value());
+
+  // Периодическая цепь 0 <-> 1: степенной метод по ленивой цепи всё равно сходится
+  const TransitionOperator flip(CountsFromEdges(2, {{0, 1, 1}, {1, 0, 1}}));
+  const auto flip_pi = StationaryDistribution(flip);
+  EXPECT_TRUE(flip_pi.converged);
+  EXPECT_NEAR(flip_pi.distribution[0], 0.5, 1e-12);
+
+  EXPECT_THROW(Propagate(op, std::vector<double>{1, 0}, 1), std::invalid_argument);
+}
+
+TEST(ChainAnalysisTest, CommunicatingClassesAndAbsorbingStates) {
+  using namespace ptm;
+
+  // {0, 1} - невозвратный класс, {2, 3} - тоже невозвратный (ребро 3 -> 5), 4 - поглощающее с петлёй, 5 - тупик
+  const auto csr = CountsFromEdges(
+      6, {{0, 1, 1}, {1, 0, 1}, {1, 2, 1}, {2, 3, 1}, {3, 2, 1}, {0, 4, 1}, {4, 4, 3}, {3, 5, 1}, {2, 2, 1}});
+  const auto structure = AnalyzeStructure(csr);
+
+  ASSERT_EQ(structure.NumClasses(), 4U);
+  EXPECT_FALSE(structure.IsIrreducible());
+  EXPECT_EQ(structure.component[0], structure.component[1]);
+  EXPECT_EQ(structure.component[2], structure.component[3]);
+  EXPECT_NE(structure.component[0], structure.component[2]);
+  EXPECT_FALSE(structure.closed[structure.component[0]]);
+  EXPECT_FALSE(structure.closed[structure.component[2]]); // 3 -> 5 выводит из класса
+  EXPECT_TRUE(structure.closed[structure.component[4]]);
+  EXPECT_TRUE(structure.closed[structure.component[5]]);
+  EXPECT_EQ(structure.absorbing, (std::vector<std::uint32_t>{4, 5}));
+}
+
+TEST(ChainAnalysisTest, WordChainAnalyticsAreThreadIndependent) {
+  using namespace ptm;
+
+  MarkovTextModel model(MarkovTextModel::TokenLevel::Word);
+  model.TrainFromFile("war_and_peace.txt");
+  const TransitionOperator op(model.Chain().Transitions());
+
+  const auto one = StationaryDistribution(op, 1e-9, 5000, 1);
+  const auto four = StationaryDistribution(op, 1e-9, 5000, 4);
+  ASSERT_TRUE(one.converged);
+  EXPECT_EQ(one.distribution, four.distribution);
+  EXPECT_EQ(one.iterations, four.iterations);
+
+  double mass = 0;
+  for (double p : one.distribution) {
+    mass += p;
+  }
+  EXPECT_NEAR(mass, 1.0, 1e-12);
+  // Стационарная масса следует частотам слов: "the" встречается чаще "of"
+  const auto& chain = model.Chain();
+  EXPECT_GT(one.distribution[*chain.FindState("the")], one.distribution[*chain.FindState("of")]);
+
+  const auto structure = AnalyzeStructure(chain.Transitions());
+  EXPECT_GE(structure.NumClasses(), 1U);
+}
+
+TEST(MarkovChainTest, GenerateBatchIsPerSequenceReproducible) {
+  using namespace ptm;
+
+  MarkovChain chain;
+  chain.Train({"a", "b", "a", "c", "b", "a", "b", "c", "c", "a", "end"});
+
+  // Несколько сотен стартов - несколько задач по kSequencesPerTask, так что потоки работают одновременно
+  std::vector<MarkovChain::StateId> starts(500);
+  for (std::size_t s = 0; s < starts.size(); ++s) {
+    starts[s] = static_cast<MarkovChain::StateId>(s % 4);
+  }
+  constexpr std::size_t kLength = 30;
+  const StreamKey key{42, 7};
+
+  std::vector<MarkovChain::StateId> one(starts.size() * kLength);
+  std::vector<std::size_t> one_lengths(starts.size());
+  chain.GenerateBatch(starts, kLength, key, one, one_lengths, 1);
+
+  std::vector<MarkovChain::StateId> many(starts.size() * kLength);
+  std::vector<std::size_t> many_lengths(starts.size());
+  for (std::size_t threads : {3u, 4u, 8u}) {
+    std::fill(many.begin(), many.end(), 0);
+    chain.GenerateBatch(starts, kLength, key, many, many_lengths, threads);
+    EXPECT_EQ(one, many);
+    EXPECT_EQ(one_lengths, many_lengths);
+  }
+
+  // Последовательность s - та же, что GenerateIds со своим потоком BlockRng(key, s)
+  for (std::size_t s = 0; s < starts.size(); ++s) {
+    Philox4x32 rng = BlockRng(key, static_cast<std::uint32_t>(s));
+    std::vector<MarkovChain::StateId> expected;
+    chain.GenerateIds(starts[s], kLength, rng, expected);
+    ASSERT_EQ(one_lengths[s], expected.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), one.begin() + static_cast<std::ptrdiff_t>(s * kLength)));
+  }
+  // Из "end" переходов нет
+  EXPECT_EQ(one_lengths[3], 1U);
+
+  std::vector<MarkovChain::StateId> small(kLength);
+  EXPECT_THROW(chain.GenerateBatch(starts, kLength, key, small, one_lengths), std::invalid_argument);
+  const std::vector<MarkovChain::StateId> bad_start = {99};
+  std::vector<std::size_t> bad_length(1);
+  EXPECT_THROW(chain.GenerateBatch(bad_start, kLength, key, small, bad_length), std::invalid_argument);
+}
+
+TEST(MarkovTextModelTest, GenerateTextIntoAppendsSameText) {
+  using namespace ptm;
+
+  const std::string text = "The cat (a grey one) sat. The dog, however, didn't sit: it ran! Then the cat ran too.";
+  for (std::size_t order : {1, 2}) {
+    MarkovTextModel model(MarkovTextModel::TokenLevel::Word, order);
+    model.TrainFromText(text);
+
+    std::mt19937 rng_a(5);
+    std::mt19937 rng_b(5);
+    const std::string expected = model.GenerateText(60, rng_a, "THE");
+
+    std::string out = "prefix:";
+    model.GenerateTextInto(60, rng_b, "The", out);
+    EXPECT_EQ(out, "prefix:" + expected);
+    EXPECT_EQ(expected.rfind("the", 0), 0U);
+  }
+
+  // Уровень символов: текст - просто конкатенация токенов GenerateIds
+  MarkovTextModel chars(MarkovTextModel::TokenLevel::Character);
+  chars.TrainFromText(text);
+  std::mt19937 rng_a(6);
+  std::mt19937 rng_b(6);
+  std::vector<MarkovChain::StateId> ids;
+  chars.Chain().GenerateIds(*chars.Chain().FindState("c"), 80, rng_a, ids);
+  std::string joined;
+  for (auto id : ids) {
+    joined += chars.Chain().StateName(id);
+  }
+  std::string out;
+  chars.GenerateTextInto(80, rng_b, "c", out);
+  EXPECT_EQ(out, joined);
+
+  // Незнакомый старт - первый токен словаря
+  std::string fallback;
+  chars.GenerateTextInto(1, rng_b, "#", fallback);
+  EXPECT_EQ(fallback, "T");
+}
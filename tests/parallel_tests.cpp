@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "lib/parallel/ParallelFor.hpp"
+#include "lib/parallel/ThreadPool.hpp"
+
+TEST(ParallelTest, ParallelForVisitsEveryTaskOnce) {
+  using namespace ptm;
+
+  std::vector<std::atomic<int>> visits(1000);
+  ParallelFor(visits.size(), 8, [&](size_t i) { visits[i].fetch_add(1); });
+
+  for (const auto& v : visits) {
+    EXPECT_EQ(v.load(), 1);
+  }
+}
+
+TEST(ParallelTest, NestedParallelForDoesNotDeadlock) {
+  using namespace ptm;
+
+  std::atomic<size_t> total{0};
+  ParallelFor(16, 4, [&](size_t) { ParallelFor(16, 4, [&](size_t) { total.fetch_add(1); }); });
+
+  EXPECT_EQ(total.load(), 256u);
+}
+
+TEST(ParallelTest, ParallelForRethrowsException) {
+  using namespace ptm;
+
+  auto throwing = [](size_t i) {
+    if (i == 37) {
+      throw std::runtime_error("task failed");
+    }
+  };
+
+  EXPECT_THROW(ParallelFor(100, 4, throwing), std::runtime_error);
+  EXPECT_GE(ThreadPool::Shared().GetWorkerCount(), 3u);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "lib/distributions/NormalDistribution.hpp"
+#include "lib/random/Pcg64.hpp"
+#include "lib/random/Philox4x32.hpp"
+#include "lib/random/RngRef.hpp"
+#include "lib/random/Xoshiro256PlusPlus.hpp"
+
+// Эталоны - выход xoshiro256plusplus.c (Blackman, Vigna) для состояния {1, 2, 3, 4}
+TEST(RandomTest, XoshiroKnownAnswer) {
+  using namespace ptm;
+
+  Xoshiro256PlusPlus rng(std::array<std::uint64_t, 4>{1, 2, 3, 4});
+  const std::vector<std::uint64_t> expected = {
+      0x0000000002800001, 0x0000000003800067, 0x000cc00003800067, 0x000cc201994400b2, 0x8012a2019ac433cd,
+      0x8a69978acdee33ba, 0xc271134733154abd, 0xac2ba09179169e97, 0xdbf3190a8f073fd8, 0x9105f14ab2229220,
+  };
+  for (const std::uint64_t value : expected) {
+    EXPECT_EQ(rng(), value);
+  }
+}
+
+TEST(RandomTest, XoshiroJumpKnownAnswer) {
+  using namespace ptm;
+
+  Xoshiro256PlusPlus jumped(std::array<std::uint64_t, 4>{1, 2, 3, 4});
+  jumped.Jump();
+  const std::vector<std::uint64_t> after_jump = {0xec879073673df437, 0x20d212a39aca1eaa, 0xc19d712a27e40f57,
+                                                 0x6ff0e08dc71026a1};
+  for (const std::uint64_t value : after_jump) {
+    EXPECT_EQ(jumped(), value);
+  }
+
+  Xoshiro256PlusPlus long_jumped(std::array<std::uint64_t, 4>{1, 2, 3, 4});
+  long_jumped.LongJump();
+  const std::vector<std::uint64_t> after_long_jump = {0xb5c4ea370b330bf5, 0x5173cc693c0fa533, 0x1dc5df0151f7b491,
+                                                      0xe7b055cfeabc4661};
+  for (const std::uint64_t value : after_long_jump) {
+    EXPECT_EQ(long_jumped(), value);
+  }
+}
+
+TEST(RandomTest, PhiloxKnownAnswer) {
+  using namespace ptm;
+
+  // Тестовые векторы Random123 для philox4x32_10
+  auto zero = Philox4x32::Encrypt({0, 0, 0, 0}, {0, 0});
+  EXPECT_EQ(zero, (Philox4x32::Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+
+  auto ones = Philox4x32::Encrypt({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff});
+  EXPECT_EQ(ones, (Philox4x32::Block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+}
+
+TEST(RandomTest, PhiloxDiscardMatchesSequentialDraws) {
+  using namespace ptm;
+
+  Philox4x32 sequential(17, 3);
+  std::vector<std::uint64_t> values(11);
+  for (auto& v : values) {
+    v = sequential();
+  }
+
+  for (std::uint64_t skip = 0; skip < values.size(); ++skip) {
+    Philox4x32 jumped(17, 3);
+    jumped.Discard(skip);
+    EXPECT_EQ(jumped.GetPosition(), skip);
+    EXPECT_EQ(jumped(), values[skip]);
+  }
+}
+
+// Эталоны - выход pcg-c (pcg64_srandom_r(42, 54), как в pcg64-demo) и тот же поток после сдвига
+// на floor(2^128 / phi) шагов - jumped() в numpy
+TEST(RandomTest, PcgKnownAnswer) {
+  using namespace ptm;
+
+  Pcg64 rng(42, 54);
+  const std::vector<std::uint64_t> expected = {0x86b1da1d72062b68, 0x1304aa46c9853d39, 0xa3670e9e0dd50358,
+                                               0xf9090e529a7dae00, 0xc85b9fd837996f2c, 0x606121f8e3919196};
+  for (const std::uint64_t value : expected) {
+    EXPECT_EQ(rng(), value);
+  }
+}
+
+TEST(RandomTest, PcgJumpKnownAnswer) {
+  using namespace ptm;
+
+  Pcg64 rng(42, 54);
+  rng.Jump();
+  const std::vector<std::uint64_t> expected = {0x9c88afb54e1b6aaf, 0xba921a8fc054493d, 0xf6e782e1f5bbd2f9,
+                                               0x655575601d003a35};
+  for (const std::uint64_t value : expected) {
+    EXPECT_EQ(rng(), value);
+  }
+}
+
+TEST(RandomTest, PcgAdvanceMatchesSteps) {
+  using namespace ptm;
+
+  Pcg64 stepped(2024, 5);
+  Pcg64 advanced(2024, 5);
+
+  for (int i = 0; i < 1000; ++i) {
+    stepped();
+  }
+  advanced.Advance({0, 1000});
+
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(stepped(), advanced());
+  }
+}
+
+TEST(RandomTest, SplitGivesDistinctStreams) {
+  using namespace ptm;
+
+  auto check = [](auto master) {
+    auto a = master.Split();
+    auto b = master.Split();
+    int equal = 0;
+    for (int i = 0; i < 100; ++i) {
+      equal += a() == b() ? 1 : 0;
+    }
+    EXPECT_EQ(equal, 0);
+  };
+
+  check(Xoshiro256PlusPlus(1));
+  check(Pcg64(1));
+  check(Philox4x32(1));
+}
+
+TEST(RandomTest, RngRefKeepsMt19937UniformSequence) {
+  using namespace ptm;
+
+  std::mt19937 direct(5);
+  std::mt19937 wrapped(5);
+  RngRef ref(wrapped);
+
+  for (int i = 0; i < 100; ++i) {
+    const double expected = (static_cast<double>(direct()) + 0.5) / (static_cast<double>(direct.max()) + 1);
+    EXPECT_EQ(ref.NextUniform(), expected);
+  }
+}
+
+TEST(RandomTest, DistributionsAcceptAnyEngine) {
+  using namespace ptm;
+
+  NormalDistribution nd(2.0, 1.5, NormalDistribution::Method::Ziggurat);
+  Xoshiro256PlusPlus xoshiro(1);
+  Pcg64 pcg(2);
+  Philox4x32 philox(3);
+  std::mt19937_64 mt64(4);
+
+  auto mean_of = [&](RngRef rng) {
+    std::vector<double> samples(100000);
+    nd.SampleN(samples, rng);
+    double sum = 0;
+    for (double x : samples) {
+      sum += x;
+    }
+    return sum / static_cast<double>(samples.size());
+  };
+
+  EXPECT_NEAR(mean_of(xoshiro), 2.0, 0.03);
+  EXPECT_NEAR(mean_of(pcg), 2.0, 0.03);
+  EXPECT_NEAR(mean_of(philox), 2.0, 0.03);
+  EXPECT_NEAR(mean_of(mt64), 2.0, 0.03);
+
+  for (int i = 0; i < 1000; ++i) {
+    const double u = RngRef(pcg).NextUniform();
+    EXPECT_GT(u, 0.0);
+    EXPECT_LT(u, 1.0);
+  }
+}
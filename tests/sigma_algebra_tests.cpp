@@ -1,8 +1,20 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include "lib/sigma-algebra/CompiledMeasure.hpp"
 #include "lib/sigma-algebra/DiscreteRandomVariable.hpp"
 #include "lib/sigma-algebra/Event.hpp"
+#include "lib/sigma-algebra/EventSet.hpp"
+#include "lib/sigma-algebra/IndexedMeasure.hpp"
 #include "lib/sigma-algebra/OutcomeSpace.hpp"
 #include "lib/sigma-algebra/ProbabilityMeasure.hpp"
 #include "lib/sigma-algebra/SigmaAlgebra.hpp"
@@ -153,4 +165,447 @@ TEST(SigmaAlgebraTest, Generate_FromSingleGenerator) {
   }
   EXPECT_TRUE(hasA);
   EXPECT_TRUE(hasAc);
-}
\ No newline at end of file
+}
+
+TEST(SigmaAlgebraTest, EventWordsMatchMaskAcrossInlineAndHeapSizes) {
+  using namespace ptm;
+
+  for (std::size_t n : {0u, 1u, 63u, 64u, 65u, 256u, 257u, 1000u}) {
+    std::vector<bool> ma(n, false), mb(n, false);
+    for (std::size_t i = 0; i < n; ++i) {
+      ma[i] = i % 3 == 0;
+      mb[i] = i % 5 == 1;
+    }
+    const Event a(ma);
+    const Event b(mb);
+
+    EXPECT_EQ(a.GetSize(), n);
+    EXPECT_EQ(a.GetMask(), ma);
+    EXPECT_EQ(a.Words().size(), (n + 63) / 64);
+
+    const Event u = Event::Unite(a, b);
+    const Event x = Event::Intersect(a, b);
+    const Event c = Event::Complement(a);
+    std::size_t count_a = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(u.Contains(i), ma[i] || mb[i]);
+      EXPECT_EQ(x.Contains(i), ma[i] && mb[i]);
+      EXPECT_EQ(c.Contains(i), !ma[i]);
+      count_a += ma[i] ? 1 : 0;
+    }
+    EXPECT_EQ(a.Count(), count_a);
+    EXPECT_EQ(c.Count(), n - count_a);
+
+    // Хвост последнего слова не заполняется: дополнение полного - пустое
+    EXPECT_EQ(Event::Full(n).Count(), n);
+    EXPECT_EQ(Event::Complement(Event::Full(n)), Event::Empty(n));
+    EXPECT_EQ(Event::Complement(c), a);
+    EXPECT_FALSE(a.Contains(n));
+  }
+}
+
+TEST(SigmaAlgebraTest, EventSetBitIterationAndUpdates) {
+  using namespace ptm;
+
+  Event e(300);
+  EXPECT_TRUE(e.IsEmpty());
+  for (std::size_t id : {299u, 0u, 64u, 128u, 63u}) {
+    e.Insert(id);
+  }
+  e.Erase(128);
+
+  std::vector<OutcomeSpace::OutcomeId> ids;
+  e.ForEachSetBit([&](OutcomeSpace::OutcomeId id) { ids.push_back(id); });
+  EXPECT_EQ(ids, (std::vector<OutcomeSpace::OutcomeId>{0, 63, 64, 299}));
+  EXPECT_EQ(e.Count(), 4u);
+  EXPECT_FALSE(e.IsEmpty());
+  EXPECT_THROW(e.Insert(300), std::out_of_range);
+
+  // Разные размеры Ω - разные события, даже при одинаковых исходах
+  EXPECT_FALSE(Event::Empty(3) == Event::Empty(4));
+  EXPECT_EQ(Event::Unite(Event::Full(3), Event::Full(300)), Event::Full(3));
+}
+
+TEST(SigmaAlgebraTest, ProbabilityIgnoresOutcomesOutsideMeasure) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 300; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  ProbabilityMeasure P(omega);
+  for (std::size_t i = 0; i < 300; ++i) {
+    P.SetAtomicProbability(i, 1.0 / 300.0);
+  }
+
+  Event e(400);
+  e.Insert(0);
+  e.Insert(299);
+  e.Insert(350);
+  EXPECT_NEAR(P.Probability(e), 2.0 / 300.0, 1e-12);
+  EXPECT_NEAR(P.Probability(Event::Full(300)), 1.0, 1e-12);
+}
+
+TEST(SigmaAlgebraTest, Generate_StoresAtomPartition) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 6; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+
+  // A = {0,1,2}, B = {2,3}: атомы {0,1}, {2}, {3}, {4,5}
+  Event A(6);
+  Event B(6);
+  for (std::size_t id : {0u, 1u, 2u}) A.Insert(id);
+  for (std::size_t id : {2u, 3u}) B.Insert(id);
+
+  const auto F = SigmaAlgebra::Generate(omega, {A, B});
+  ASSERT_EQ(F.NumAtoms(), 4u);
+  EXPECT_EQ(F.AtomOf(0), F.AtomOf(1));
+  EXPECT_EQ(F.AtomOf(4), F.AtomOf(5));
+  EXPECT_NE(F.AtomOf(2), F.AtomOf(3));
+  EXPECT_EQ(F.AtomOf(6), std::nullopt);
+  EXPECT_EQ(F.Atom(*F.AtomOf(4)).GetMask(), (std::vector<bool>{false, false, false, false, true, true}));
+  EXPECT_THROW((void)F.AtomOutcomes(4), std::out_of_range);
+
+  EXPECT_TRUE(F.IsMeasurable(A));
+  EXPECT_TRUE(F.IsMeasurable(Event::Complement(Event::Unite(A, B))));
+  Event half(6);
+  half.Insert(0);
+  EXPECT_FALSE(F.IsMeasurable(half));
+  EXPECT_FALSE(F.IsMeasurable(Event::Full(5)));
+
+  // Перечисление даёт все 2^4 различных измеримых события
+  std::vector<Event> seen;
+  SigmaAlgebra::EventEnumerator it(F);
+  EXPECT_TRUE(it.Current().IsEmpty());
+  do {
+    EXPECT_TRUE(F.IsMeasurable(it.Current()));
+    for (const auto& e : seen) {
+      EXPECT_FALSE(e == it.Current());
+    }
+    seen.push_back(it.Current());
+  } while (it.Next());
+  EXPECT_EQ(seen.size(), 16u);
+  EXPECT_FALSE(it.Next());
+  EXPECT_EQ(F.GetEvents().size(), 16u);
+}
+
+TEST(SigmaAlgebraTest, Generate_ManyAtomsWithoutEnumeration) {
+  using namespace ptm;
+
+  constexpr std::size_t n = 1000;
+  OutcomeSpace omega;
+  for (std::size_t i = 0; i < n; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+
+  // Генератор j - исходы с j-м битом номера: каждый исход < 1024 - отдельный атом
+  std::vector<Event> generators(10, Event(n));
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < generators.size(); ++j) {
+      if ((i >> j) & 1) {
+        generators[j].Insert(i);
+      }
+    }
+  }
+
+  const auto F = SigmaAlgebra::Generate(omega, generators);
+  EXPECT_EQ(F.NumAtoms(), n);
+  EXPECT_TRUE(F.IsSigmaAlgebra());
+  EXPECT_TRUE(F.IsMeasurable(generators[3]));
+  EXPECT_THROW((void)F.GetEvents(), std::runtime_error);
+
+  // Явное семейство тоже знает атомы σ(events)
+  const SigmaAlgebra explicit_family(omega, {generators[0], generators[1]});
+  EXPECT_EQ(explicit_family.NumAtoms(), 4u);
+  EXPECT_FALSE(explicit_family.IsSigmaAlgebra());
+}
+
+TEST(SigmaAlgebraTest, EventSetFindsFirstEqualEvent) {
+  using namespace ptm;
+
+  std::vector<Event> events = {Event::Empty(70), Event::Full(70), Event::Empty(70), Event::Full(3)};
+  events[2].Insert(69);
+  const std::vector<Event> copy = events;
+  const EventSet set(events);
+
+  EXPECT_EQ(set.Size(), 4u);
+  EXPECT_EQ(set.Find(Event::Full(70)), std::optional<std::size_t>(1));
+  EXPECT_EQ(set.Find(copy[2]), std::optional<std::size_t>(2));
+  EXPECT_EQ(set.Find(Event::Full(3)), std::optional<std::size_t>(3));
+  EXPECT_FALSE(set.Contains(Event::Empty(3)));
+  EXPECT_EQ(Event::Full(70).Hash(), events[1].Hash());
+
+  const std::vector<Event> repeated = {Event::Full(5), Event::Empty(5), Event::Full(5)};
+  const EventSet dedup(repeated);
+  EXPECT_EQ(dedup.Size(), 2u);
+  EXPECT_EQ(dedup.Find(Event::Full(5)), std::optional<std::size_t>(0));
+}
+
+TEST(SigmaAlgebraTest, FindViolation_ReportsFirstMissingEvent) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 16; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  std::vector<Event> singletons;
+  for (std::size_t i = 0; i < 16; ++i) {
+    singletons.emplace_back(16);
+    singletons.back().Insert(i);
+  }
+
+  // Все 2^16 подмножеств Ω: проверяется по числу атомов, без перебора пар
+  std::vector<Event> events = SigmaAlgebra::Generate(omega, singletons).GetEvents();
+  ASSERT_EQ(events.size(), std::size_t{1} << 16);
+  EXPECT_TRUE(SigmaAlgebra(omega, events).IsSigmaAlgebra());
+
+  // Без одного события нет дополнения для другого
+  const Event removed = events[12345];
+  events.erase(events.begin() + 12345);
+  const SigmaAlgebra broken(omega, events);
+  const auto violation = broken.FindViolation(4);
+  ASSERT_TRUE(violation.has_value());
+  EXPECT_EQ(violation->kind, SigmaAlgebraViolation::Kind::MissingComplement);
+  EXPECT_EQ(Event::Complement(events[violation->first]), removed);
+
+  // {∅, Ω, A, Ac, B, Bc}: замкнуто по дополнению, но не по объединению
+  const Event A = singletons[0];
+  const Event B = singletons[1];
+  const SigmaAlgebra F(omega, {Event::Empty(16), Event::Full(16), A, Event::Complement(A), B, Event::Complement(B)});
+  for (std::size_t threads : {1u, 3u}) {
+    const auto v = F.FindViolation(threads);
+    ASSERT_TRUE(v.has_value());
+    EXPECT_EQ(v->kind, SigmaAlgebraViolation::Kind::MissingUnion);
+    EXPECT_EQ(v->first, 2u);
+    EXPECT_EQ(v->second, 4u);
+  }
+
+  const SigmaAlgebra wrong_size(omega, {Event::Empty(16), Event::Full(15)});
+  EXPECT_EQ(wrong_size.FindViolation()->kind, SigmaAlgebraViolation::Kind::WrongSize);
+  EXPECT_EQ(wrong_size.FindViolation()->first, 1u);
+  EXPECT_EQ(SigmaAlgebra(omega, {Event::Full(16)}).FindViolation()->kind,
+            SigmaAlgebraViolation::Kind::MissingEmpty);
+}
+
+TEST(SigmaAlgebraTest, ComputeAtomsMatchesOutcomeSignatures) {
+  using namespace ptm;
+
+  constexpr std::size_t n = 1000;
+  std::mt19937_64 rng(5);
+  std::vector<Event> generators;
+  // 150 генераторов - три блока по 64; часть генераторов над меньшим Ω
+  for (std::size_t g = 0; g < 150; ++g) {
+    const std::size_t size = g % 7 == 0 ? n / 2 + g : n;
+    generators.emplace_back(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      // Редкие генераторы, чтобы часть атомов была больше одного исхода
+      if (rng() % 64 == 0) {
+        generators.back().Insert(i);
+      }
+    }
+  }
+
+  const AtomPartition atoms = ComputeAtoms(n, generators);
+  ASSERT_EQ(atoms.atom_of.size(), n);
+
+  std::map<std::string, std::uint32_t> by_signature;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::string signature;
+    for (const auto& g : generators) {
+      signature.push_back(g.Contains(i) ? '1' : '0');
+    }
+    // Номера атомов - в порядке первого исхода
+    const auto [it, inserted] = by_signature.emplace(signature, static_cast<std::uint32_t>(by_signature.size()));
+    EXPECT_EQ(atoms.atom_of[i], it->second);
+  }
+  EXPECT_EQ(atoms.num_atoms, by_signature.size());
+  EXPECT_LT(atoms.num_atoms, n);
+
+  EXPECT_EQ(ComputeAtoms(0, generators).num_atoms, 0u);
+  EXPECT_EQ(ComputeAtoms(5, {}).atom_of, (std::vector<std::uint32_t>(5, 0)));
+  EXPECT_EQ(ComputeAtoms(5, {}).num_atoms, 1u);
+}
+
+TEST(SigmaAlgebraTest, CompiledMeasureMatchesProbability) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 1000; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  ProbabilityMeasure P(omega);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    P.SetAtomicProbability(i, static_cast<double>(i % 7 + 1) / 4000.0);
+  }
+  const CompiledMeasure compiled(P);
+  EXPECT_EQ(compiled.GetSize(), 1000u);
+
+  std::mt19937_64 rng(11);
+  std::vector<Event> events;
+  for (std::size_t k = 0; k < 100; ++k) {
+    // Разные размеры: меньше меры, равный и больше - исходы вне меры не считаются
+    events.emplace_back(k % 3 == 0 ? 700 : (k % 3 == 1 ? 1000 : 1300));
+    const std::uint64_t density = k % 5;
+    for (std::size_t i = 0; i < events.back().GetSize(); ++i) {
+      if (rng() % 4 < density) {
+        events.back().Insert(i);
+      }
+    }
+  }
+
+  std::vector<double> batch(events.size());
+  compiled.Probabilities(events, batch, 4);
+  for (std::size_t k = 0; k < events.size(); ++k) {
+    EXPECT_NEAR(batch[k], P.Probability(events[k]), 1e-12);
+    EXPECT_EQ(batch[k], compiled.Probability(events[k]));
+  }
+  EXPECT_NEAR(compiled.TotalMass(), P.Probability(Event::Full(1000)), 1e-12);
+
+  std::vector<double> wrong(3);
+  EXPECT_THROW(compiled.Probabilities(events, wrong), std::invalid_argument);
+}
+
+TEST(SigmaAlgebraTest, CompiledMeasureCompensatesManyTinyAtoms) {
+  using namespace ptm;
+
+  // 1 + 2^20 атомов по 1e-16: при обычном сложении слева направо каждый теряется в округлении
+  constexpr std::size_t n = (1u << 20) + 1;
+  std::vector<double> probs(n, 1e-16);
+  probs[0] = 1.0;
+  const CompiledMeasure compiled(probs);
+  const double expected = 1.0 + 1e-16 * static_cast<double>(n - 1);
+
+  double naive = 0.0;
+  for (double p : probs) {
+    naive += p;
+  }
+  EXPECT_EQ(naive, 1.0);
+
+  const Event full = Event::Full(n);
+  EXPECT_NEAR(compiled.Probability(full), expected, 1e-15);
+  EXPECT_NEAR(compiled.TotalMass(), expected, 1e-15);
+
+  // Без первого атома: каждое второе слагаемое
+  Event odd(n);
+  for (std::size_t i = 1; i < n; i += 2) {
+    odd.Insert(i);
+  }
+  const double p_odd = compiled.Probability(odd);
+  EXPECT_NEAR(p_odd, 1e-16 * static_cast<double>(n / 2), 1e-25);
+  // Результат не зависит от числа потоков
+  EXPECT_EQ(compiled.Probability(full, 3), compiled.Probability(full, 1));
+  EXPECT_EQ(compiled.Probability(odd, 3), p_odd);
+}
+
+TEST(SigmaAlgebraTest, IndexedMeasureUpdatesAndRanges) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 37; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  IndexedMeasure P(omega);
+  ProbabilityMeasure reference(omega);
+  EXPECT_EQ(P.TotalMass(), 0.0);
+  EXPECT_EQ(P.FindByCumulative(0.0), std::nullopt);
+
+  std::mt19937_64 rng(17);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  for (int step = 0; step < 2000; ++step) {
+    const std::size_t id = rng() % 37;
+    // Часть атомов обнуляется, чтобы проверить спуск мимо пустых поддеревьев
+    const double p = step % 5 == 0 ? 0.0 : uniform(rng) / 37.0;
+    P.SetAtomicProbability(id, p);
+    reference.SetAtomicProbability(id, p);
+  }
+
+  const auto probs = reference.AtomicProbabilities();
+  double total = 0.0;
+  for (double p : probs) {
+    total += p;
+  }
+  EXPECT_NEAR(P.TotalMass(), total, 1e-15);
+  EXPECT_EQ(P.IsValid(1e-9), reference.IsValid(1e-9));
+  // Узлы пересчитываются из детей: после обновлений дерево то же, что построенное заново
+  EXPECT_EQ(P.TotalMass(), IndexedMeasure(reference).TotalMass());
+
+  for (std::size_t first = 0; first <= 37; ++first) {
+    for (std::size_t last = first; last <= 40; ++last) {
+      double expected = 0.0;
+      for (std::size_t i = first; i < std::min<std::size_t>(last, 37); ++i) {
+        expected += probs[i];
+      }
+      EXPECT_NEAR(P.RangeProbability(first, last), expected, 1e-15);
+    }
+  }
+
+  Event e(37);
+  e.Insert(3);
+  e.Insert(36);
+  EXPECT_DOUBLE_EQ(P.Probability(e), reference.Probability(e));
+
+  EXPECT_THROW(P.SetAtomicProbability(37, 0.1), std::out_of_range);
+  EXPECT_THROW(P.SetAtomicProbability(0, -0.1), std::invalid_argument);
+  EXPECT_THROW(P.SetAtomicProbability(0, std::nan("")), std::invalid_argument);
+}
+
+TEST(SigmaAlgebraTest, IndexedMeasureInverseCdfAndSampling) {
+  using namespace ptm;
+
+  OutcomeSpace omega;
+  for (int i = 0; i < 6; ++i) {
+    omega.AddOutcome(std::to_string(i));
+  }
+  // p = (0, 0.25, 0, 0.5, 0.25, 0)
+  ProbabilityMeasure base(omega);
+  base.SetAtomicProbability(1, 0.25);
+  base.SetAtomicProbability(3, 0.5);
+  base.SetAtomicProbability(4, 0.25);
+  const IndexedMeasure P(base);
+  EXPECT_TRUE(P.IsValid(1e-12));
+
+  EXPECT_EQ(P.FindByCumulative(0.0), std::optional<OutcomeSpace::OutcomeId>(1));
+  EXPECT_EQ(P.FindByCumulative(0.2499), std::optional<OutcomeSpace::OutcomeId>(1));
+  EXPECT_EQ(P.FindByCumulative(0.25), std::optional<OutcomeSpace::OutcomeId>(3));
+  EXPECT_EQ(P.FindByCumulative(0.75), std::optional<OutcomeSpace::OutcomeId>(4));
+  // За границами [0, 1) - крайние исходы с ненулевой вероятностью
+  EXPECT_EQ(P.FindByCumulative(-1.0), std::optional<OutcomeSpace::OutcomeId>(1));
+  EXPECT_EQ(P.FindByCumulative(5.0), std::optional<OutcomeSpace::OutcomeId>(4));
+
+  std::mt19937_64 rng(23);
+  std::vector<std::size_t> counts(6, 0);
+  constexpr std::size_t kDraws = 100000;
+  for (std::size_t k = 0; k < kDraws; ++k) {
+    ++counts[*P.Sample(rng)];
+  }
+  EXPECT_EQ(counts[0] + counts[2] + counts[5], 0u);
+  EXPECT_NEAR(static_cast<double>(counts[1]) / kDraws, 0.25, 0.01);
+  EXPECT_NEAR(static_cast<double>(counts[3]) / kDraws, 0.5, 0.01);
+  EXPECT_NEAR(static_cast<double>(counts[4]) / kDraws, 0.25, 0.01);
+}
+
+TEST(SigmaAlgebraTest, MovedFromEventIsEmpty) {
+  using namespace ptm;
+
+  for (std::size_t n : {100u, 1000u}) {
+    Event source = Event::Full(n);
+    const Event moved(std::move(source));
+    EXPECT_EQ(moved.Count(), n);
+    // Перемещённое событие - пустое над пустым Ω
+    EXPECT_EQ(source.GetSize(), 0u);
+    EXPECT_TRUE(source.Words().empty());
+    EXPECT_FALSE(source.Contains(0));
+
+    Event target(5);
+    Event other = Event::Full(n);
+    target = std::move(other);
+    EXPECT_EQ(target, Event::Full(n));
+    EXPECT_EQ(other, Event::Empty(0));
+    other = Event::Complement(target);
+    EXPECT_EQ(other.GetSize(), n);
+    EXPECT_TRUE(other.IsEmpty());
+  }
+}